@@ -13,7 +13,8 @@
 #endif
 namespace Neopixel
 {
-DigitalRainAnimation::DigitalRainAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
+template <typename Layout>
+BasicDigitalRainAnimation<Layout>::BasicDigitalRainAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
     strip(strip),pixelLines(lines),rand(rand)
 {
     delay_ms    = decode_safe<uint16_t>(data,datasize,20);
@@ -24,46 +25,50 @@ DigitalRainAnimation::DigitalRainAnimation(LedStrip *strip, int datasize, void *
     color_value = decode_safe<int16_t>(data,datasize,255);
     head_length = decode_safe<int8_t>(data,datasize,3);
     longest_line = pixelLines->getLongestLine();
-    tail_length_min = decode_safe<uint8_t>(data,datasize,longest_line/3);
-    tail_length_max = decode_safe<uint8_t>(data,datasize,longest_line);
+    // tail lengths are Count wide on the wire
+    tail_length_min = decode_safe<Count>(data,datasize,longest_line/3);
+    tail_length_max = decode_safe<Count>(data,datasize,longest_line);
     tail_length_range = tail_length_max - tail_length_min;
     totalPixels   = pixelLines->getTotalPixelsCount();
     ESP_LOGI("drain", "delay %d, hue_min %d hue_max %d hue_inc %d hue_mode %d hlen %d tlen %d - %d",delay_ms, hue_min, hue_max, hue_inc, hue_mode, head_length, tail_length_min, tail_length_max);
 
-    auto [ptr,rsize]  = pixelLines->makeIndicesMatrix();
-    line_indices = ptr;
-    indices_row_size = rsize;
     hue = hue_min;
+    coords = BasicCoordMap<Layout>::acquire(pixelLines);
+    if (!coords) return;
+    line_indices = coords->row(0);
+    indices_row_size = coords->rowSize;
     createRainLines();
 }
-DigitalRainAnimation::~DigitalRainAnimation()
+template <typename Layout>
+BasicDigitalRainAnimation<Layout>::~BasicDigitalRainAnimation()
 {
     if (rain_lines) 
     {
-        delete[] rain_lines;
+        Mem::free(rain_lines);
         rain_lines = nullptr;
     }
-    if (line_indices) 
-    {
-        delete[] line_indices;
-        line_indices = nullptr;
-    }
+    BasicCoordMap<Layout>::release(coords);
+    coords = nullptr;
+    line_indices = nullptr;
 }
-void DigitalRainAnimation::createRainLines()
+template <typename Layout>
+void BasicDigitalRainAnimation<Layout>::createRainLines()
 {
     const size_t nLines = pixelLines->count;
-    rain_lines = new Line[nLines];
+    rain_lines = Mem::alloc<Line>(nLines, MemTag::DigitalRain);
+    if (!rain_lines) return;
     for (int i=0;i<nLines;++i)
     {
         restartLine(i);
     }
 }
-void DigitalRainAnimation::restartLine(int idx)
+template <typename Layout>
+void BasicDigitalRainAnimation<Layout>::restartLine(int idx)
 {
     auto & line = rain_lines[idx];
-    const auto pos = static_cast<uint8_t>(pixelLines->element[idx].count-1);
-    const auto tail_length = static_cast<uint8_t>( tail_length_min + rand->make_random()%tail_length_range);
-    const auto delay = static_cast<uint8_t>( rand->make_random()%longest_line);
+    const auto pos = static_cast<Offset>(pixelLines->element[idx].count-1);
+    const auto tail_length = static_cast<Offset>( tail_length_min + rand->make_random()%tail_length_range);
+    const auto delay = static_cast<Count>( rand->make_random()%longest_line);
 
     line.state = 0;
     line.position = pos;
@@ -71,35 +76,37 @@ void DigitalRainAnimation::restartLine(int idx)
     line.delay = delay;
     line.hue = hue = getNextHue(hue);
 }
-bool DigitalRainAnimation::drawLine(int idx)
+template <typename Layout>
+bool BasicDigitalRainAnimation<Layout>::drawLine(int idx)
 {
-    static constexpr auto zero = static_cast<int8_t>(0);
-    const auto *li = line_indices + idx*indices_row_size;
+    static constexpr auto zero = static_cast<Offset>(0);
+    const auto *li = line_indices + size_t(idx)*indices_row_size;
     auto & line = rain_lines[idx];
-    const int8_t line_size = pixelLines->element[idx].count;
+    const Offset line_size = pixelLines->element[idx].count;
     RGB white {255,255,color_value};
-    const int8_t hmin = max(line.position,zero);
-    const int8_t hmax = clamp(static_cast<int8_t>(line.position + head_length),zero,line_size);
+    const Offset hmin = max(line.position,zero);
+    const Offset hmax = clamp(static_cast<Offset>(line.position + head_length),zero,line_size);
     const auto cnt_white = hmax-hmin;
     if (cnt_white > 0) {
-        strip->fillPixelsRGB(li[hmin],cnt_white,white);
+        // lowest index of the head, reversed lines run down
+        strip->fillPixelsRGB(min(li[hmin],li[hmax-1]),cnt_white,white);
     }
-    const int8_t tstart = line.position + head_length;
-    const int8_t tend   = tstart + line.length;
-    const int8_t tmin = clamp(tstart,zero,line_size);
-    const int8_t tmax = clamp(tend,  zero,line_size);
+    const Offset tstart = line.position + head_length;
+    const Offset tend   = tstart + line.length;
+    const Offset tmin = clamp(tstart,zero,line_size);
+    const Offset tmax = clamp(tend,  zero,line_size);
 
-    int8_t toffset = tmin - tstart;
+    const Offset toffset = tmin - tstart;
     bool result = false;
     if (tmax > 0)
     {
         uint16_t dv = color_value / line.length;
         HSV tail_color {line.hue, 255, static_cast<uint8_t>(color_value - dv*toffset)};
-        for(int i=tmin;i<tmax;++i,++toffset)
-        {
-            strip->setPixelsHSV(li[i],1,&tail_color);
+        strip->scatter(li + tmin, tmax - tmin, [&](int) {
+            const RGB rgb = tail_color.toRGB();
             tail_color.v -= dv;
-        }
+            return rgb;
+        });
         result = true;
     }
     if (tmax >=0 && tmax < line_size) {
@@ -108,7 +115,8 @@ bool DigitalRainAnimation::drawLine(int idx)
     }
     return result;
 }
-int16_t DigitalRainAnimation::getNextHue(int16_t hue)
+template <typename Layout>
+int16_t BasicDigitalRainAnimation<Layout>::getNextHue(int16_t hue)
 {
     if (hue_mode != 2)
     {
@@ -144,9 +152,10 @@ int16_t DigitalRainAnimation::getNextHue(int16_t hue)
     }
     return hue;
 }
-void DigitalRainAnimation::step()
+template <typename Layout>
+void BasicDigitalRainAnimation<Layout>::step()
 {
-    for (int i=0; i<pixelLines->count; ++i)
+    for (Index i=0; i<pixelLines->count; ++i)
     {
         auto & line = rain_lines[i];
         if (0==line.state)
@@ -164,4 +173,6 @@ void DigitalRainAnimation::step()
     }
     strip->refresh(true);
 }
-}
\ No newline at end of file
+template class BasicDigitalRainAnimation<CompactLayout>;
+template class BasicDigitalRainAnimation<WideLayout>;
+}
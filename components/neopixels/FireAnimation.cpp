@@ -38,7 +38,8 @@ RGB HeatColor(uint8_t temperature)
         return {heatramp, 0, 0};
     }
 }
-FireAnimation::FireAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
+template <typename Layout>
+BasicFireAnimation<Layout>::BasicFireAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
     strip(strip),lines(lines),rand(rand)
 {
     delay_ms = decode<uint16_t>(data);
@@ -47,41 +48,44 @@ FireAnimation::FireAnimation(LedStrip *strip, int datasize, void *data, const St
     direction = decode<uint8_t>(data);
 
     totalPixels = strip->getLength();
-    heat = new uint8_t[totalPixels];
+    heat = Mem::alloc<uint8_t>(totalPixels, MemTag::Fire);
     memset(heat,0,totalPixels*sizeof(uint8_t));
     ESP_LOGI("Fire-animation", "Fire animation : delay %d cooling %d sparking %d direction %d", delay_ms, cooling, sparking, direction);
 }
-FireAnimation::~FireAnimation()
+template <typename Layout>
+BasicFireAnimation<Layout>::~BasicFireAnimation()
 {
-    delete[] heat;
+    Mem::free(heat);
     heat = nullptr;
 }
-void FireAnimation::step()
+template <typename Layout>
+void BasicFireAnimation<Layout>::step()
 {
-    for (int i=0;i<lines->count;++i)
+    for (typename Layout::Index i=0;i<lines->count;++i)
     {
         processSingleStrip(lines->element[i]);
     }
     // Map from heat cells to LED colors
-    for( int j = 0; j < totalPixels; j++) 
-    {
-        strip->fillPixelsRGB(j, 1, HeatColor(heat[j]));
-    }
+    strip->transform(0, int(totalPixels), [this](int j) { return HeatColor(heat[j]); });
     strip->refresh();
 }
-void FireAnimation::processSingleStrip(const Subset &s)
+template <typename Layout>
+void BasicFireAnimation<Layout>::processSingleStrip(const Subset &s)
 {
     const auto length = s.count;
     const uint8_t cooling_factor = (cooling*10) / length + 2;
 
-    const auto first =  direction ? s.first : s.first + length - 1;
-    const auto inc   =  direction ? s.dir : -(s.dir);
-    const auto last  = !direction ? s.first : s.first + length - 1;
-    const auto rinc  = !direction ? s.dir : -(s.dir);
-    
+    // ends of the line in line order, reversed lines start at their last index
+    const int start = s.dir < 0 ? s.first + length - 1 : s.first;
+    const int end   = start + s.dir * (int(length) - 1);
+    // the fire rises from first to last, inc steps up the flame
+    const int first = direction ? start : end;
+    const int last  = direction ? end : start;
+    const int inc   = direction ? s.dir : -s.dir;
+
     uint32_t rnd = 0;
     // Step 1.  Cool down every cell
-    for(int i=0,idx=first;i<length;++i,idx+=inc)
+    for(int i=0,idx=first;i<int(length);++i,idx+=inc)
     {
         if (0==rnd) rnd = rand->make_random();
         heat[idx] = saturated_sub(heat[idx], uint8_t((rnd&0xFF) % cooling_factor));
@@ -89,9 +93,9 @@ void FireAnimation::processSingleStrip(const Subset &s)
     }
 
     // Step 2.  Heat from each cell drifts 'up' and diffuses a little
-    for(int k=length-1,idx=last; k >= 2; k--,idx+=rinc)
+    for(int k=length-1,idx=last; k >= 2; k--,idx-=inc)
     {
-        heat[idx] = (heat[idx - 1] + heat[idx - 2] + heat[idx - 2] ) / 3;
+        heat[idx] = (heat[idx - inc] + heat[idx - 2*inc] + heat[idx - 2*inc] ) / 3;
     }
 
     // Step 3.  Randomly ignite new 'sparks' of heat near the bottom
@@ -99,12 +103,14 @@ void FireAnimation::processSingleStrip(const Subset &s)
     if( (rnd&0xFF) < sparking ) 
     {
         rnd >>= 8;
-        const uint16_t pos = uint16_t(rnd&0xFFFF) % length;
-        const uint16_t idx = first + inc*pos;
+        const typename Layout::Index pos = uint16_t(rnd&0xFFFF) % length;
+        const typename Layout::Index idx = first + inc*pos;
         rnd >>= 16;
         const uint8_t const_add = 160;
         const uint8_t random_add = 255-const_add;
         heat[idx] = saturated_add( heat[idx], uint8_t(const_add + uint8_t(rnd&0xFF)%random_add));
     }
 }
+template class BasicFireAnimation<CompactLayout>;
+template class BasicFireAnimation<WideLayout>;
 }
@@ -1,5 +1,7 @@
 #include <cstdint>
 #include <color.hpp>
+#include <decay_field.hpp>
+#include <painter.hpp>
 #include <led_strip.hpp>
 #include <collections.hpp>
 #include <utils.hpp>
@@ -46,7 +48,7 @@ Particle* Particle::load(void*& data, int& datasize)
     return nullptr;
 }
 ParticleAnimation::ParticleAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
-    strip(strip),lines(lines),rand(rand)
+    strip(strip),lines(lines),coords(CoordMap::acquire(lines)),rand(rand)
 {
     totalPixels = strip->getLength();
     ms_to_fade = 0;
@@ -58,8 +60,10 @@ ParticleAnimation::ParticleAnimation(LedStrip *strip, int datasize, void *data,
 
     hue_shift = decode<uint8_t>(data);
     n_particles = decode<uint8_t>(data);    
-    particles = new Particle*[n_particles];
+    particles = Mem::alloc<Particle*>(n_particles, MemTag::Particles);
+    field.init(totalPixels, fading_factor, MemTag::Particles);
     datasize -= 7;
+    if (!valid()) n_particles = 0;
 
     for (int i=0;i<n_particles;++i)
     {
@@ -78,16 +82,22 @@ ParticleAnimation::ParticleAnimation(LedStrip *strip, int datasize, void *data,
     
     ESP_LOGI("LissajousAnimation", "LissajousAnimation : delay %d fade_delay %d", delay_ms, fade_delay_ms);
 }
+bool ParticleAnimation::valid() const
+{
+    return coords && particles && field.size();
+}
 ParticleAnimation::~ParticleAnimation()
 {
     for (int i=0;i<n_particles;++i){
         delete particles[i];
     }
-    delete[] particles;
+    Mem::free(particles);
+    CoordMap::release(coords);
 }
 LissajousParticle* LissajousParticle::load(void*& data)
 {
     auto ptr = new LissajousParticle;
+    if (!ptr) return nullptr;
     auto & p = *ptr;
     p.draw_mode = decode<uint8_t>(data);
     p.center_x  = decode<uint16_t>(data);
@@ -135,6 +145,7 @@ LissajousParticle::~LissajousParticle()
 PolarParticle* PolarParticle::load(void*& data)
 {
     auto ptr = new PolarParticle;
+    if (!ptr) return nullptr;
     auto & p = *ptr;
     p.draw_mode= decode<uint8_t>(data);
     p.center_x = decode<uint16_t>(data);
@@ -165,12 +176,11 @@ PolarParticle::~PolarParticle()
 }
 void ParticleAnimation::step()
 {
-    auto * pixels = strip->getBuffer();
     ms_to_fade += delay_ms;
     if (ms_to_fade > fade_delay_ms)
     {
         ms_to_fade = 0;
-        fade_all(pixels, totalPixels, fading_factor);
+        field.tick();
     }
 
     int16_t ymax = makeFixpoint88(nmax,0);
@@ -181,41 +191,29 @@ void ParticleAnimation::step()
         auto [x,y,hue] = particles[i]->update(1,rand);
         if (x < 0 || y < 0 || x > xmax || y > ymax) continue;
 
-        InterpolatedPoint ip;
-
+        hue = hue >> hue_shift;
+        HSV hsv {hue,255,0};
+        auto plot = [&](auto idx, uint32_t value) {
+            hsv.v = uint8_t(min(value, 255u));
+            field.set(idx, sat_add(field.get(idx), hsv.toRGB()));
+        };
         switch (particles[i]->draw_mode) 
         {
             case 0:
-                ip = lines->getPoint2D(x,y,nmax);
+                Painter(coords).point(x, y, plot);
                 break;
             case 1:
             case 2:
             {
                 auto [xi,xs] = splitFixpoint88(x);
-                auto [i00,i01,v0] = Strips::getPoint1D(y,nmax,lines->element[xi]);
-                ip.idx[0] = i00;
-                ip.value[0] = 255-v0;
-                ip.n_points = 1;
-                if (1==particles[i]->draw_mode) break;
-                if (v0 > 0)
-                {
-                    ip.idx[1] = i01;
-                    ip.value[1] = v0;
-                    ++ip.n_points;
-                }
+                auto [i00,i01,v0] = coords->getPoint1D(y,xi);
+                plot(i00, 255-v0);
+                if (2==particles[i]->draw_mode && v0 > 0) plot(i01, v0);
                 break;
             }
         }
-        hue = hue >> hue_shift;
-        HSV hsv {hue,255,0};
-
-        for (int j=0;j<ip.n_points;++j)
-        {
-            hsv.v = ip.value[j];
-            auto & px = pixels[ip.idx[j]];
-            px = sat_add(px, hsv.toRGB());
-        }
     }
+    field.render(strip);
     strip->refresh();
 }
 }
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <algorithm>
 #include <color.hpp>
 #include <led_strip.hpp>
 #include <collections.hpp>
@@ -13,7 +14,8 @@
 
 namespace Neopixel
 {
-RandomWalkAnimation::RandomWalkAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
+template <typename Layout>
+BasicRandomWalkAnimation<Layout>::BasicRandomWalkAnimation(LedStrip *strip, int datasize, void *data, const Strips* lines, RandomGenerator* rand) : 
     strip(strip),lines(lines),rand(rand)
 {
     delay_ms      = decode_safe<uint16_t>(data,datasize,1000);
@@ -23,29 +25,24 @@ RandomWalkAnimation::RandomWalkAnimation(LedStrip *strip, int datasize, void *da
     hue_inc       = decode_safe<int8_t>(data,datasize,10);
     hue_wrap      = decode_safe<uint8_t>(data,datasize,0);
     hue_fade      = decode_safe<uint8_t>(data,datasize,200);
-    //neighbours    = NeighboursMatrix::fromStrips(lines);
     totalPixels   = lines->getTotalPixelsCount();
+    // on the creating task, the map registry and the neighbour table are not locked
+    initNeighboursMatrix();
     ESP_LOGI("rwanim", "delay %d, fade delay %d",delay_ms, fade_delay_ms);
     ESP_LOGI("rwanim", "hue min %d max %d inc %d wrap %d", hue_min, hue_max, hue_inc, hue_wrap);
-    brightness    = new uint8_t[totalPixels];
-    std::fill(brightness,brightness+totalPixels,0);
+    field.init(totalPixels, hue_fade, MemTag::RandomWalk);
     current_position = rand->make_random() % totalPixels;
     current_hue = hue_min;
 }
-RandomWalkAnimation::~RandomWalkAnimation()
+template <typename Layout>
+BasicRandomWalkAnimation<Layout>::~BasicRandomWalkAnimation()
 {
-    if (neighbours != nullptr) 
-    {
-        release(neighbours);
-        neighbours = nullptr;
-    }
-    if (brightness)
-    {
-        delete[] brightness;
-        brightness = nullptr;
-    }
+    BasicCoordMap<Layout>::release(coords);
+    coords = nullptr;
+    neighbours = nullptr;
 }
-int16_t RandomWalkAnimation::getNextHue(int16_t hue)
+template <typename Layout>
+int16_t BasicRandomWalkAnimation<Layout>::getNextHue(int16_t hue)
 {
     hue += hue_inc;
     if (hue < hue_min)
@@ -74,14 +71,15 @@ int16_t RandomWalkAnimation::getNextHue(int16_t hue)
     }
     return hue;
 }
-void RandomWalkAnimation::setCurrentPixel(uint16_t idx, uint16_t hue)
+template <typename Layout>
+void BasicRandomWalkAnimation<Layout>::setCurrentPixel(Index idx, uint16_t hue)
 {
     current_position = idx;
     HSV hsv {hue,255,255};
-    strip->setPixelsHSV(current_position,1,&hsv);
-    brightness[current_position] = 255;
+    field.set(current_position, hsv.toRGB());
 }
-uint16_t RandomWalkAnimation::calcNextPosition()
+template <typename Layout>
+typename Layout::Index BasicRandomWalkAnimation<Layout>::calcNextPosition()
 {
     //char txt_neighbours[32];
     //char txt_brightnes[32];
@@ -98,7 +96,7 @@ uint16_t RandomWalkAnimation::calcNextPosition()
     uint16_t acc_prob = 0;
     for (uint16_t i=0;i < ne.count;++i)
     {
-        acc_prob += 255 - brightness[ ne.index[i] ];
+        acc_prob += 255 - field.level( ne.index[i] );
         prob[i] = acc_prob;
     }
     /*
@@ -109,7 +107,7 @@ uint16_t RandomWalkAnimation::calcNextPosition()
     {
         const auto ip = ne.index[i];
         pn = int_to_string(pn,ip); *pn++ = ' ';
-        pb = int_to_string(pb,brightness[ip]); *pb++ = ' ';
+        pb = int_to_string(pb,field.level(ip)); *pb++ = ' ';
         pp = int_to_string(pp,prob[i]); *pp++ =' ';
     }
     *pn++ = 0;
@@ -135,33 +133,29 @@ uint16_t RandomWalkAnimation::calcNextPosition()
         return ne.index[ rand->make_random() % ne.count ];
     }
 }
-void RandomWalkAnimation::initNeighboursMatrix()
+template <typename Layout>
+void BasicRandomWalkAnimation<Layout>::initNeighboursMatrix()
 {
-    neighbours = NeighboursMatrix::fromStrips(lines);
+    if (!coords) coords = BasicCoordMap<Layout>::acquire(lines);
+    if (coords) neighbours = coords->neighbours();
 }
-void RandomWalkAnimation::step()
+template <typename Layout>
+void BasicRandomWalkAnimation<Layout>::step()
 {
-    if (!neighbours) 
-    {
-        initNeighboursMatrix();
-    }
+    if (!neighbours) return;
     auto np = calcNextPosition();
     current_hue = getNextHue(current_hue);
-    setCurrentPixel( np, current_hue);
     time_to_fade_ms += delay_ms;
     if (time_to_fade_ms > fade_delay_ms)
     {
         time_to_fade_ms -= fade_delay_ms;
-        auto *p = strip->getBuffer();
-        const uint16_t fade = hue_fade + 1;
-        for (int i=0;i<totalPixels;++i,p++)
-        {
-            if (i != current_position) {
-                p->scale8(hue_fade);
-                brightness[i] = (brightness[i] * fade) >> 8;
-            }
-        }
+        field.tick();
     }
+    // set after the tick, the walker's own pixel does not fade
+    setCurrentPixel( np, current_hue);
+    field.render(strip);
     strip->refresh(true);
 }
-}
\ No newline at end of file
+template class BasicRandomWalkAnimation<CompactLayout>;
+template class BasicRandomWalkAnimation<WideLayout>;
+}
@@ -2,6 +2,7 @@
 #include <utils.hpp>
 #include <led_strip.hpp>
 #include <color.hpp>
+#include <rgb_kernels.hpp>
 #include <random.hpp>
 
 namespace Neopixel
@@ -16,6 +17,7 @@ Reel100::Reel100(LedStrip *strip_, int data_size, void *data) : strip(strip_)
     glitter_chance = decode<uint8_t>(data);
     size = strip->getLength();
     anim_time = anim_update_delay_s * 1000;
+    spectrum.build(255, 240);
     ESP_LOGI(TAG, "Reel100 animation : hue_update_delay_ms %d anim_update_delay_s %d hue_inc %d glitter_chance %d", hue_update_delay_ms, anim_update_delay_s, hue_inc, glitter_chance);
 }
 void Reel100::step()
@@ -30,12 +32,13 @@ void Reel100::step()
 }
 void Reel100::rainbow()
 {   
-    HSV hsv = {hue,255,240};
-    for (int i=0;i<size;++i) {
-        strip->fillPixelsRGB(i,1,hsv.toRGB());
-        hsv.h += hue_inc;
-    }
-    hue = hsv.h;
+    uint16_t h = hue;
+    strip->transform(0, size, [&](int) {
+        const RGB rgb = spectrum[h];
+        h += hue_inc;
+        return rgb;
+    });
+    hue = h;
 }
 void Reel100::addGlitter(uint8_t chance)
 {
@@ -52,16 +55,19 @@ void Reel100::rainbowWithGlitter()
 void Reel100::confetti() 
 {
     // random colored speckles that blink in and fade smoothly
-    fade_all(strip->getBuffer(), size, fade);
+    // faded in place, hdr strips have no 8 bit buffer to read back
+    const PixelSpan span = strip->writeSpan(0, size);
+    if (!span.data) return;
+    fade8(span.data, span.count, fade);
     const uint32_t rnd = make_random();
     HSV hsv = {uint16_t(hue + (rnd & 64)), 200, 255};
-    strip->getBuffer()[(rnd >> 8) % size] +=  hsv.toRGB();
+    span.data[(rnd >> 8) % span.count] +=  hsv.toRGB();
 }
 #if 0
     void sinelon()
     {
         // a colored dot sweeping back and forth, with fading trails
-        fade_all(strip->getBuffer(), size, fade);
+        fade8(strip->writeSpan(0, size).data, size, fade);
 
         int pos = beatsin16( 13, 0, NUM_LEDS-1 );
         leds[pos] += CHSV( gHue, 255, 192);
@@ -4,6 +4,8 @@
 #include <utils.hpp>
 #include <math_utils.hpp>
 #include <color.hpp>
+#include <decay_field.hpp>
+#include <pixel_map.hpp>
 #include <random.hpp>
 #include <RandomWalkAnimation.hpp>
 #include <DigitalRainAnimation.hpp>
@@ -90,7 +92,8 @@ struct Cylon : Animation
         {
             while(count-->0)
             {
-                auto buffer = strip->getBuffer();
+                auto buffer = strip->writeSpan(0, size).data;
+                if (!buffer) return;    //hdr strips have no 8 bit buffer to fade
                 for (int j=0; j<size;++j) {
                     buffer[j] = buffer[j].mix(bkg_rgb, fade);
                 }
@@ -139,6 +142,7 @@ struct Random : Animation
     uint8_t fade;
     int ms_to_new, ms_to_fade;
     RandomGenerator* random;
+    DecayField field;
 
     Random(LedStrip *strip_, int datasize, void *data, const Strips*,RandomGenerator*rng) : strip(strip_),random(rng)
     {
@@ -149,25 +153,27 @@ struct Random : Animation
         ESP_LOGI("Random-app", "Random animation : delay_new_ms %d delay_fade_ms %d fade %d", delay_new_ms, delay_fade_ms, fade);
         ms_to_new = delay_new_ms;
         ms_to_fade = delay_fade_ms;
+        field.init(strip->getLength(), fade, MemTag::Random);
     }
     uint16_t get_delay_ms() override { return delay_ms; }
     void step() override
     {
-        const auto size = strip->getLength();
+        const auto size = field.size();
         ms_to_new -= delay_ms;
-        if (ms_to_new <= 0) 
+        if (ms_to_new <= 0 && size > 0)
         {
             uint32_t rnd = random->make_random();
             HSV hsv = {uint16_t(rnd % 360), 255, 255};
-            strip->fillPixelsRGB((rnd>>8)%size, 1, hsv.toRGB());
+            field.set((rnd>>8)%size, hsv.toRGB());
             ms_to_new = delay_new_ms;
         }
         ms_to_fade -= delay_ms;
         if (ms_to_fade <=0)
         {
-            fade_all(strip->getBuffer(), size, fade);
+            field.tick();
             ms_to_fade = delay_fade_ms;
         }
+        field.render(strip);
         strip->refresh();
     }
 };
@@ -180,6 +186,7 @@ struct Wave : Animation
     uint8_t direction;
     uint16_t size;
     int start_hue;
+    int offset = 0;
 
     Wave(LedStrip *strip_, int datasize, void *data) : strip(strip_)
     {
@@ -190,42 +197,45 @@ struct Wave : Animation
         ESP_LOGI("Wave-animation", "Wave animation : delay %d inc %d direction %d", delay_ms, inc, direction);
         start_hue = rainbow(0, inc);
         if (direction==0) start_hue=0;
+        // the whole strip scrolls by moving the read offset of the encoder, not the pixels
+        const RotationRange whole {0, size, 0};
+        strip->setRotationRanges(&whole, 1);
+    }
+    ~Wave()
+    {
+        strip->setRotationRanges(nullptr, 0);
     }
     uint16_t get_delay_ms() override { return delay_ms; }
     void step() override
     {
-        auto * buffer = strip->getBuffer();
         if (direction==0)
         {
-            //memmove(buffer+1,buffer,sizeof(RGB)*(size-1));
-            for (int j=size-1;j>0;--j) {
-                buffer[j] = buffer[j-1];
-            }
+            // shown pixel j is the previous j-1, the new one is shown first
+            offset = offset == 0 ? size - 1 : offset - 1;
             start_hue -= inc;
             if (start_hue < 0) start_hue += 360;
             HSV hsv = {uint16_t(start_hue), 255,255};
-            strip->fillPixelsRGB(0,1,hsv.toRGB());
+            strip->fillPixelsRGB(offset,1,hsv.toRGB());
         }
         else
         {
-            //memmove(buffer,buffer+1,sizeof(RGB)*(size-1));
-            for (int j=0;j<size-1;++j) {
-                buffer[j] = buffer[j+1];
-            }
+            offset = offset == size - 1 ? 0 : offset + 1;
             start_hue += inc;
             if (start_hue > 360) start_hue -= 360;
             HSV hsv = {uint16_t(start_hue), 255,255};
-            strip->fillPixelsRGB(size-1,1,hsv.toRGB());
+            strip->fillPixelsRGB(offset == 0 ? size - 1 : offset - 1,1,hsv.toRGB());
         }
+        strip->setRotation(0, offset);
         strip->refresh();
     }
     uint16_t rainbow(uint16_t start_hue, uint8_t inc_hue)
     {   
         HSV hsv = {start_hue,255,255};
-        for (int i=0;i<size;++i) {
-            strip->fillPixelsRGB(i,1,hsv.toRGB());
+        strip->transform(0, size, [&](int) {
+            const RGB rgb = hsv.toRGB();
             hsv.h += inc_hue;
-        }
+            return rgb;
+        });
         return hsv.h;
     }
 };
@@ -258,7 +268,8 @@ struct RotatingRings2 : Animation
     {
     #if 0
         const auto size = strip->getLength();
-        auto buffer = strip->getBuffer();
+        auto buffer = strip->writeSpan(0, size).data;
+        if (!buffer) return;
         int current_ri = 0, dir = 1;
         int ms_to_move_ring = 0;
         strip->fillPixelsRGB(0,size,base_color);
@@ -371,7 +382,8 @@ struct RotatingRings : Animation
         vTaskDelay(pdMS_TO_TICKS(delay_ms));
         for(;;)
         {
-            auto buffer = strip->getBuffer();
+            auto buffer = strip->writeSpan(0, strip->getLength()).data;
+            if (!buffer) return;    //rotated in place, hdr strips have no 8 bit buffer
             for (int i=0;i<NumRings;++i) 
             {
                 auto & ring = Rings[i];
@@ -590,7 +602,8 @@ struct VerticalWave : Animation
         strip->refresh();
         for(;;)
         {
-            auto * buffer = strip->getBuffer();
+            auto * buffer = strip->writeSpan(0, strip->getLength()).data;
+            if (!buffer) return;    //rotated in place, hdr strips have no 8 bit buffer
             RGB rgb;
             for (auto & s : Strips)
             {
@@ -658,24 +671,31 @@ struct HorizontalWave : Animation
 Animation* Animation::create(LedStrip*strip,int animation_id, void* data, const Strips* strips,RandomGenerator*random)
 {
     const uint16_t animation_data_size = decode<uint16_t>(data);
+    Animation *a;
     switch(animation_id)
     {
         default:
-        case 0: return new Colortest(strip, animation_data_size, data);
+        case 0: a = new Colortest(strip, animation_data_size, data); break;
         //case 1: return new Cylon(strip, animation_data_size, data);
         //case 2: return new Reel100(strip, animation_data_size, data);
-        case 3: return new Random(strip, animation_data_size, data, strips, random);
-        case 4: return new FireAnimation(strip, animation_data_size, data, strips, random);
-        case 5: return new Wave(strip, animation_data_size, data);
+        case 3: a = new Random(strip, animation_data_size, data, strips, random); break;
+        case 4: a = new FireAnimation(strip, animation_data_size, data, strips, random); break;
+        case 5: a = new Wave(strip, animation_data_size, data); break;
         //case 6: return new VerticalRings(strip, animation_data_size, data);
         //case 7: return new RotatingRings(strip, animation_data_size, data);
         //case 8: return new RotatingStrips(strip, animation_data_size, data);
         //case 9: return new FallingStars(strip, animation_data_size, data);
         //case 10: return new VerticalWave(strip, animation_data_size, data);
         //case 11: return new HorizontalWave(strip, animation_data_size, data);
-        case 12: return new RandomWalkAnimation(strip, animation_data_size, data, strips, random);
-        case 13: return new DigitalRainAnimation(strip, animation_data_size, data, strips, random);
-        case 14: return new ParticleAnimation(strip, animation_data_size, data, strips, random);
+        case 12: a = new RandomWalkAnimation(strip, animation_data_size, data, strips, random); break;
+        case 13: a = new DigitalRainAnimation(strip, animation_data_size, data, strips, random); break;
+        case 14: a = new ParticleAnimation(strip, animation_data_size, data, strips, random); break;
+    }
+    if (a && !a->valid())
+    {
+        delete a;
+        return nullptr;
     }
+    return a;
 }
 }
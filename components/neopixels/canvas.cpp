@@ -0,0 +1,112 @@
+#include <cstring>
+#include <canvas.hpp>
+#include <led_strip.hpp>
+
+namespace Neopixel
+{
+bool Canvas::init(int width_, int height_, MemTag tag)
+{
+    release();
+    cells = Mem::alloc<RGB>(size_t(width_) * height_, tag);
+    if (!cells) return false;
+    width = width_;
+    height = height_;
+    clear();
+    return true;
+}
+void Canvas::release()
+{
+    Mem::free(cells);
+    cells = nullptr;
+    width = height = 0;
+}
+void Canvas::clear()
+{
+    memset(cells, 0, sizeof(RGB) * width * height);
+}
+namespace
+{
+    // 8.8 position on a grid of `from` steps scaled to one of `to` steps
+    inline uint32_t rescale(uint32_t pos, uint32_t from, uint32_t to)
+    {
+        return from ? uint32_t(uint64_t(pos) * to / from) : 0;
+    }
+}
+template <typename Layout>
+bool BasicCanvasMap<Layout>::build(const BasicCoordMap<Layout>* coords, int width, int height, MemTag tag)
+{
+    release();
+    if (!coords || width < 1 || height < 1 || width * height > 65536) return false;
+    const int total = int(coords->totalPixels);
+    const uint32_t lines = coords->strips->count > 1 ? coords->strips->count - 1 : 0;
+    const uint32_t along = coords->longest > 1 ? coords->longest - 1 : 0;
+    // taps of pixel i into t, @returns their count
+    auto pixelTaps = [&](int i, Tap* t) {
+        if (coords->x(Index(i)) == BasicCoordMap<Layout>::Unmapped) return 0;
+        const uint32_t fx = rescale(coords->x(Index(i)), lines, width - 1);
+        const uint32_t fy = rescale(coords->y(Index(i)), along, height - 1);
+        const uint32_t wx = fx & 0xff, wy = fy & 0xff;
+        const uint32_t cell = (fy >> 8) * width + (fx >> 8);
+        const uint32_t cells[4] = { cell, cell + 1, cell + width, cell + width + 1 };
+        const uint32_t weights[4] = { (256 - wx) * (256 - wy) >> 8, wx * (256 - wy) >> 8, (256 - wx) * wy >> 8, wx * wy >> 8 };
+        // truncation loses up to 3/256, the largest weight takes it so full scale stays full scale
+        int largest = 0;
+        uint32_t sum = 0;
+        for (int k=0;k<4;++k)
+        {
+            sum += weights[k];
+            if (weights[k] > weights[largest]) largest = k;
+        }
+        int n = 0;
+        for (int k=0;k<4;++k)
+        {
+            const uint32_t weight = k == largest ? weights[k] + 256 - sum : weights[k];
+            if (weight) t[n++] = { uint16_t(cells[k]), uint16_t(weight) };
+        }
+        return n;
+    };
+    Tap t[4];
+    uint32_t n = 0;
+    for (int i=0;i<total;++i) n += pixelTaps(i, t);
+    first = Mem::alloc<uint32_t>(size_t(total) + 1, tag);
+    taps = Mem::alloc<Tap>(n, tag);
+    if (!first || !taps)
+    {
+        release();
+        return false;
+    }
+    n = 0;
+    for (int i=0;i<total;++i)
+    {
+        first[i] = n;
+        n += pixelTaps(i, taps + n);
+    }
+    first[total] = n;
+    count = total;
+    w = width;
+    h = height;
+    return true;
+}
+template <typename Layout>
+void BasicCanvasMap<Layout>::release()
+{
+    Mem::free(first);
+    Mem::free(taps);
+    first = nullptr;
+    taps = nullptr;
+    count = 0;
+}
+template <typename Layout>
+void BasicCanvasMap<Layout>::resample(const Canvas& canvas, RGB* pixels) const
+{
+    for (int i=0;i<count;++i) pixels[i] = pixel(canvas, Index(i));
+}
+template <typename Layout>
+void BasicCanvasMap<Layout>::render(const Canvas& canvas, LedStrip* strip) const
+{
+    const int n = min(count, strip->getLength());
+    strip->transform(0, n, [&](int i) { return pixel(canvas, Index(i)); });
+}
+template class BasicCanvasMap<CompactLayout>;
+template class BasicCanvasMap<WideLayout>;
+}
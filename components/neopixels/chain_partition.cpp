@@ -0,0 +1,83 @@
+#include <chain_partition.hpp>
+
+namespace Neopixel
+{
+namespace
+{
+    // greedy fill with parts no longer than max_len, every part starts at a cut
+    int fillParts(int num_leds, int max_parts, const uint16_t* cuts, int num_cuts, int max_len, ChainPart* parts)
+    {
+        int n = 0;
+        int pos = 0;
+        int c = 0;
+        while (pos < num_leds)
+        {
+            if (n == max_parts) return -1;
+            int end = num_leds;
+            if (end - pos > max_len)
+            {
+                // furthest cut within reach
+                end = -1;
+                while (c < num_cuts && cuts[c] <= pos) ++c;
+                for (int k=c; k<num_cuts && cuts[k] - pos <= max_len; ++k) end = cuts[k];
+                if (end < 0) return -1;
+            }
+            if (parts) parts[n] = { uint16_t(pos), uint16_t(end - pos) };
+            ++n;
+            pos = end;
+        }
+        return n;
+    }
+}
+int partitionChain(int num_leds, int max_parts, const uint16_t* cuts, int num_cuts, ChainPart* parts)
+{
+    if (num_leds <= 0 || max_parts <= 0) return 0;
+    if (cuts == nullptr || num_cuts == 0)
+    {
+        const int n = max_parts < num_leds ? max_parts : num_leds;
+        const int base = num_leds / n;
+        const int extra = num_leds % n;
+        int first = 0;
+        for (int i=0;i<n;++i)
+        {
+            const int count = base + (i < extra ? 1 : 0);
+            parts[i] = { uint16_t(first), uint16_t(count) };
+            first += count;
+        }
+        return n;
+    }
+    // smallest longest part the cuts allow
+    int lo = (num_leds + max_parts - 1) / max_parts, hi = num_leds;
+    while (lo < hi)
+    {
+        const int mid = (lo + hi) / 2;
+        if (fillParts(num_leds, max_parts, cuts, num_cuts, mid, nullptr) > 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return fillParts(num_leds, max_parts, cuts, num_cuts, lo, parts);
+}
+ChainLocation locatePixel(const ChainPart* parts, int num_parts, int logical)
+{
+    for (int i=0;i<num_parts;++i)
+    {
+        if (logical >= parts[i].first && logical < parts[i].first + parts[i].count) {
+            return { i, logical - parts[i].first };
+        }
+    }
+    return { -1, 0 };
+}
+FrameTimeModel modelFrameTime(const ChainPart* parts, int num_parts, const NeopixelDrv::Timing& tm,
+                              bool parallel, uint32_t start_ns, int bytes_per_pixel)
+{
+    const uint64_t bit_ns = tm.T0H_NS + tm.T0L_NS;
+    uint64_t longest = 0, total = 0;
+    for (int i=0;i<num_parts;++i)
+    {
+        const uint64_t t = parts[i].count * 8 * bytes_per_pixel * bit_ns + tm.RESET_NS;
+        if (t > longest) longest = t;
+        total += t;
+    }
+    const uint64_t frame = parallel ? longest + uint64_t(start_ns) * num_parts : total + uint64_t(start_ns) * num_parts;
+    return { uint32_t(frame), uint32_t(longest), frame ? 1e9f / float(frame) : 0.0f };
+}
+}
@@ -10,7 +10,8 @@ namespace Neopixel
 Strips* loadFromBuffer(char*buffer,size_t size)
 {
     int nstrips = size / sizeof(Subset);
-    uint8_t *raw_ptr = new uint8_t[ sizeof(Subset)*nstrips + 1];
+    uint8_t *raw_ptr = Mem::alloc<uint8_t>(sizeof(Strips) + sizeof(Subset)*nstrips, MemTag::Layout);
+    if (!raw_ptr) return nullptr;
     Strips *strips = reinterpret_cast<Strips*>(raw_ptr);
     strips->count = nstrips;
     for (int i=0;i<nstrips;++i)
@@ -22,41 +23,60 @@ Strips* loadFromBuffer(char*buffer,size_t size)
     }
     return strips;
 }
-void release(Strips* s) { delete[] reinterpret_cast<uint8_t*>(s); }
-void release(NeighboursMatrix* m) { delete[] reinterpret_cast<uint8_t*>(m); }
+template <typename Layout>
+BasicStrips<Layout>* clipStrips(const BasicStrips<Layout>* strips, int num_leds)
+{
+    auto * raw = Mem::alloc<uint8_t>(sizeof(BasicStrips<Layout>) + strips->count * sizeof(BasicSubset<Layout>), MemTag::Layout);
+    if (!raw) return nullptr;
+    auto *clipped = reinterpret_cast<BasicStrips<Layout>*>(raw);
+    clipped->count = 0;
+    // unsigned like the indices, a negative length clips every line
+    const size_t limit = num_leds > 0 ? size_t(num_leds) : 0;
+    for (typename Layout::Index i=0;i<strips->count;++i)
+    {
+        auto s = strips->element[i];
+        if (s.first >= limit) continue;
+        if (size_t(s.first) + s.count > limit) s.count = typename Layout::Count(limit - s.first);
+        clipped->element[clipped->count++] = s;
+    }
+    return clipped;
+}
 namespace
 {
-    void initializePositionsMatrix(const Strips* strips, float* positions, uint16_t longest, uint16_t row_size)
+    /* j * (longest-1) / (count-1) with half the Acc bits of fraction : distinct positions of two lines
+    ** differ by at least 1/(count-1)^2, more than one fraction step, so ties and order are exact */
+    template <typename Layout>
+    void initializePositionsMatrix(const BasicStrips<Layout>* strips, typename Layout::Acc* positions, uint32_t longest, uint32_t row_size)
     {
-        for (int i=0; i<strips->count; ++i)
+        using Acc = typename Layout::Acc;
+        constexpr int FractionBits = 4 * sizeof(Acc);
+        for (size_t i=0; i<strips->count; ++i)
         {
             auto & s = strips->element[i];
-            auto fcount = float(strips->element[i].count);
-            int pi = i * row_size;
-            float dv = float(longest-1) / (fcount-1);
-            float p = 0.0;
-            int cnt = s.count;
-            while (cnt-- > 0)
+            const Acc steps = s.count > 1 ? s.count - 1 : 1;
+            size_t pi = i * row_size;
+            for (Acc j=0;j<s.count;++j)
             {
-                positions[pi++] = p;
-                p += dv;
+                positions[pi++] = (j * (longest - 1) << FractionBits) / steps;
             }
         }
     }
 }
-std::tuple<uint16_t*,int> Strips::makeIndicesMatrix() const
+template <typename Layout>
+std::tuple<typename Layout::Index*,int> BasicStrips<Layout>::makeIndicesMatrix(MemTag tag) const
 {
-    const uint16_t longest = getLongestLine();
+    const uint32_t longest = getLongestLine();
     const auto row_size = next_pow2(longest);
-    auto * indices = new uint16_t[count * row_size];
+    auto * indices = Mem::alloc<Index>(size_t(count) * row_size, tag);
+    if (!indices) return {nullptr, int(row_size)};
 
-    for (int i=0;i<count;++i)
+    for (size_t i=0;i<count;++i)
     {
         auto & s = element[i];
-        auto cnt = s.count;
-        uint16_t idx = s.first;
+        uint32_t cnt = s.count;
+        Index idx = s.first;
         if (s.dir < 0) idx += s.count - 1;
-        int pi = i * row_size;
+        size_t pi = i * row_size;
         while (cnt-- >0 )
         {
             indices[pi++] = idx;
@@ -64,89 +84,53 @@ std::tuple<uint16_t*,int> Strips::makeIndicesMatrix() const
         }
     }
 
-    return {indices,row_size};
+    return {indices,int(row_size)};
 }
-InterpolatedPoint Strips::getPoint2D(uint16_t x, uint16_t y, uint16_t nmax) const
+template <typename Layout>
+typename BasicStrips<Layout>::InterpolatedPoint BasicStrips<Layout>::getPoint2D(Index x, Index y, Index nmax) const
 {
-    InterpolatedPoint ip;
-    auto [x1,xs] = splitFixpoint88(x);
-    auto [i00,i01,v0] = getPoint1D(y,nmax,element[x1]);
-    auto x2 = x1+1;
-    if (x2 >= count || 0==xs)
-    {
-        ip.idx[0] = i00;
-        ip.value[0] = 255-v0;
-        if (v0 > 0)
-        {
-            ip.idx[1] = i01;
-            ip.value[1] = v0;
-            ip.n_points = 2;
-        }
-        else
-        {
-            ip.n_points = 1;
-        }
-    }
-    else
-    {
-        auto [i10,i11,v1] = getPoint1D(y,nmax,element[x2]);
-
-        if (v0 == v1 && v0 == 0)
-        {
-            ip.idx[0] = i00;
-            ip.idx[1] = i10;
-            ip.value[0] = (255-xs);
-            ip.value[1] = xs;
-            ip.n_points = 2;
-        }
-        else
-        {
-            ip.idx[0] = i00;
-            ip.idx[1] = i01;
-            ip.idx[2] = i10;
-            ip.idx[3] = i11;
-            auto ys = (v0+v1)/2;
-
-            ip.value[0] = (255-xs)*(255-ys)/256;
-            ip.value[1] = 255-ys;
-            ip.value[2] = 255-xs;
-            ip.value[3] = xs*ys/256;
-            ip.n_points = 4;
-        }
-    }
-    return ip;
+    return interpolate2D(x, [&](Index line) { return getPoint1D(y,nmax,element[line]); });
 }
-NeighboursMatrix* NeighboursMatrix::fromStrips(const Strips* strips)
+template <typename Layout>
+BasicNeighboursMatrix<Layout>* BasicNeighboursMatrix<Layout>::fromStrips(const BasicStrips<Layout>* strips, MemTag tag)
 {
-    const uint16_t longest = strips->getLongestLine();
+    const uint32_t longest = strips->getLongestLine();
     const size_t N = strips->count;
     const auto total_pixels = strips->getTotalPixelsCount();
-    auto [indices,row_size] = strips->makeIndicesMatrix();
-    float *positions = new float[row_size * N];
+    auto [indices,row_size] = strips->makeIndicesMatrix(tag);
+    using Acc = typename Layout::Acc;
+    Acc *positions = Mem::alloc<Acc>(size_t(row_size) * N, tag);
+    constexpr Index MaxNeighboursCnt = 6;
+    const size_t n_index = 2 + size_t(total_pixels) * (1 + MaxNeighboursCnt) ;
+    auto *matrix = reinterpret_cast<BasicNeighboursMatrix*>( Mem::alloc<Index>(n_index, tag) );
+    if (!indices || !positions || !matrix)
+    {
+        Mem::free(indices);
+        Mem::free(positions);
+        Mem::free(matrix);
+        return nullptr;
+    }
     initializePositionsMatrix(strips,positions,longest,row_size);
-    constexpr uint16_t MaxNeighboursCnt = 6;
-    const size_t n_uint16 = 2 + total_pixels * (1 + MaxNeighboursCnt) ;
-    auto *matrix = reinterpret_cast<NeighboursMatrix*>( new uint16_t[ n_uint16 ] );
-    memset(matrix,0,n_uint16*sizeof(uint16_t));
+    memset(matrix,0,n_index*sizeof(Index));
     matrix->count = total_pixels;
     matrix->elem_size = MaxNeighboursCnt + 1;
-    uint16_t * strip_indices   = indices;
-    float    * strip_positions = positions;
+    Index * strip_indices   = indices;
+    Acc * strip_positions = positions;
 
-    for (int i=0; i<N; ++i)
+    for (size_t i=0; i<N; ++i)
     {
-        const uint16_t len = strips->element[i].count;
-        uint16_t res[2];
-        for (int j=0;j<len;++j)
+        const uint32_t len = strips->element[i].count;
+        uint32_t res[2];
+        for (uint32_t j=0;j<len;++j)
         {
             auto & ne = matrix->getNeighbours(strip_indices[j]);
             ne.count = 0;
             const auto v = strip_positions[j];
             if (i>0)
             {
-                const uint16_t len_l = strips->element[i-1].count;
+                const uint32_t len_l = strips->element[i-1].count;
                 auto cnt =  find_closest(strip_positions - row_size,len_l,v,res);
-                uint16_t *indices_l = strip_indices - row_size;
+                Index *indices_l = strip_indices - row_size;
                 if (cnt > 0) ne.index[ne.count++] = indices_l[ res[0] ];
                 if (cnt > 1) ne.index[ne.count++] = indices_l[ res[1] ];
             }
@@ -156,9 +140,9 @@ NeighboursMatrix* NeighboursMatrix::fromStrips(const Strips* strips)
             }
             if (i<N-1)
             {
-                const uint16_t len_r = strips->element[i+1].count;
+                const uint32_t len_r = strips->element[i+1].count;
                 auto cnt =  find_closest(strip_positions + row_size,len_r,v,res);
-                uint16_t *indices_r = strip_indices + row_size;
+                Index *indices_r = strip_indices + row_size;
                 if (cnt > 0) ne.index[ne.count++] = indices_r[ res[0] ];
                 if (cnt > 1) ne.index[ne.count++] = indices_r[ res[1] ];
             }
@@ -170,8 +154,14 @@ NeighboursMatrix* NeighboursMatrix::fromStrips(const Strips* strips)
         strip_indices   += row_size;
         strip_positions += row_size;
     }
-    delete[] indices;
-    delete[] positions;
+    Mem::free(indices);
+    Mem::free(positions);
     return matrix;
 }
+template struct BasicStrips<CompactLayout>;
+template struct BasicStrips<WideLayout>;
+template struct BasicNeighboursMatrix<CompactLayout>;
+template struct BasicNeighboursMatrix<WideLayout>;
+template Strips* clipStrips(const Strips*, int);
+template BasicStrips<WideLayout>* clipStrips(const BasicStrips<WideLayout>*, int);
 }
@@ -0,0 +1,100 @@
+#include <color_pipeline.hpp>
+
+namespace Neopixel
+{
+namespace
+{
+    // r:0 g:1 b:2 in wire order
+    constexpr uint8_t order_channels[6][3] = {
+        {0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0}
+    };
+}
+void ColorPipeline::build(const ColorCorrection& cc, uint8_t brightness, bool hdr)
+{
+    const uint8_t white[3] = { cc.white.r, cc.white.g, cc.white.b };
+    for (int k=0;k<3;++k)
+    {
+        channel[k] = order_channels[uint8_t(cc.order)][k];
+        // scale after gamma so dimming stays linear in light output
+        const uint32_t scale = uint32_t(brightness) * white[channel[k]];
+        for (int v=0;v<256;++v)
+        {
+            const uint32_t lin = cc.gamma ? Gamma::table[v] : v;
+            lut[k][v] = uint8_t((lin * scale + 255*255/2) / (255*255));
+        }
+        if (!hdr || !lut16) continue;
+        uint16_t *row = lut16->row[k];
+        for (int i=0;i<257;++i)
+        {
+            const uint64_t lin = cc.gamma ? Gamma::table16[i] : (i * 65535 + 128) / 256;
+            // 65535 -> 255.0 in 8.8
+            row[i] = uint16_t((lin * 0xff00 * scale + uint64_t(65535)*255*255/2) / (uint64_t(65535)*255*255));
+        }
+        row[257] = row[256];  //full scale reads one past with a zero weight
+    }
+}
+template <typename Format>
+void ColorPipeline::encode(const RGB* src, int num_pixels, uint8_t* wire) const
+{
+    const auto *in = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t c0 = channel[0], c1 = channel[1], c2 = channel[2];
+    for (int i=0;i<num_pixels;++i)
+    {
+        const uint8_t v0 = lut[0][in[c0]];
+        const uint8_t v1 = lut[1][in[c1]];
+        const uint8_t v2 = lut[2][in[c2]];
+        if constexpr (Format::White)
+        {
+            // corrected values are linear in light, the common part moves to the white led
+            const uint8_t w = min(v0, min(v1, v2));
+            wire[0] = v0 - w;
+            wire[1] = v1 - w;
+            wire[2] = v2 - w;
+            wire[3] = w;
+        }
+        else
+        {
+            wire[0] = v0;
+            wire[1] = v1;
+            wire[2] = v2;
+        }
+        in += 3;
+        wire += Format::Bytes;
+    }
+}
+template <typename Format>
+void ColorPipeline::encode(const RGB16* src, int num_pixels, uint8_t* wire, uint8_t* residual) const
+{
+    const auto *in = reinterpret_cast<const uint16_t*>(src);
+    for (int i=0;i<num_pixels;++i)
+    {
+        uint32_t out[Format::Bytes];
+        for (int k=0;k<3;++k)
+        {
+            // 0..0xffff -> 0..0x10000 so that full scale hits the last entry
+            const uint32_t v = in[channel[k]] + (in[channel[k]] >> 15);
+            const uint16_t *t = lut16->row[k] + (v >> 8);
+            out[k] = t[0] + (((t[1] - t[0]) * (v & 0xff)) >> 8);
+        }
+        if constexpr (Format::White)
+        {
+            out[3] = min(out[0], min(out[1], out[2]));
+            for (int k=0;k<3;++k) out[k] -= out[3];
+        }
+        for (int k=0;k<Format::Bytes;++k)
+        {
+            // at most 0xff00 + 0xff, never overflows 8 bits
+            const uint32_t acc = out[k] + residual[k];
+            wire[k] = uint8_t(acc >> 8);
+            residual[k] = uint8_t(acc);
+        }
+        in += 3;
+        wire += Format::Bytes;
+        residual += Format::Bytes;
+    }
+}
+template void ColorPipeline::encode<PixelRGB>(const RGB*, int, uint8_t*) const;
+template void ColorPipeline::encode<PixelRGBW>(const RGB*, int, uint8_t*) const;
+template void ColorPipeline::encode<PixelRGB>(const RGB16*, int, uint8_t*, uint8_t*) const;
+template void ColorPipeline::encode<PixelRGBW>(const RGB16*, int, uint8_t*, uint8_t*) const;
+}
@@ -0,0 +1,108 @@
+#include <cstring>
+#include <coord_map.hpp>
+#include <utils.hpp>
+
+namespace Neopixel
+{
+namespace
+{
+    // live maps of each layout
+    template <typename Layout>
+    BasicCoordMap<Layout>* registry = nullptr;
+
+    template <typename Layout>
+    bool sameStrips(const BasicStrips<Layout>* a, const BasicStrips<Layout>* b)
+    {
+        if (a->count != b->count) return false;
+        for (typename Layout::Index i=0;i<a->count;++i)
+        {
+            const auto & sa = a->element[i];
+            const auto & sb = b->element[i];
+            if (sa.first != sb.first || sa.count != sb.count || sa.dir != sb.dir) return false;
+        }
+        return true;
+    }
+    constexpr size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+}
+template <typename Layout>
+const BasicCoordMap<Layout>* BasicCoordMap<Layout>::acquire(const Strips* strips)
+{
+    for (auto *m = registry<Layout>; m; m = m->next)
+    {
+        if (sameStrips(m->strips, strips))
+        {
+            ++m->refs;
+            return m;
+        }
+    }
+    const size_t nLines = strips->count;
+    const Index total = strips->getTotalPixelsCount();
+    const auto longest = strips->getLongestLine();
+    const uint32_t rowSize = longest ? next_pow2(uint32_t(longest)) : 0;
+    // one block : the map, reciprocals, the strips copy, coordinates, line rows
+    const size_t stripsBytes = sizeof(Strips) + nLines * sizeof(typename Strips::Subset);
+    const size_t recipAt   = align8(sizeof(BasicCoordMap));
+    const size_t stripsAt  = recipAt + nLines * sizeof(uint64_t);
+    const size_t coordsAt  = align8(stripsAt + stripsBytes);
+    const size_t indicesAt = coordsAt + 2 * size_t(total) * sizeof(Index);
+    auto *raw = Mem::alloc<uint8_t>(indicesAt + nLines * rowSize * sizeof(Index), MemTag::Layout);
+    if (!raw) return nullptr;
+
+    auto *m = reinterpret_cast<BasicCoordMap*>(raw);
+    auto *copy = reinterpret_cast<Strips*>(raw + stripsAt);
+    memcpy(copy, strips, stripsBytes);
+    m->strips = copy;
+    m->totalPixels = total;
+    m->longest = longest;
+    m->rowSize = rowSize;
+    m->recip = reinterpret_cast<uint64_t*>(raw + recipAt);
+    m->coords = reinterpret_cast<Index*>(raw + coordsAt);
+    m->indices = reinterpret_cast<Index*>(raw + indicesAt);
+    m->neighbourTable = nullptr;
+    for (size_t i=0;i<2*size_t(total);++i) m->coords[i] = Unmapped;
+
+    const uint64_t span = longest > 1 ? longest - 1 : 0;
+    for (size_t line=0;line<nLines;++line)
+    {
+        const auto & s = strips->element[line];
+        const uint64_t steps = s.count > 1 ? s.count - 1 : 0;
+        m->recip[line] = span ? ((steps << RecipShift) + span - 1) / span : 0;
+        Index idx = s.first;
+        if (s.dir < 0) idx += s.count - 1;
+        Index *row = m->indices + line * rowSize;
+        for (uint32_t j=0;j<s.count;++j,idx+=s.dir)
+        {
+            row[j] = idx;
+            m->coords[2 * size_t(idx)] = Index(line << 8);
+            // rounded up, getPoint1D of the position comes back to this pixel with no fraction
+            m->coords[2 * size_t(idx) + 1] = steps ? Index((j * span * 256 + steps - 1) / steps) : 0;
+        }
+    }
+    m->refs = 1;
+    m->next = registry<Layout>;
+    registry<Layout> = m;
+    return m;
+}
+template <typename Layout>
+void BasicCoordMap<Layout>::release(const BasicCoordMap* map)
+{
+    for (auto **p = &registry<Layout>; *p; p = &(*p)->next)
+    {
+        auto *m = *p;
+        if (m != map) continue;
+        if (--m->refs > 0) return;
+        *p = m->next;
+        if (m->neighbourTable) Neopixel::release(m->neighbourTable);
+        Mem::free(m);
+        return;
+    }
+}
+template <typename Layout>
+const BasicNeighboursMatrix<Layout>* BasicCoordMap<Layout>::neighbours() const
+{
+    if (!neighbourTable) neighbourTable = BasicNeighboursMatrix<Layout>::fromStrips(strips, MemTag::Layout);
+    return neighbourTable;
+}
+template struct BasicCoordMap<CompactLayout>;
+template struct BasicCoordMap<WideLayout>;
+}
@@ -0,0 +1,100 @@
+#include <cmath>
+#include <cstring>
+#include <decay_field.hpp>
+#include <led_strip.hpp>
+
+namespace Neopixel
+{
+template <typename Layout>
+bool BasicDecayField<Layout>::init(int count_, uint8_t fade, MemTag tag)
+{
+    release();
+    // one block : cells, live list, live bits
+    const int words = (count_ + 31) / 32;
+    const size_t cellBytes = sizeof(Cell) * count_;
+    const size_t listBytes = (sizeof(Index) * count_ + 3) & ~size_t(3);
+    auto *raw = Mem::alloc<uint8_t>(cellBytes + listBytes + 4 * words, tag);
+    if (!raw) return false;
+    live = reinterpret_cast<Index*>(raw);
+    liveBits = reinterpret_cast<uint32_t*>(raw + listBytes);
+    cells = reinterpret_cast<Cell*>(raw + listBytes + 4 * words);
+    memset(liveBits, 0, 4 * words);
+    count = count_;
+    numLive = 0;
+    now = 0;
+    setFade(fade);
+    return true;
+}
+template <typename Layout>
+void BasicDecayField<Layout>::release()
+{
+    Mem::free(live);
+    live = nullptr;
+    liveBits = nullptr;
+    cells = nullptr;
+    count = numLive = 0;
+}
+template <typename Layout>
+void BasicDecayField<Layout>::setFade(uint8_t fade)
+{
+    // age 1 gives c * (fade + 1) >> 8, the same as RGB::scale8
+    const double f = (fade + 1) / 256.0;
+    const double f256 = std::pow(f, 256);
+    for (int k=0;k<256;++k)
+    {
+        expLo[k] = uint16_t(std::lround(32768 * std::pow(f, k)));
+        expHi[k] = uint16_t(std::lround(32768 * std::pow(f256, k)));
+    }
+}
+template <typename Layout>
+void BasicDecayField<Layout>::set(Index i, const RGB& c, uint8_t level)
+{
+    if (!isLive(i))
+    {
+        liveBits[i >> 5] |= 1u << (i & 31);
+        live[numLive++] = i;
+    }
+    cells[i] = { c, level, now };
+    changed = true;
+}
+template <typename Layout>
+void BasicDecayField<Layout>::render(LedStrip* strip)
+{
+    if (!numLive || !changed) return;
+    changed = false;
+    Index lo = live[0], hi = live[0];
+    for (int k=1;k<numLive;++k)
+    {
+        if (live[k] < lo) lo = live[k];
+        if (live[k] > hi) hi = live[k];
+    }
+    // one span over the live range, per pixel setters when the strip has none
+    const int range = int(hi - lo) + 1;
+    const PixelSpan span = strip->writeSpan(int(lo), range);
+    const bool direct = span.data && span.count == range;
+    const int length = direct ? 0 : strip->getLength();
+    // pixel stores may alias anything, keep the state in locals
+    const Cell *cell = cells;
+    const uint16_t *lo8 = expLo, *hi8 = expHi;
+    const uint16_t t = now;
+    Index *list = live;
+    const int count_ = numLive;
+    int n = 0;
+    for (int k=0;k<count_;++k)
+    {
+        const Index i = list[k];
+        const uint16_t age = uint16_t(t - cell[i].stamp);
+        const uint32_t f = uint32_t(lo8[age & 0xff]) * hi8[age >> 8] >> 15;
+        const RGB c = cell[i].value;
+        const RGB v { uint8_t(c.r * f >> 15), uint8_t(c.g * f >> 15), uint8_t(c.b * f >> 15) };
+        if (direct) span.data[i - lo] = v;
+        else if (int(i) < length) strip->fillPixelsRGB(int(i), 1, v);
+        // written black once, then dropped
+        if ((255 * f) >> 15) list[n++] = i;
+        else liveBits[i >> 5] &= ~(1u << (i & 31));
+    }
+    numLive = n;
+}
+template class BasicDecayField<CompactLayout>;
+template class BasicDecayField<WideLayout>;
+}
@@ -0,0 +1,66 @@
+#include <cstring>
+#include <frame_interpolator.hpp>
+
+namespace Neopixel
+{
+void blendFrames(const RGB* from, const RGB* to, RGB* out, int count, uint16_t alpha)
+{
+    const auto *a = reinterpret_cast<const uint8_t*>(from);
+    const auto *b = reinterpret_cast<const uint8_t*>(to);
+    auto *o = reinterpret_cast<uint8_t*>(out);
+    const uint32_t beta = 256 - alpha;
+    // two unsigned products, no sign handling in the loop so it vectorizes
+    for (int i=0;i<3*count;++i) {
+        o[i] = uint8_t((a[i] * beta + b[i] * uint32_t(alpha)) >> 8);
+    }
+}
+void FrameInterpolator::init(RGB* mem, int n, uint32_t max_interval)
+{
+    num_pixels = n;
+    max_interval_us = max_interval;
+    for (int i=0;i<4;++i)
+    {
+        slot[i] = mem + i * n;
+        rendered_us[i] = 0;
+        state[i] = {};
+    }
+    out = mem + 4 * n;
+    memset(mem, 0, sizeof(RGB) * Buffers * n);
+    prev = 0; cur = 1; producer = 3;
+    frames = 0;
+    alpha = 256;
+    mailbox.store(2);
+}
+void FrameInterpolator::push(const RGB* frame, uint32_t t_us, const FrameState& st)
+{
+    memcpy(slot[producer], frame, sizeof(RGB) * num_pixels);
+    commit(t_us, st);
+}
+void FrameInterpolator::commit(uint32_t t_us, const FrameState& st)
+{
+    rendered_us[producer] = t_us;
+    state[producer] = st;
+    // an unconsumed frame comes back and is overwritten by the next push
+    producer = mailbox.exchange(producer | Fresh) & ~Fresh;
+}
+const RGB* FrameInterpolator::output(uint32_t t_us)
+{
+    if (mailbox.load() & Fresh)
+    {
+        const uint8_t fresh = mailbox.exchange(prev) & ~Fresh;
+        prev = cur;
+        cur = fresh;
+        if (frames < 2) ++frames;
+    }
+    const uint32_t interval = rendered_us[cur] - rendered_us[prev];
+    const int32_t elapsed = int32_t(t_us - rendered_us[cur]);
+    if (frames < 2 || interval == 0 || interval > max_interval_us || elapsed >= int32_t(interval)) alpha = 256;
+    else if (elapsed <= 0) alpha = 0;
+    else alpha = uint16_t((uint64_t(elapsed) << 8) / interval);
+    // the ends need no blend
+    if (alpha == 256) return slot[cur];
+    if (alpha == 0) return slot[prev];
+    blendFrames(slot[prev], slot[cur], out, num_pixels, alpha);
+    return out;
+}
+}
@@ -0,0 +1,49 @@
+#include <cstring>
+#include <frame_queue.hpp>
+
+namespace Neopixel
+{
+void FrameQueue::init(RGB* mem, int slots, int n)
+{
+    num_slots = slots < 2 ? 2 : slots > MaxSlots ? MaxSlots : slots;
+    num_pixels = n;
+    for (int i=0;i<num_slots;++i)
+    {
+        slot[i] = mem + i * n;
+        committed_us[i] = 0;
+        state[i] = {};
+    }
+    memset(mem, 0, sizeof(RGB) * num_slots * n);
+    head.store(0);
+    tail.store(0);
+}
+bool FrameQueue::tryCommit(uint32_t t_us, const FrameState& st)
+{
+    const int t = tail.load(std::memory_order_relaxed);
+    const int n = next(t);
+    // the next producer slot must not be the one the consumer reads
+    if (n == head.load(std::memory_order_acquire)) return false;
+    committed_us[t] = t_us;
+    state[t] = st;
+    memcpy(slot[n], slot[t], sizeof(RGB) * num_pixels);
+    tail.store(n, std::memory_order_release);
+    return true;
+}
+const RGB* FrameQueue::peek(uint32_t* t_us) const
+{
+    const int h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return nullptr;
+    if (t_us) *t_us = committed_us[h];
+    return slot[h];
+}
+void FrameQueue::pop()
+{
+    const int h = head.load(std::memory_order_relaxed);
+    head.store(next(h), std::memory_order_release);
+}
+int FrameQueue::size() const
+{
+    const int d = tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    return d < 0 ? d + num_slots : d;
+}
+}
@@ -0,0 +1,41 @@
+#include <hdr.hpp>
+
+namespace Neopixel
+{
+namespace
+{
+    inline uint16_t lerp16(uint16_t a, uint16_t b, uint16_t alpha)
+    {
+        return uint16_t(a + ((int32_t(b) - int32_t(a)) * int32_t(alpha) >> 16));
+    }
+}
+void fade16(RGB16* px, int count, uint16_t scale)
+{
+    auto *c = reinterpret_cast<uint16_t*>(px);
+    for (int i=0;i<3*count;++i) {
+        c[i] = uint16_t((uint32_t(c[i]) * scale) >> 16);
+    }
+}
+void blend16(RGB16* dst, const RGB16* src, int count, uint16_t alpha)
+{
+    for (int i=0;i<count;++i)
+    {
+        dst[i].r = lerp16(dst[i].r, src[i].r, alpha);
+        dst[i].g = lerp16(dst[i].g, src[i].g, alpha);
+        dst[i].b = lerp16(dst[i].b, src[i].b, alpha);
+    }
+}
+void blend16(RGB16* dst, int count, const RGB16& color, uint16_t alpha)
+{
+    for (int i=0;i<count;++i)
+    {
+        dst[i].r = lerp16(dst[i].r, color.r, alpha);
+        dst[i].g = lerp16(dst[i].g, color.g, alpha);
+        dst[i].b = lerp16(dst[i].b, color.b, alpha);
+    }
+}
+void fill16(RGB16* px, int count, const RGB16& color)
+{
+    while (count--) *px++ = color;
+}
+}
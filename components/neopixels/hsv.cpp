@@ -0,0 +1,61 @@
+#include <array>
+#include <hsv.hpp>
+
+namespace Neopixel
+{
+namespace
+{
+    struct HueSplit
+    {
+        uint8_t region;
+        uint8_t remainder;  //0..236, (h - 60*region) * 4 as in HSV::toRGB
+    };
+    constexpr std::array<HueSplit,360> makeHueSplit()
+    {
+        std::array<HueSplit,360> t {};
+        for (int h=0;h<360;++h) t[h] = { uint8_t(h / 60), uint8_t((h - h / 60 * 60) * (256 / 60)) };
+        return t;
+    }
+    constexpr auto hue_split = makeHueSplit();
+
+    // wire order of {v,p,q,t} for every region, the switch of HSV::toRGB
+    constexpr uint8_t region_order[6][3] = {
+        {0,3,1}, {2,0,1}, {1,0,3}, {1,2,0}, {3,1,0}, {0,1,2}
+    };
+    inline RGB convert(uint16_t h, uint8_t s, uint8_t v)
+    {
+        const HueSplit hs = hue_split[h < 360 ? h : h % 360];
+        uint8_t c[4];
+        c[0] = v;
+        c[1] = uint8_t((v * (255 - s)) >> 8);
+        c[2] = uint8_t((v * (255 - ((s * hs.remainder) >> 8))) >> 8);
+        c[3] = uint8_t((v * (255 - ((s * (255 - hs.remainder)) >> 8))) >> 8);
+        const uint8_t *o = region_order[hs.region];
+        return { c[o[0]], c[o[1]], c[o[2]] };
+    }
+}
+void hsvToRgb(const HSV* src, RGB* dst, int n)
+{
+    for (int i=0;i<n;++i) dst[i] = convert(src[i].h, src[i].s, src[i].v);
+}
+void HueSpectrum::build(uint8_t s, uint8_t v)
+{
+    for (int h=0;h<360;++h) rgb[h] = convert(uint16_t(h), s, v);
+}
+void HueSpectrum::toRgb(const uint16_t* hues, RGB* dst, int n) const
+{
+    for (int i=0;i<n;++i) dst[i] = (*this)[hues[i]];
+}
+void HueSpectrum::fill(uint16_t first, int inc, RGB* dst, int n) const
+{
+    int h = first % 360;
+    int step = inc % 360;
+    if (step < 0) step += 360;
+    for (int i=0;i<n;++i)
+    {
+        dst[i] = rgb[h];
+        h += step;
+        if (h >= 360) h -= 360;
+    }
+}
+}
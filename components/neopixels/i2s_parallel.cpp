@@ -0,0 +1,74 @@
+#include <i2s_parallel.hpp>
+
+namespace NeopixelDrv
+{
+void transpose8x8(const uint8_t lanes[8], uint8_t out[8])
+{
+    // Hacker's Delight transpose8, rows are fed in reverse so lane i ends up in bit i
+    uint32_t x = (uint32_t(lanes[7]) << 24) | (uint32_t(lanes[6]) << 16) | (uint32_t(lanes[5]) << 8) | lanes[4];
+    uint32_t y = (uint32_t(lanes[3]) << 24) | (uint32_t(lanes[2]) << 16) | (uint32_t(lanes[1]) << 8) | lanes[0];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = uint8_t(x >> 24); out[1] = uint8_t(x >> 16); out[2] = uint8_t(x >> 8); out[3] = uint8_t(x);
+    out[4] = uint8_t(y >> 24); out[5] = uint8_t(y >> 16); out[6] = uint8_t(y >> 8); out[7] = uint8_t(y);
+}
+size_t i2sParallelSamples(size_t max_lane_bytes, const I2SBitPattern& pattern)
+{
+    return max_lane_bytes * 8 * pattern.slots + pattern.reset_slots;
+}
+template <typename Word>
+size_t encodeI2SParallel(const uint8_t* const* lanes, const size_t* lane_bytes, int n_lanes,
+                         const I2SBitPattern& pattern, Word* out)
+{
+    constexpr int MaxLanes = sizeof(Word) * 8;
+    constexpr int Groups = MaxLanes / 8;
+    if (n_lanes > MaxLanes) n_lanes = MaxLanes;
+
+    size_t max_bytes = 0;
+    for (int l=0;l<n_lanes;++l) {
+        if (lane_bytes[l] > max_bytes) max_bytes = lane_bytes[l];
+    }
+    Word *pout = out;
+    for (size_t b=0;b<max_bytes;++b)
+    {
+        Word data[8] = {};
+        Word active = 0;
+        for (int g=0;g<Groups;++g)
+        {
+            uint8_t column[8] = {};
+            for (int i=0;i<8;++i)
+            {
+                const int l = g*8 + i;
+                if (l < n_lanes && b < lane_bytes[l]) {
+                    column[i] = lanes[l][b];
+                    active |= Word(1) << l;
+                }
+            }
+            uint8_t rows[8];
+            transpose8x8(column, rows);
+            for (int j=0;j<8;++j) {
+                data[j] |= Word(rows[j]) << (8*g);
+            }
+        }
+        for (int j=0;j<8;++j)
+        {
+            int s = 0;
+            for (;s<pattern.t0h_slots;++s) *pout++ = active;
+            for (;s<pattern.t1h_slots;++s) *pout++ = data[j];
+            for (;s<pattern.slots;++s)     *pout++ = 0;
+        }
+    }
+    for (int s=0;s<pattern.reset_slots;++s) *pout++ = 0;
+    return pout - out;
+}
+template size_t encodeI2SParallel<uint8_t> (const uint8_t* const*, const size_t*, int, const I2SBitPattern&, uint8_t*);
+template size_t encodeI2SParallel<uint16_t>(const uint8_t* const*, const size_t*, int, const I2SBitPattern&, uint16_t*);
+}
@@ -1,27 +1,34 @@
 #pragma once
 #include <tuple>
 #include "animation.hpp"
+#include <collections.hpp>
+#include <coord_map.hpp>
 
 namespace Neopixel
 {
 struct LedStrip;
-struct NeighboursMatrix;
-struct Strips;
 struct RandomGenerator;
-class DigitalRainAnimation : public Animation
+// Layout sets the index widths, instantiated for CompactLayout and WideLayout
+template <typename Layout>
+class BasicDigitalRainAnimation : public Animation
 {
+    using Index  = typename Layout::Index;
+    using Count  = typename Layout::Count;
+    using Offset = typename Layout::Offset;
     struct Line
     {
         uint8_t state;
-        int8_t position,length;
-        uint8_t delay;
+        Offset position,length;
+        Count delay;
         uint16_t hue;
     };
 public:
-    DigitalRainAnimation(LedStrip *strip_, int datasize, void *data,const Strips*, RandomGenerator*);
-    ~DigitalRainAnimation();
+    using Strips = BasicStrips<Layout>;
+    BasicDigitalRainAnimation(LedStrip *strip_, int datasize, void *data,const Strips*, RandomGenerator*);
+    ~BasicDigitalRainAnimation();
     void step() override;
     uint16_t get_delay_ms() override { return delay_ms; }
+    bool valid() const override { return rain_lines != nullptr; }
     void createRainLines();
     void restartLine(int idx);
     void moveLine(int idx) {rain_lines[idx].position -= 1;}
@@ -31,8 +38,8 @@ public:
     LedStrip* strip {nullptr};
     const Strips* pixelLines;
     RandomGenerator * rand;
-    uint8_t longest_line;
-    uint16_t totalPixels;
+    Count longest_line;
+    Index totalPixels;
     uint16_t delay_ms;
     uint16_t hue;
     uint16_t hue_min,hue_max;
@@ -40,9 +47,13 @@ public:
     uint8_t hue_mode; //0=nowrap,1==wrap,2==random
     uint8_t color_value;
     int8_t head_length;
-    uint8_t head_value, tail_length_min, tail_length_max, tail_length_range;
+    uint8_t head_value;
+    Count tail_length_min, tail_length_max, tail_length_range;
     Line *rain_lines {nullptr};
-    uint16_t *line_indices {nullptr};
-    uint16_t indices_row_size {};
+    // line rows of the shared coordinate map
+    const BasicCoordMap<Layout>* coords {nullptr};
+    const Index *line_indices {nullptr};
+    uint32_t indices_row_size {};
 };
+using DigitalRainAnimation = BasicDigitalRainAnimation<CompactLayout>;
 }
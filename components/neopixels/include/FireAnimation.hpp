@@ -5,14 +5,16 @@
 namespace Neopixel
 {
 struct LedStrip;
-struct Strips;
-struct Subset;
 struct RandomGenerator;
-class FireAnimation : public Animation
+// Layout sets the index widths, instantiated for CompactLayout and WideLayout
+template <typename Layout>
+class BasicFireAnimation : public Animation
 {
 public:
-    FireAnimation(LedStrip *strip_, int datasize, void *data,const Strips*, RandomGenerator*);
-    ~FireAnimation();
+    using Strips = BasicStrips<Layout>;
+    using Subset = BasicSubset<Layout>;
+    BasicFireAnimation(LedStrip *strip_, int datasize, void *data,const Strips*, RandomGenerator*);
+    ~BasicFireAnimation();
     void step() override;
     uint16_t get_delay_ms() override { return delay_ms; }
 
@@ -23,7 +25,8 @@ protected:
     RandomGenerator * rand;
     uint16_t delay_ms;
     uint8_t sparking,cooling,direction;
-    uint16_t totalPixels;
+    typename Layout::Index totalPixels;
     uint8_t* heat = {nullptr};
 };
+using FireAnimation = BasicFireAnimation<CompactLayout>;
 }
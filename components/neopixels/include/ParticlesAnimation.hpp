@@ -2,12 +2,12 @@
 #include <tuple>
 #include "animation.hpp"
 #include <value_animation.hpp>
+#include <decay_field.hpp>
+#include <coord_map.hpp>
 
 namespace Neopixel
 {
 struct LedStrip;
-struct Strips;
-struct Subset;
 struct RandomGenerator;
 
 enum ParticleType : int8_t
@@ -19,6 +19,9 @@ struct Particle
 {
     static Particle* load(void*& data, int& datasize);
     virtual ~Particle(){}
+    // counted with the animation, nullptr when out of memory
+    static void* operator new(size_t n) noexcept { return Mem::alloc(n, MemTag::Particles); }
+    static void operator delete(void* p) { Mem::free(p); }
     virtual std::tuple<int16_t,int16_t,uint16_t> update(uint16_t ms,RandomGenerator*) = 0;
     uint16_t center_x,center_y;
     uint8_t draw_mode;
@@ -56,10 +59,12 @@ public:
     ~ParticleAnimation();
     void step() override;
     uint16_t get_delay_ms() override { return delay_ms; }
+    bool valid() const override;
 
 protected:
     LedStrip* strip = {nullptr};
     const Strips* lines;
+    const CoordMap* coords;
     RandomGenerator * rand;
     uint16_t delay_ms,fade_delay_ms;
     uint16_t ms_to_fade;
@@ -67,6 +72,7 @@ protected:
     uint8_t hue_shift;
     uint8_t n_particles;
     Particle** particles;
+    DecayField field;
 
     uint16_t totalPixels,nmax;
 };
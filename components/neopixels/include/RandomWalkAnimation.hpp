@@ -1,40 +1,50 @@
 #pragma once
 #include <tuple>
 #include "animation.hpp"
+#include <decay_field.hpp>
+#include <coord_map.hpp>
 
 namespace Neopixel
 {
 struct LedStrip;
-struct NeighboursMatrix;
-struct Strips;
 struct RandomGenerator;
-class RandomWalkAnimation : public Animation
+// Layout sets the index widths, instantiated for CompactLayout and WideLayout
+template <typename Layout>
+class BasicRandomWalkAnimation : public Animation
 {
+    using Index = typename Layout::Index;
 public:
-    RandomWalkAnimation(LedStrip *strip_, int datasize, void *data,const Strips*, RandomGenerator*);
-    ~RandomWalkAnimation();
+    using Strips = BasicStrips<Layout>;
+    using NeighboursMatrix = BasicNeighboursMatrix<Layout>;
+    BasicRandomWalkAnimation(LedStrip *strip_, int datasize, void *data,const Strips*, RandomGenerator*);
+    ~BasicRandomWalkAnimation();
     void step() override;
     uint16_t get_delay_ms() override { return delay_ms; }
+    bool valid() const override { return neighbours && field.size(); }
 
     void initNeighboursMatrix();
     int16_t getNextHue(int16_t);
-    uint16_t calcNextPosition();
-    void setCurrentPixel(uint16_t idx,uint16_t hue);
+    Index calcNextPosition();
+    void setCurrentPixel(Index idx,uint16_t hue);
 
     LedStrip* strip = {nullptr};
     const Strips* lines;
     RandomGenerator * rand;
-    NeighboursMatrix *neighbours = {nullptr};
+    // shared with the other animations on the layout
+    const BasicCoordMap<Layout>* coords = {nullptr};
+    const NeighboursMatrix *neighbours = {nullptr};
     uint16_t delay_ms, fade_delay_ms;
     uint16_t hue_min,hue_max;
     int8_t hue_inc;
     uint8_t hue_wrap, hue_fade;
-    uint16_t totalPixels;
+    Index totalPixels;
 
     int16_t current_hue = {0};
-    uint8_t* brightness = {nullptr};
-    uint16_t current_position = 0;
+    // pixels and their brightness, faded lazily
+    BasicDecayField<Layout> field;
+    Index current_position = 0;
     uint16_t time_to_fade_ms = {0};
 };
+using RandomWalkAnimation = BasicRandomWalkAnimation<CompactLayout>;
 
 }
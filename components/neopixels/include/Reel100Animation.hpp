@@ -1,5 +1,6 @@
 #pragma once
 #include <animation.hpp>
+#include <hsv.hpp>
 #include <cstdint>
 
 namespace Neopixel
@@ -28,5 +29,6 @@ protected:
     uint16_t hue;
     uint16_t size;
     int32_t anim_time;
+    HueSpectrum spectrum;   //rainbow colors, s 255 v 240
 };
 }
\ No newline at end of file
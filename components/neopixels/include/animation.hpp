@@ -1,17 +1,20 @@
 #pragma once
 #include <cstdint>
+#include <collections.hpp>
 
 namespace Neopixel
 {
 struct LedStrip;
-struct Strips;
 struct RandomGenerator;
 struct Animation
 {
+    // nullptr when the animation could not get its memory
     static Animation* create(LedStrip*strip,int animation_id, void* data, const Strips*,RandomGenerator*);
     static void main(void*param);
     virtual void step() = 0;
     virtual uint16_t get_delay_ms() = 0;
+    // false when construction failed, create drops the animation
+    virtual bool valid() const { return true; }
     virtual ~Animation(){}
 };
 
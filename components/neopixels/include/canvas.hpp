@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <color.hpp>
+#include <coord_map.hpp>
+
+namespace Neopixel
+{
+struct LedStrip;
+/* Virtual raster for the 2D effects : width x height cells, row major.
+** x runs across the lines, y along them from the line starts */
+struct Canvas
+{
+    Canvas() = default;
+    Canvas(const Canvas&) = delete;
+    Canvas& operator=(const Canvas&) = delete;
+    ~Canvas() { release(); }
+    // cells cleared to black, false when out of memory
+    bool init(int width, int height, MemTag);
+    void release();
+    RGB* row(int y) { return cells + y * width; }
+    const RGB* row(int y) const { return cells + y * width; }
+    RGB& at(int x, int y) { return cells[y * width + x]; }
+    void clear();
+
+    int width = {0}, height = {0};
+    RGB* cells = {nullptr};
+};
+
+/* Canvas -> pixel weights of a layout, the canvas stretched so its corners land on the first and
+** last line ends. Each pixel is the bilinear blend of up to 4 cells, weights sum to 256 and zero
+** weights are not stored, so a canvas laid out one cell per pixel costs one tap per pixel.
+** Taps are kept in pixel order (compressed rows), a frame is one pass writing the pixels in
+** sequence, pixels of no line are black. The canvas may have up to 65536 cells */
+template <typename Layout>
+class BasicCanvasMap
+{
+public:
+    using Index = typename Layout::Index;
+    struct Tap
+    {
+        uint16_t cell;      //y * width + x
+        uint16_t weight;    //1..256
+    };
+    BasicCanvasMap() = default;
+    BasicCanvasMap(const BasicCanvasMap&) = delete;
+    BasicCanvasMap& operator=(const BasicCanvasMap&) = delete;
+    ~BasicCanvasMap() { release(); }
+
+    bool build(const BasicCoordMap<Layout>*, int width, int height, MemTag);
+    void release();
+    RGB pixel(const Canvas& canvas, Index i) const
+    {
+        const RGB *cells = canvas.cells;
+        uint32_t r = 0, g = 0, b = 0;
+        for (uint32_t k=first[i];k<first[i + 1];++k)
+        {
+            const RGB & c = cells[taps[k].cell];
+            r += c.r * taps[k].weight;
+            g += c.g * taps[k].weight;
+            b += c.b * taps[k].weight;
+        }
+        return { uint8_t(r >> 8), uint8_t(g >> 8), uint8_t(b >> 8) };
+    }
+    // pixels [0, numPixels) from the canvas
+    void resample(const Canvas&, RGB* pixels) const;
+    void render(const Canvas&, LedStrip*) const;
+    int numPixels() const { return count; }
+    int numTaps() const { return count ? int(first[count]) : 0; }
+    int width() const { return w; }
+    int height() const { return h; }
+
+private:
+    uint32_t* first = {nullptr};    //numPixels + 1, taps of pixel i are [first[i], first[i+1])
+    Tap* taps = {nullptr};
+    int count = {0};
+    int w = {0}, h = {0};
+};
+using CanvasMap = BasicCanvasMap<CompactLayout>;
+}
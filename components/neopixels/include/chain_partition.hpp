@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <neopixel_drv.h>
+
+namespace Neopixel
+{
+/* contiguous run of the logical chain driven by one output */
+struct ChainPart
+{
+    uint16_t first, count;
+};
+
+/* Splits num_leds logical pixels into at most max_parts contiguous parts minimizing the longest one.
+** With cuts (sorted logical indices, e.g. the first pixel of every Strips line) parts only start
+** at a cut, otherwise sizes differ by at most one.
+** Parts are in logical order, so concatenating the segment buffers keeps logical indices
+** and animations do not see the split.
+** @returns number of parts used */
+int partitionChain(int num_leds, int max_parts, const uint16_t* cuts, int num_cuts, ChainPart* parts);
+
+/* logical index -> (part, offset) */
+struct ChainLocation
+{
+    int part;
+    int offset;
+};
+ChainLocation locatePixel(const ChainPart* parts, int num_parts, int logical);
+
+/* Frame time model : every part shifts count*8*bytes_per_pixel bits and the reset, parallel outputs
+** overlap and only pay start_ns each for being kicked one after another */
+struct FrameTimeModel
+{
+    uint32_t frame_ns;
+    uint32_t longest_part_ns;
+    float fps;
+};
+FrameTimeModel modelFrameTime(const ChainPart* parts, int num_parts, const NeopixelDrv::Timing&,
+                              bool parallel, uint32_t start_ns = 0, int bytes_per_pixel = 3);
+}
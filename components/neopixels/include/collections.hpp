@@ -3,50 +3,76 @@
 #include <cstdint>
 #include <cstddef>
 #include <numeric>
+#include <cstring>
 #include <tuple>
 #include <math_utils.hpp>
+#include <mem_tracker.hpp>
 namespace Neopixel
 {
-struct Subset
+/* Index widths of a layout : Index addresses a pixel of the chain (and counts lines), Count the pixels
+** of one line, Offset a signed position within a line, Acc the fixed point products.
+** Types below are templated on it, the plain names are the compact layout */
+template <typename IndexT, typename CountT, typename OffsetT, typename AccT>
+struct LayoutIndex
 {
-    uint16_t first; 
-    uint8_t count; 
+    using Index  = IndexT;
+    using Count  = CountT;
+    using Offset = OffsetT;
+    using Acc    = AccT;
+};
+// up to 65k pixels and 255 per line, the original footprint
+using CompactLayout = LayoutIndex<uint16_t, uint8_t, int16_t, uint32_t>;
+// 4G pixels and 65k per line, e.g. a 300 pixel outline run or synthetic 100k layouts
+using WideLayout    = LayoutIndex<uint32_t, uint16_t, int32_t, uint64_t>;
+
+template <typename Layout>
+struct BasicSubset
+{
+    typename Layout::Index first; 
+    typename Layout::Count count; 
     int8_t dir;
 };
-struct InterpolatedPoint
+template <typename Layout>
+struct BasicInterpolatedPoint
 {
-    uint16_t idx[4];
+    typename Layout::Index idx[4];
     uint8_t  value[4];
     uint8_t n_points;
 };
 
-struct Strips
+template <typename Layout>
+struct BasicStrips
 {
-    static Strips* loadFromBuffer(char*buffer,size_t size);
-    uint16_t getTotalPixelsCount() const
+    using Index = typename Layout::Index;
+    using Subset = BasicSubset<Layout>;
+    using InterpolatedPoint = BasicInterpolatedPoint<Layout>;
+
+    static BasicStrips* loadFromBuffer(char*buffer,size_t size);
+    Index getTotalPixelsCount() const
     {
-        uint16_t max_index = 0;
-        for(int i=0;i<count;++i)
+        Index max_index = 0;
+        for(Index i=0;i<count;++i)
         {
             auto & s = element[i];
-            auto idx = s.first + s.count;
+            Index idx = s.first + s.count;
             if (idx > max_index) max_index = idx;
         }
         return max_index;
     }
-    uint16_t getLongestLine() const
+    typename Layout::Count getLongestLine() const
     {
-        uint16_t max_cnt = 0;
-        for(int i=0;i<count;++i)
+        typename Layout::Count max_cnt = 0;
+        for(Index i=0;i<count;++i)
         {
             auto & s = element[i];
             if (s.count > max_cnt) max_cnt = s.count;
         }
         return max_cnt;
     }
-    static std::tuple<uint16_t,uint16_t,uint8_t> getPoint1D(uint16_t pos,uint16_t nmax,const Subset& s)
+    // pos is 8.8 fixed point along the line, scaled so that nmax-1 is its last pixel
+    static std::tuple<Index,Index,uint8_t> getPoint1D(Index pos,Index nmax,const Subset& s)
     {
-        uint16_t idx = s.first;
+        Index idx = s.first;
         if (s.dir < 0) idx += s.count - 1;
 
         /*dy = (n-1) / (nmax-1)
@@ -54,55 +80,139 @@ struct Strips
         iy = dir*int(py)
         #print(f'setPoint1D p={pos} y0={y0} n={n} dir={dir} dy={dy} py={py} iy={iy}')
         return y0+iy,y0+iy+dir,py-int(py)*/
-        uint16_t py = pos*(s.count-1) / (nmax-1);  //py = py[8].pyf[8]
-        uint16_t pyf = py &0xff;
+        auto py = typename Layout::Acc(pos)*(s.count-1) / (nmax-1);  //py = py[8].pyf[8]
+        const uint8_t pyf = py &0xff;
         py >>= 8;
-        int16_t iy = s.dir * int16_t(py);
+        const auto iy = typename Layout::Offset(s.dir * typename Layout::Offset(py));
         idx += iy;
-        return {idx,idx+s.dir,pyf};
+        return {idx,Index(idx+s.dir),pyf};
     }
     //note x andy are 8.8bit fixed point
-    InterpolatedPoint getPoint2D(uint16_t x, uint16_t y, uint16_t nmax) const;
+    InterpolatedPoint getPoint2D(Index x, Index y, Index nmax) const;
+    // getPoint2D with the line lookup supplied, point1D(line) returns getPoint1D(y, .., line)
+    template <typename Point1D>
+    InterpolatedPoint interpolate2D(Index x, Point1D&& point1D) const;
 
-    std::tuple<uint16_t*,int> makeIndicesMatrix() const;
-    uint16_t count;
+    // rows of next_pow2(longest line) pixel indices in line order, release with Mem::free. nullptr when out of memory
+    std::tuple<Index*,int> makeIndicesMatrix(MemTag = MemTag::Layout) const;
+    Index count;
     Subset element[];
     //consecutive elements placed next
 };
-template <size_t N>
-Strips* makeStrips(Subset (&su)[N])
+template <typename Layout>
+template <typename Point1D>
+typename BasicStrips<Layout>::InterpolatedPoint BasicStrips<Layout>::interpolate2D(Index x, Point1D&& point1D) const
+{
+    InterpolatedPoint ip;
+    const Index x1 = x >> 8;
+    const uint8_t xs = x & 0xff;
+    auto [i00,i01,v0] = point1D(x1);
+    auto x2 = x1+1;
+    if (x2 >= count || 0==xs)
+    {
+        ip.idx[0] = i00;
+        ip.value[0] = 255-v0;
+        if (v0 > 0)
+        {
+            ip.idx[1] = i01;
+            ip.value[1] = v0;
+            ip.n_points = 2;
+        }
+        else
+        {
+            ip.n_points = 1;
+        }
+    }
+    else
+    {
+        auto [i10,i11,v1] = point1D(x2);
+
+        if (v0 == v1 && v0 == 0)
+        {
+            ip.idx[0] = i00;
+            ip.idx[1] = i10;
+            ip.value[0] = (255-xs);
+            ip.value[1] = xs;
+            ip.n_points = 2;
+        }
+        else
+        {
+            ip.idx[0] = i00;
+            ip.idx[1] = i01;
+            ip.idx[2] = i10;
+            ip.idx[3] = i11;
+            auto ys = (v0+v1)/2;
+
+            ip.value[0] = (255-xs)*(255-ys)/256;
+            ip.value[1] = 255-ys;
+            ip.value[2] = 255-xs;
+            ip.value[3] = xs*ys/256;
+            ip.n_points = 4;
+        }
+    }
+    return ip;
+}
+template <typename Layout>
+BasicStrips<Layout>* makeStrips(const BasicSubset<Layout>* su, size_t n)
 {
-    auto * raw = new uint8_t[sizeof(uint16_t) + N*sizeof(Subset)];
-    Strips *pstrips = reinterpret_cast<Strips*>(raw);
-    pstrips->count = N;
-    memcpy(pstrips->element,su,sizeof(su));
+    auto * raw = Mem::alloc<uint8_t>(sizeof(BasicStrips<Layout>) + n*sizeof(BasicSubset<Layout>), MemTag::Layout);
+    auto *pstrips = reinterpret_cast<BasicStrips<Layout>*>(raw);
+    pstrips->count = n;
+    memcpy(pstrips->element,su,n*sizeof(BasicSubset<Layout>));
     return pstrips;
 }
-void release(Strips*);
-struct Neighbours
+template <typename Layout, size_t N>
+BasicStrips<Layout>* makeStrips(BasicSubset<Layout> (&su)[N])
 {
-    uint16_t count;
-    uint16_t index[];
+    return makeStrips(su, N);
+}
+template <typename Layout>
+void release(BasicStrips<Layout>* s) { Mem::free(s); }
+/* Lines of strips that fit a chain of num_leds pixels : lines past the end are dropped,
+** the line crossing it is cut, so animations can be rebound to a shorter strip. Release with release(),
+** nullptr when out of memory */
+template <typename Layout>
+BasicStrips<Layout>* clipStrips(const BasicStrips<Layout>* strips, int num_leds);
+
+template <typename Layout>
+struct BasicNeighbours
+{
+    typename Layout::Index count;
+    typename Layout::Index index[];
     //consecutive elements placed next
 };
-struct NeighboursMatrix
+template <typename Layout>
+struct BasicNeighboursMatrix
 {
-    static NeighboursMatrix* fromStrips(const Strips*);
-    const Neighbours & getNeighbours(int index) const
+    using Index = typename Layout::Index;
+    using Neighbours = BasicNeighbours<Layout>;
+
+    // counted under the tag of the animation that owns it, nullptr when out of memory
+    static BasicNeighboursMatrix* fromStrips(const BasicStrips<Layout>*, MemTag = MemTag::Layout);
+    const Neighbours & getNeighbours(Index index) const
     {
-        const uint16_t * p = data + index * elem_size;
+        const Index * p = data + size_t(index) * elem_size;
         return *reinterpret_cast<const Neighbours*>(p);
     }
-    Neighbours & getNeighbours(int index)
+    Neighbours & getNeighbours(Index index)
     {
-        uint16_t * p = data + index * elem_size;
+        Index * p = data + size_t(index) * elem_size;
         return *reinterpret_cast<Neighbours*>(p);
     }
-    uint16_t count,elem_size;
-    uint16_t data[];
+    Index count,elem_size;
+    Index data[];
     //consecutive elements placed next
 };
-void release(NeighboursMatrix*);
+template <typename Layout>
+void release(BasicNeighboursMatrix<Layout>* m) { Mem::free(m); }
+
+using Subset = BasicSubset<CompactLayout>;
+using InterpolatedPoint = BasicInterpolatedPoint<CompactLayout>;
+using Strips = BasicStrips<CompactLayout>;
+using Neighbours = BasicNeighbours<CompactLayout>;
+using NeighboursMatrix = BasicNeighboursMatrix<CompactLayout>;
+Strips* loadFromBuffer(char*buffer,size_t size);
+
 template <typename T, typename U>
 inline int find_closest(const T* vector, U size, T val, U* result)
 {
@@ -21,12 +21,9 @@ struct RGB
         b += other.b;
         return *this;
     }
-    const RGB& operator+(const RGB& other)
+    RGB operator+(const RGB& other) const
     {
-        r += other.r;
-        g += other.g;
-        b += other.b;
-        return *this;
+        return { uint8_t(r + other.r), uint8_t(g + other.g), uint8_t(b + other.b) };
     }
     RGB mix(const RGB& other, uint8_t alpha) const
     {
@@ -38,18 +35,19 @@ struct RGB
         return { r_,g_,b_ };
     }
 };
+/* pixel of the optional 16 bit strip buffer, 0xffff is full scale */
+struct RGB16
+{
+    uint16_t r,g,b;
+    static RGB16 fromRGB(const RGB& c) { return { uint16_t(c.r * 257), uint16_t(c.g * 257), uint16_t(c.b * 257) }; }
+    RGB toRGB() const { return { uint8_t(r >> 8), uint8_t(g >> 8), uint8_t(b >> 8) }; }
+};
 inline RGB sat_add(const RGB& a, const RGB& b)
 {
     return { (uint8_t)min( uint16_t(a.r) + uint16_t(b.r), 255 ),
              (uint8_t)min( uint16_t(a.g) + uint16_t(b.g), 255 ),
              (uint8_t)min( uint16_t(a.b) + uint16_t(b.b), 255 ) };
 }
-inline void fade_all(RGB *leds, int size, uint8_t scale)
-{
-    for (int i=0;i<size;++i) {
-        leds[i].scale8(scale);
-    }
-}
 struct HSV
 {
     enum class Hue {
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <color.hpp>
+#include <pixel_format.hpp>
+
+namespace Neopixel
+{
+/* byte order on the wire, RGB is the buffer order */
+enum class ColorOrder : uint8_t { RGB, RBG, GRB, GBR, BRG, BGR };
+
+/* per segment output correction, applied while encoding, never to the pixel buffer */
+struct ColorCorrection
+{
+    ColorOrder order;
+    bool gamma;
+    RGB white;      //white balance, per channel scale, 255:unchanged
+};
+constexpr ColorCorrection NoCorrection { ColorOrder::RGB, false, {255,255,255} };
+
+namespace detail
+{
+    // constexpr pow for 0 < x <= 1, std::pow is not constexpr
+    constexpr double cexp(double y)
+    {
+        int halvings = 0;
+        while (y < -0.5) { y /= 2; ++halvings; }
+        double sum = 1, term = 1;
+        for (int n=1;n<20;++n) { term *= y / n; sum += term; }
+        while (halvings--) sum *= sum;
+        return sum;
+    }
+    constexpr double clog(double x)
+    {
+        int k = 0;
+        while (x < 0.5) { x *= 2; ++k; }
+        const double z = (x - 1) / (x + 1), z2 = z * z;
+        double sum = 0, p = z;
+        for (int n=1;n<40;n+=2) { sum += p / n; p *= z2; }
+        return 2 * sum - k * 0.69314718055994531;
+    }
+    template<int GammaX10>
+    constexpr std::array<uint8_t,256> makeGammaTable()
+    {
+        std::array<uint8_t,256> t {};
+        for (int i=1;i<256;++i) {
+            t[i] = uint8_t(255.0 * cexp(GammaX10 / 10.0 * clog(i / 255.0)) + 0.5);
+        }
+        return t;
+    }
+    // 257 entries, entry i is the input i/256 so that the last interval interpolates to full scale
+    template<int GammaX10>
+    constexpr std::array<uint16_t,257> makeGammaTable16()
+    {
+        std::array<uint16_t,257> t {};
+        for (int i=1;i<257;++i) {
+            t[i] = uint16_t(65535.0 * cexp(GammaX10 / 10.0 * clog(i / 256.0)) + 0.5);
+        }
+        return t;
+    }
+}
+/* 8 bit gamma table generated at compile time, gamma = GammaX10 / 10 */
+template<int GammaX10>
+struct GammaTable
+{
+    static constexpr std::array<uint8_t,256> table = detail::makeGammaTable<GammaX10>();
+    static constexpr std::array<uint16_t,257> table16 = detail::makeGammaTable16<GammaX10>();
+};
+using Gamma = GammaTable<22>;
+
+/* Brightness, gamma, white balance and channel order folded into one table per wire byte,
+** so encoding a pixel is 3 lookups whatever the settings are.
+** Rebuilt only when the brightness or the correction changes */
+struct ColorPipeline
+{
+    // 8.8 fixed point output at every 1/256 of the input, interpolated in between
+    struct Lut16 { uint16_t row[3][258]; };
+    // hdr also builds the 16 bit tables, only strips with a 16 bit buffer need them and set lut16
+    void build(const ColorCorrection&, uint8_t brightness, bool hdr = false);
+    // rgb pixels -> wire bytes, Format::Bytes per pixel
+    template <typename Format>
+    void encode(const RGB* src, int num_pixels, uint8_t* wire) const;
+    /* 16 bit pixels -> wire bytes with temporal dithering : the part below 8 bits is carried
+    ** to the next frame in residual (Format::Bytes per pixel), so the average over frames is the 16 bit value */
+    template <typename Format>
+    void encode(const RGB16* src, int num_pixels, uint8_t* wire, uint8_t* residual) const;
+    void encode(const RGB* src, int num_pixels, uint8_t* wire) const { encode<PixelRGB>(src, num_pixels, wire); }
+    void encode(const RGB16* src, int num_pixels, uint8_t* wire, uint8_t* residual) const
+    {
+        encode<PixelRGB>(src, num_pixels, wire, residual);
+    }
+
+    uint8_t channel[3];     //source channel of every wire byte
+    uint8_t lut[3][256];    //indexed by wire byte
+    Lut16* lut16 = nullptr; //memory laid out by hdr strips, nullptr : 8 bit only
+};
+}
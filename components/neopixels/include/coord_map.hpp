@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <tuple>
+#include <collections.hpp>
+
+namespace Neopixel
+{
+/* Coordinates derived from a layout, built once and shared by every animation drawn on it.
+** Maps are keyed by the content of the strips, so a clipped or reloaded copy of the same layout
+** finds the existing map, and the map keeps its own copy so the strips may be freed first.
+** Positions are 8.8 fixed point : x is the line, y the position along the line scaled so that
+** the last pixel of every line is at longest-1, the grid getPoint1D and getPoint2D take.
+** Maps are acquired and released by the task creating the animations, the registry is not locked */
+template <typename Layout>
+struct BasicCoordMap
+{
+    using Index = typename Layout::Index;
+    using Strips = BasicStrips<Layout>;
+    using InterpolatedPoint = BasicInterpolatedPoint<Layout>;
+    static constexpr Index Unmapped = Index(~Index(0));
+    static constexpr int RecipShift = 40;
+
+    // the shared map of strips, nullptr when out of memory. Every acquire needs a release
+    static const BasicCoordMap* acquire(const Strips*);
+    static void release(const BasicCoordMap*);
+
+    // pixel -> position, Unmapped for pixels in no line
+    Index x(Index pixel) const { return coords[2 * size_t(pixel)]; }
+    Index y(Index pixel) const { return coords[2 * size_t(pixel) + 1]; }
+    Index line(Index pixel) const { return x(pixel) == Unmapped ? Unmapped : Index(x(pixel) >> 8); }
+    // line -> its pixels in line order, reversed lines start at their highest index
+    const Index* row(Index line) const { return indices + size_t(line) * rowSize; }
+
+    // Strips::getPoint1D on line `line`, the divide replaced by the line reciprocal. pos <= longest << 8
+    std::tuple<Index,Index,uint8_t> getPoint1D(Index pos, Index line) const
+    {
+        const auto & s = strips->element[line];
+        Index idx = s.first;
+        if (s.dir < 0) idx += s.count - 1;
+        const uint64_t py = (uint64_t(pos) * recip[line]) >> RecipShift;
+        idx += typename Layout::Offset(s.dir * typename Layout::Offset(py >> 8));
+        return {idx, Index(idx + s.dir), uint8_t(py)};
+    }
+    InterpolatedPoint getPoint2D(Index x, Index y) const
+    {
+        return strips->interpolate2D(x, [&](Index line) { return getPoint1D(y, line); });
+    }
+    // built on the first call and kept with the map, nullptr when out of memory
+    const BasicNeighboursMatrix<Layout>* neighbours() const;
+
+    const Strips* strips;       //the map's own copy
+    Index totalPixels;
+    typename Layout::Count longest;
+    uint32_t rowSize;           //next_pow2(longest)
+    Index* coords;              //x, y per pixel
+    Index* indices;             //rowSize per line
+    uint64_t* recip;            //((count-1) << RecipShift) / (longest-1) per line, rounded up
+    mutable BasicNeighboursMatrix<Layout>* neighbourTable;
+    int refs;
+    BasicCoordMap* next;
+};
+using CoordMap = BasicCoordMap<CompactLayout>;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <color.hpp>
+#include <collections.hpp>
+
+namespace Neopixel
+{
+struct LedStrip;
+/* Lazily faded pixels : a pixel keeps the value it was set to and the tick it was set at, its
+** current value is that value times fade^age, read from two exp tables. tick() is O(1) and
+** render() only visits the live pixels, the ones set within the time it takes to fade to black,
+** so a frame costs the pixels touched and not the strip length.
+** Every pixel also carries a level (255 when set) that decays with it, for animations that
+** steer by how recently a pixel was lit. Ages are 16 bit : render at least every 65535 ticks */
+template <typename Layout>
+class BasicDecayField
+{
+public:
+    using Index = typename Layout::Index;
+    BasicDecayField() = default;
+    BasicDecayField(const BasicDecayField&) = delete;
+    BasicDecayField& operator=(const BasicDecayField&) = delete;
+    ~BasicDecayField() { release(); }
+
+    // all pixels dark, false when out of memory. fade : per tick factor (fade + 1) / 256
+    bool init(int count, uint8_t fade, MemTag);
+    void release();
+    void setFade(uint8_t fade);
+    void tick() { ++now; changed = true; }
+    void set(Index i, const RGB& c, uint8_t level = 255);
+    // value of the pixel at the current tick
+    RGB get(Index i) const
+    {
+        if (!isLive(i)) return {0,0,0};
+        const uint32_t f = factor(i);
+        const Cell & c = cells[i];
+        return { uint8_t(c.value.r * f >> 15), uint8_t(c.value.g * f >> 15), uint8_t(c.value.b * f >> 15) };
+    }
+    uint8_t level(Index i) const { return isLive(i) ? uint8_t(cells[i].level * factor(i) >> 15) : 0; }
+    /* writes the live pixels, pixels that reached black are written once more and dropped.
+    ** Nothing is written when there was no tick or set since the last render */
+    void render(LedStrip*);
+    int liveCount() const { return numLive; }
+    int size() const { return count; }
+
+protected:
+    struct Cell
+    {
+        RGB value;
+        uint8_t level;
+        uint16_t stamp;     //tick of the last set
+    };
+    bool isLive(Index i) const { return liveBits[i >> 5] & (1u << (i & 31)); }
+    // fade^age in 1.15 fixed point, age split into its low and high byte
+    uint32_t factor(Index i) const
+    {
+        const uint16_t age = uint16_t(now - cells[i].stamp);
+        return uint32_t(expLo[age & 0xff]) * expHi[age >> 8] >> 15;
+    }
+
+    uint16_t expLo[256];    //fade^k
+    uint16_t expHi[256];    //fade^(256 k)
+    Cell* cells = {nullptr};
+    Index* live = {nullptr};
+    uint32_t* liveBits = {nullptr};
+    int count = {0};
+    int numLive = {0};
+    uint16_t now = {0};
+    bool changed = {false};
+};
+using DecayField = BasicDecayField<CompactLayout>;
+}
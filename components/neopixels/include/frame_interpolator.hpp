@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <color.hpp>
+#include <frame_state.hpp>
+
+namespace Neopixel
+{
+// out = from + (to - from) * alpha / 256, alpha 0..256
+void blendFrames(const RGB* from, const RGB* to, RGB* out, int count, uint16_t alpha);
+
+/* Keeps the last two rendered frames and blends output frames in between, so the strip can be
+** refreshed at a fixed rate while the animation renders at its own, slower one.
+** Output lags rendering by one render interval : the newest frame is reached one interval after
+** it was pushed. Renders further apart than max_interval_us are shown as a step, not a slow fade.
+** push and output run on different tasks, frames are handed over through a mailbox slot */
+struct FrameInterpolator
+{
+    static constexpr int Buffers = 5;   //prev, cur, mailbox, producer, output
+    static constexpr uint32_t DefaultMaxIntervalUs = 500000;
+
+    // mem holds Buffers * num_pixels pixels
+    void init(RGB* mem, int num_pixels, uint32_t max_interval_us = DefaultMaxIntervalUs);
+    // producer : copies a rendered frame, t_us its render time
+    void push(const RGB* frame, uint32_t t_us, const FrameState& state = {});
+    // producer : the frame written in place, then committed
+    RGB* producerSlot() const { return slot[producer]; }
+    void commit(uint32_t t_us, const FrameState& state = {});
+    // consumer : frame to show at t_us, valid until the next call
+    const RGB* output(uint32_t t_us);
+    // consumer : settings of the newest frame in the output
+    const FrameState& outputState() const { return state[cur]; }
+    uint16_t lastAlpha() const { return alpha; }
+
+private:
+    static constexpr uint8_t Fresh = 0x80;
+    RGB* slot[4];
+    uint32_t rendered_us[4];
+    FrameState state[4];
+    RGB* out = nullptr;
+    int num_pixels = 0;
+    uint32_t max_interval_us = DefaultMaxIntervalUs;
+    uint8_t prev = 0, cur = 1, producer = 3;
+    uint8_t frames = 0;     //rendered frames seen by the consumer, up to 2
+    uint16_t alpha = 256;
+    std::atomic<uint8_t> mailbox { 2 };
+};
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <color.hpp>
+#include <frame_state.hpp>
+
+namespace Neopixel
+{
+/* Single producer / single consumer ring of rendered frames, lock free.
+** The producer renders into producerSlot() and commits it, the consumer peeks the oldest
+** committed frame and pops it once encoded. With S slots up to S-1 frames are queued,
+** the renderer runs ahead of transmission by that much before commit reports full.
+** A new producer slot starts as a copy of the committed frame, so animations that
+** build on the previous frame see the same buffer as with a single buffered strip */
+struct FrameQueue
+{
+    static constexpr int MaxSlots = 8;
+
+    // mem holds slots * num_pixels pixels, 2 <= slots <= MaxSlots
+    void init(RGB* mem, int slots, int num_pixels);
+    int depth() const { return num_slots - 1; }
+    // producer side
+    RGB* producerSlot() const { return slot[tail.load(std::memory_order_relaxed)]; }
+    // false when full, nothing changes and commit can be retried. state goes with the frame
+    bool tryCommit(uint32_t t_us, const FrameState& state = {});
+    // consumer side, nullptr when empty
+    const RGB* peek(uint32_t* t_us = nullptr) const;
+    // settings committed with the frame peek returns, valid until pop
+    const FrameState& peekState() const { return state[head.load(std::memory_order_relaxed)]; }
+    void pop();
+    // frames committed and not popped yet, exact on the consumer side
+    int size() const;
+
+private:
+    int next(int i) const { return i + 1 == num_slots ? 0 : i + 1; }
+    RGB* slot[MaxSlots];
+    uint32_t committed_us[MaxSlots];
+    FrameState state[MaxSlots];
+    int num_slots = 0;
+    int num_pixels = 0;
+    alignas(4) std::atomic<int> head { 0 };    //oldest queued, written by the consumer
+    alignas(4) std::atomic<int> tail { 0 };    //producer slot, written by the producer
+};
+}
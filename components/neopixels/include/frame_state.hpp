@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <pixel_map.hpp>
+
+namespace Neopixel
+{
+/* Encode settings a frame is sent with besides its pixels, taken when the frame is refreshed,
+** so a frame the output task sends later keeps the settings it was rendered for */
+struct FrameState
+{
+    uint8_t brightness = 255;
+    uint16_t offsets[PixelMap::MaxRanges] = {};     //rotation of each range
+};
+}
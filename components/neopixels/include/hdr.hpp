@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <color.hpp>
+
+namespace Neopixel
+{
+/* Kernels for the 16 bit strip buffer. Scales and alphas are 0.16 fixed point, 0xffff ~ 1.0,
+** so a slow fade keeps moving where scale8 already rounds to the same 8 bit value */
+
+// px = px * scale, never stalls above zero while scale < 0xffff
+void fade16(RGB16* px, int count, uint16_t scale);
+// dst = dst + (src - dst) * alpha
+void blend16(RGB16* dst, const RGB16* src, int count, uint16_t alpha);
+// dst = dst + (color - dst) * alpha
+void blend16(RGB16* dst, int count, const RGB16& color, uint16_t alpha);
+void fill16(RGB16* px, int count, const RGB16& color);
+}
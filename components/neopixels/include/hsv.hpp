@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <color.hpp>
+
+namespace Neopixel
+{
+/* Batch HSV -> RGB. Both variants are bit exact with HSV::toRGB (error bound 0) for any h,
+** hues of 360 and above wrap like toRGB does */
+
+// hue region and remainder come from a table, no divide while h < 360
+void hsvToRgb(const HSV* src, RGB* dst, int n);
+
+/* all 360 hues for one saturation and value, a conversion is one lookup.
+** 1080 bytes, build it once per animation for rainbows and fixed S/V palettes */
+struct HueSpectrum
+{
+    void build(uint8_t s, uint8_t v);
+    RGB operator[](uint16_t h) const { return rgb[h < 360 ? h : h % 360]; }
+    void toRgb(const uint16_t* hues, RGB* dst, int n) const;
+    // rainbow : dst[i] is the hue first + i*inc, taken modulo 360
+    void fill(uint16_t first, int inc, RGB* dst, int n) const;
+
+    RGB rgb[360];
+};
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace NeopixelDrv
+{
+/* Every led bit is sent as `slots` consecutive I2S samples, the first t0h_slots are high for every
+** active lane, samples up to t1h_slots carry the data bit and the rest are low, e.g. ws2812 at
+** 2.4MHz : {3,1,2} -> 0 = 417ns high, 1 = 833ns high. reset_slots of low samples close the frame */
+struct I2SBitPattern
+{
+    uint8_t slots, t0h_slots, t1h_slots;
+    uint16_t reset_slots;
+};
+
+/* 8x8 bit matrix transpose : bit i of out[j] = bit (7-j) of lanes[i],
+** so out[0] holds the MSB of every lane, one lane per bit */
+void transpose8x8(const uint8_t lanes[8], uint8_t out[8]);
+
+/* number of Word samples encodeI2SParallel writes for the longest lane */
+size_t i2sParallelSamples(size_t max_lane_bytes, const I2SBitPattern&);
+
+/* Interleaves up to sizeof(Word)*8 lanes into I2S samples, lane n drives bit n of every sample.
+** Lanes shorter than the longest one stay low after their last byte.
+** @returns number of samples written */
+template <typename Word>
+size_t encodeI2SParallel(const uint8_t* const* lanes, const size_t* lane_bytes, int n_lanes,
+                         const I2SBitPattern& pattern, Word* out);
+}
@@ -1,24 +1,130 @@
 #pragma once
 #include <cstdint>
+#include <color.hpp>
 
+namespace NeopixelDrv { struct RefillStats; }
 namespace Neopixel
 {
-struct RGB;
-struct HSV;
 struct LedStripConfig;
+struct RotationRange;
+struct SegmentStats
+{
+    uint32_t start_us;  //transmission started
+    uint32_t done_us;   //last bit sent, segment latches
+    uint32_t tx_us;
+    uint32_t bytes;     //sent in the last frame, 0: segment unchanged and skipped
+    const NeopixelDrv::RefillStats* refill; //live driver counters, null if the driver does not refill from an isr
+};
+struct LedStripStats
+{
+    uint32_t frames;
+    uint32_t start_skew_us; //first to last segment start
+    uint32_t latch_skew_us; //first to last segment latch
+    int num_segments;
+    const SegmentStats* segments;
+    uint32_t power_mA;      //estimated draw of the last frame before limiting
+    uint32_t power_scale;   //x/256 applied by the limiter, 256: under budget
+    uint32_t limited_frames;
+    uint32_t skipped_bytes;         //not retransmitted in the last frame
+    uint64_t total_skipped_bytes;
+    uint32_t queued;        //frames rendered ahead and not sent yet, queued strips
+    uint32_t queue_full;    //refreshes that waited for a free slot, queued strips
+};
+/* writable run of the 8 bit pixel buffer */
+struct PixelSpan
+{
+    RGB* data;
+    int count;
+};
 struct LedStrip
 {
+    // nullptr when out of memory
     static LedStrip* create(const LedStripConfig&);
+    /* Two step creation for reconfiguring a running strip : createInPlace lays the strip out in mem
+    ** (allocSize bytes) without claiming any peripheral, attach claims them once the old strip
+    ** has released its own. mem is not freed by release, createInPlace returns nullptr without it */
+    static uint32_t allocSize(const LedStripConfig&);
+    static LedStrip* createInPlace(const LedStripConfig&, void* mem);
+    static void attach(LedStrip*, const LedStripConfig&);
     virtual int getLength() const = 0;
+    // writes through the returned pointer are found by hashing the frame, the setters are tracked for free
     virtual RGB* getBuffer() = 0;
+    // strips created with hdr have only the 16 bit buffer, getBuffer returns nullptr
+    virtual RGB16* getBuffer16() { return nullptr; }
     virtual void setPixelsRGB(int first, int num, const RGB*) = 0;
     virtual void fillPixelsRGB(int first, int num, const RGB&) = 0;
     virtual void setPixelsHSV(int first, int num, const HSV*) = 0;
+    /* pixels [first, first+count) for bulk writes, tracked like the setters. The span is clipped
+    ** to the strip, empty when the strip has no 8 bit buffer (hdr strips, mocks) */
+    virtual PixelSpan writeSpan(int /*first*/, int /*count*/) { return {nullptr, 0}; }
+    /* pixel first+i = f(i), i ascending : one virtual call per run instead of one per pixel,
+    ** falls back to setPixelsRGB in chunks when there is no span */
+    template <typename F>
+    void transform(int first, int count, F&& f);
+    // pixel index[i] = f(i), i ascending, for the pixels of a line or any short index list
+    template <typename Index, typename F>
+    void scatter(const Index* index, int count, F&& f);
     virtual void refresh(bool wait=false) = 0;
+    /* interpolating strips : sends one blended output frame, called at the output rate
+    ** queued strips : sends the oldest rendered frame, false when none is waiting */
+    virtual bool outputFrame() { return false; }
     virtual void copyFrontToBack() = 0;
     virtual bool waitReady(uint32_t timeout_ms) = 0;
     virtual void release() = 0;
+    virtual const LedStripStats* getStats() const { return nullptr; }
+    // output only, applied while encoding, the pixel buffer keeps full scale values
+    virtual void setBrightness(uint8_t) {}
+    /* physical -> logical index table read while encoding (mirrored wiring, dead pixels = 0xffff),
+    ** getLength becomes logical_length. The table is not copied, nullptr restores the identity */
+    virtual void setRemap(const uint16_t* /*phys_to_logical*/, int /*logical_length*/) {}
+    // ranges of the logical buffer shown rotated, copied, count 0 clears them. Ignored when a range is empty or past the buffer
+    virtual void setRotationRanges(const RotationRange*, int /*count*/) {}
+    // O(1) scroll of one range, the buffer is not moved. Ignored for a range that is not set
+    virtual void setRotation(int /*range*/, int /*offset*/) {}
 protected:
     virtual ~LedStrip(){}
 };
+template <typename F>
+void LedStrip::transform(int first, int count, F&& f)
+{
+    const PixelSpan span = writeSpan(first, count);
+    if (span.data)
+    {
+        for (int i=0;i<span.count;++i) span.data[i] = f(i);
+        return;
+    }
+    constexpr int Chunk = 32;
+    RGB chunk[Chunk];
+    for (int done=0;done<count;done+=Chunk)
+    {
+        const int n = count - done < Chunk ? count - done : Chunk;
+        for (int i=0;i<n;++i) chunk[i] = f(done + i);
+        setPixelsRGB(first + done, n, chunk);
+    }
+}
+template <typename Index, typename F>
+void LedStrip::scatter(const Index* index, int count, F&& f)
+{
+    if (count <= 0) return;
+    Index lo = index[0], hi = index[0];
+    for (int i=1;i<count;++i)
+    {
+        if (index[i] < lo) lo = index[i];
+        if (index[i] > hi) hi = index[i];
+    }
+    // one span over the range the indices touch, unless part of it is off the strip
+    const int range = int(hi - lo) + 1;
+    const PixelSpan span = writeSpan(int(lo), range);
+    if (span.data && span.count == range)
+    {
+        for (int i=0;i<count;++i) span.data[index[i] - lo] = f(i);
+        return;
+    }
+    const int length = getLength();
+    for (int i=0;i<count;++i)
+    {
+        const RGB rgb = f(i);
+        if (int(index[i]) >= 0 && int(index[i]) < length) fillPixelsRGB(int(index[i]), 1, rgb);
+    }
+}
 }
\ No newline at end of file
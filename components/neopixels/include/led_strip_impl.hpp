@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <led_strip.hpp>
+#include <neopixel_drv.h>
+#include <color_pipeline.hpp>
+#include <power_limiter.hpp>
+#include <pixel_map.hpp>
+#include <frame_interpolator.hpp>
+#include <frame_queue.hpp>
+#include <pixel_format.hpp>
+
+namespace Neopixel
+{
+struct SegmentInfo
+{
+    int num_leds;
+    NeopixelDrv::Driver *driver;
+    ColorCorrection color;
+    uint8_t *wire;          //num_leds * Format::Bytes encoded bytes, owned by the driver until the frame is sent
+    uint8_t *dither;        //one residual per wire byte carried between frames, hdr strips only
+    ColorPipeline pipeline;
+    uint32_t hash;          //of the wire bytes last sent
+    bool hash_valid;
+};
+
+/* Format is the wire pixel format, instantiated for PixelRGB and PixelRGBW in led_strip.cpp */
+template <typename Format = PixelRGB>
+struct LedStripImpl : public LedStrip
+{
+    using Clock = uint32_t (*)();   //monotonic microseconds
+    using Yield = void (*)();       //lets the other task run while waiting on the frame queue
+
+    LedStripImpl(int totSize, int nSegments, SegmentInfo* segments, SegmentStats* stats,
+                 RGB* front, RGB* back, void* rawMem, Clock clock);
+    int getLength() const override { return _totSize; }
+    RGB* getBuffer() override { _directWrites = true; return _back; }
+    RGB16* getBuffer16() override { _directWrites = true; return _back16; }
+    // switches the strip to 16 bit buffers, segments must have their dither residuals
+    void setHdrBuffers(RGB16* front, RGB16* back);
+    // with a zero budget the draw is only estimated
+    void setPowerBudget(const PowerBudget& pb) { _power = pb; _powerMeter = true; }
+    // refresh only queues rendered frames, FrameInterpolator::Buffers * length pixels
+    void setInterpolationBuffers(RGB* mem);
+    /* refresh commits to a queue of slots * length pixels and blocks only when slots-1 frames
+    ** wait, outputFrame sends them from the output task, 8 bit only */
+    void setFrameQueue(RGB* mem, int slots, Yield yield);
+    void setPixelsRGB(int first, int count, const RGB* rgb) override;
+    void fillPixelsRGB(int first, int count, const RGB& rgb) override;
+    void setPixelsHSV(int first, int count, const HSV* hsv) override;
+    PixelSpan writeSpan(int first, int count) override;
+    void refresh(bool wait) override;
+    bool outputFrame() override;
+    bool waitReady(uint32_t timeout_ms) override;
+    void copyFrontToBack() override;
+    void release() override;
+    const LedStripStats* getStats() const override { return &_stats; }
+    void setBrightness(uint8_t brightness) override;
+    void setRemap(const uint16_t* phys_to_logical, int logical_length) override;
+    void setRotationRanges(const RotationRange* ranges, int count) override;
+    void setRotation(int range, int offset) override;
+
+    int _nSegments, _totSize;
+    int _physSize;
+    SegmentInfo* _segments;
+    RGB *_front, *_back;
+    RGB16 *_front16 = nullptr, *_back16 = nullptr;
+    void* _rawMem;
+    Clock _clock;
+    SegmentStats* _segStats;
+    LedStripStats _stats;
+    bool _statsPending = false;
+    uint8_t _brightness = 255;
+    bool _pipelineDirty = true;
+    uint8_t _pipelineBrightness = 255;  //the pipelines were built for, output side
+    PowerBudget _power {};
+    bool _powerMeter = false;
+    // pixels written through the setters since the last refresh, [first, end)
+    int _dirtyFirst = 0, _dirtyEnd = 0;
+    bool _directWrites = true;  //written behind the setters or remapped, the next frame is encoded whole
+    bool _backInSync = false;   //back buffer holds the last sent frame
+    PixelMap _map;
+    FrameInterpolator _interp;
+    bool _interpolate = false;
+    FrameQueue _queue;
+    PixelMap _outMap;   //output side copy of _map with the offsets of the frame being sent
+    bool _queued = false;
+    Yield _yield = nullptr;
+private:
+    FrameState snapshot() const;
+    void send(const RGB* frame, const RGB16* frame16, bool tracked, const PixelMap& map, const FrameState& state);
+    void markDirty(int first, int count);
+    bool rangeTracked() const;
+    void limitPower();
+};
+}
@@ -44,6 +44,9 @@ int8_t  sin_8b(uint8_t theta);
 int16_t cos_16b(uint16_t theta);
 int8_t  cos_8b(uint8_t theta);
 
+/* @returns floor(sqrt(v)), exact, one result bit per iteration */
+uint16_t sqrt_32b(uint32_t v);
+
 inline int16_t makeFixpoint88(   int8_t v, uint8_t f) { return ( int16_t(v) << 8 ) | (int16_t)f;}
 inline uint16_t makeFixpoint88u(uint8_t v, uint8_t f) { return (uint16_t(v) << 8 ) | (int16_t)f;}
 inline std::tuple<int8_t,uint8_t> splitFixpoint88(int16_t f) { return {f>>8, f&0xff}; }
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace Neopixel
+{
+/* owner of an allocation, subsystems first then one tag per animation with side buffers */
+enum class MemTag : uint8_t
+{
+    Strip,          //strip block : pixel and wire buffers, pipeline tables, queue slots
+    Driver,         //buffers the DMA reads : spi symbols, i2s samples and descriptors
+    Layout,         //strips, index and neighbour tables shared by animations
+    Fire,
+    DigitalRain,
+    RandomWalk,
+    Particles,
+    Random,
+    Count
+};
+
+/* where an allocation may live. Default follows the tag policy,
+** Internal keeps it out of external ram, Dma makes it reachable by the peripheral dma */
+enum class MemPlace : uint8_t { Default, Any, Internal, Dma };
+
+/* Tagged heap : every allocation is counted under its tag, current and peak bytes are kept
+** per tag so the footprint of a configuration can be read back at run time.
+** Blocks from alloc() must be returned with Mem::free(), never free() or delete[] */
+namespace Mem
+{
+    struct TagStats
+    {
+        uint32_t current;   //bytes
+        uint32_t peak;
+        uint32_t blocks;    //live allocations
+    };
+    // nullptr on failure, the failure is counted but never falls back to another placement
+    void* alloc(size_t bytes, MemTag, MemPlace = MemPlace::Default);
+    void  free(void*);
+    // uninitialized array of a trivial type
+    template <typename T>
+    T* alloc(size_t n, MemTag tag, MemPlace place = MemPlace::Default)
+    {
+        static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>);
+        return static_cast<T*>(alloc(n * sizeof(T), tag, place));
+    }
+
+    /* Placement policy : the strip block is read from the output isr and the pipeline tables
+    ** are hit for every byte, so it stays internal, driver buffers need dma capable memory,
+    ** everything else goes where the allocator finds room (external ram when present) */
+    MemPlace placement(MemTag);
+    void setPlacement(MemTag, MemPlace);
+
+    TagStats stats(MemTag);
+    uint32_t failures();
+    const char* name(MemTag);
+    // peaks restart from the current use
+    void resetPeaks();
+    /* text report, one line per tag : "<tag> <current> <peak> <blocks>", then the heap state on target.
+    ** @returns length written without the terminating zero */
+    int report(char* buffer, int size);
+}
+}
@@ -1,33 +1,78 @@
 #include <stdint.h>
 #include <driver/gpio.h>
 #include <driver/rmt.h>
+#include <driver/spi_master.h>
 #include <esp_event.h>
 #include <color.hpp>
 #include <led_strip.hpp>
+#include <pixel_format.hpp>
 
 namespace Neopixel
 {
+struct ColorCorrection;
+struct PowerBudget;
 struct RMTDriverConfig
 {
     gpio_num_t gpio;
     rmt_channel_t channel;
     int mem_block_num;
 };
+// I2S1 in parallel (LCD) mode, every segment is one lane of the same DMA buffer
+struct I2SDriverConfig
+{
+    static constexpr int MaxLanes = 16;     //I2S1 16 bit LCD mode
+    gpio_num_t gpio;
+    int lane;
+    int num_lanes;
+};
+// WS281x bits encoded as 3 or 4 SPI bits, MOSI only, whole frame sent by DMA
+struct SPIDriverConfig
+{
+    gpio_num_t gpio;
+    spi_host_device_t host;
+    int bits_per_symbol;
+};
 
-enum class SegmentType { WS2811,WS2812 };
-enum class DriverType { RMT, I2C, BITBANG };
+enum class SegmentType { WS2811,WS2812,SK6812 };
+enum class DriverType { RMT, I2C /*I2S parallel*/, BITBANG, SPI };
 struct LedSegmentConfig
 {
     int num_leds;
     SegmentType strip;
     DriverType driver;
     void* driver_config;
+    const ColorCorrection* color;   //nullptr: buffer order, no correction
 };
 struct LedStripConfig
 {
-    int num_buffers;
+    int num_buffers;    //1, 2 or up to FrameQueue::MaxSlots for a queue rendering num_buffers-1 frames ahead
     int num_segments;
     //LedSegmentConfig segments[];
     LedSegmentConfig *segments;
+    bool hdr;   //16 bit buffers, dithered to 8 bits on output
+    const PowerBudget* power;   //nullptr: no estimate, no limit
+    bool interpolate;   //refresh queues the frame, outputFrame sends blends of the last two, 8 bit only
+    PixelType pixel;    //wire format of every segment, RGBW for SK6812 rgbw strings
+};
+struct LedOutputConfig
+{
+    DriverType driver;
+    void* driver_config;
+    const ColorCorrection* color;
+};
+// one logical chain spread over the available outputs, see partitionChain
+struct LedChainConfig
+{
+    static constexpr int MaxOutputs = 8;
+    int num_leds;
+    SegmentType strip;
+    int num_outputs;
+    LedOutputConfig *outputs;
+    const uint16_t *cuts;   //logical indices a segment may start at, nullptr: anywhere
+    int num_cuts;
+    PixelType pixel;        //for the frame time model
 };
+// fills one segment per used output, segments must hold num_outputs entries
+// @returns number of segments, 0 when num_outputs is not in 1..MaxOutputs
+int makeSegments(const LedChainConfig&, LedSegmentConfig* segments);
 }
@@ -7,7 +7,9 @@ enum Commands
 {
     CmdSet,
     CmdStartAnimation,
-    CmdReconfigure
+    CmdReconfigure,
+    CmdSetBrightness,
+    CmdMemoryReport     //no arguments, the tcp server answers with Mem::report text
 };
 struct CmdSetArgs
 {
@@ -24,16 +26,29 @@ struct CmdStartAnimationArgs
     uint32_t animation_id;
     uint8_t animation_prms[1];
 };
+struct CmdSetBrightnessArgs
+{
+    uint8_t brightness;  //applied from the next refresh
+};
+enum ReconfigureFlags : uint8_t
+{
+    ReconfigureInterpolate = 1,
+};
+// the strip is replaced at a frame boundary, the running animation restarts on the new geometry
 struct CmdReconfigureArgs
 {
+    uint8_t num_buffers;
+    uint8_t flags;          //ReconfigureFlags
+    uint8_t pixel;          //PixelType
     uint8_t num_segments;
     struct Segment
     {
         uint16_t num_leds;
-        uint8_t strip_type;
+        uint8_t strip_type;     //SegmentType
+        uint8_t driver_type;    //DriverType
         uint8_t gpio_num;
-        uint8_t rmt_channel;
-        uint8_t rmt_mem_block_num;
+        uint8_t channel;        //rmt channel, i2s lane or spi host
+        uint8_t param;          //rmt memory blocks, i2s lane count or spi bits per symbol
     } segments[1];
 };
-}
+}
\ No newline at end of file
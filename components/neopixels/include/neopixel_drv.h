@@ -1,7 +1,5 @@
+#pragma once
 #include <stdint.h>
-namespace Neopixel {
-    struct RGB;
-}
 
 namespace NeopixelDrv
 {
@@ -10,13 +8,41 @@ struct Timing
     int T0H_NS, T0L_NS, T1H_NS, T1L_NS, RESET_NS;
     static const Timing& ws2811();
     static const Timing& ws2812();
+    static const Timing& sk6812();
 };
 
+/* RMT memory refill counters of one channel, see RefillMonitor */
+struct RefillStats
+{
+    uint32_t frames;
+    uint32_t refills;           //translator calls from the threshold interrupt
+    uint32_t underruns;         //refills too late, the hardware already sent stale items
+    uint32_t glitched_frames;   //frames with at least one underrun
+    uint32_t max_latency_ns;    //threshold event to refill, worst since start
+    uint32_t frame_latency_ns;  //worst of the last frame
+};
+
+/* Transmission is split so a strip can start all of its segments back to back :
+** prepare does the slow part (encoding, queueing), start only kicks the hardware.
+** Data is wire bytes, already color corrected and in the strip channel order.
+** A segment with nothing to send gets prepare(0) and no start, fewer bytes than the
+** segment length leave the remaining pixels as they are */
 struct Driver
 {
-    virtual void write(int size, Neopixel::RGB* data, bool wait=false) = 0;
+    virtual void prepare(int size, const uint8_t* data) = 0;
+    virtual void start() = 0;
     virtual bool wait(uint32_t timeout_ms) = 0;
+    // microseconds timestamp of the end of the last transmission, valid once wait returned true
+    virtual uint32_t doneTimestamp() const = 0;
     virtual void unload() = 0;
+    // drivers refilling the hardware from an interrupt report how late the refills were
+    virtual const RefillStats* refillStats() const { return nullptr; }
+    void write(int size, const uint8_t* data, bool wait_done=false)
+    {
+        prepare(size, data);
+        start();
+        if (wait_done) wait(1000);
+    }
 protected:
     virtual ~Driver(){}
 };
@@ -0,0 +1,150 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <color.hpp>
+#include <coord_map.hpp>
+
+namespace Neopixel
+{
+/* Anti-aliased drawing on a layout. Positions are signed 8.8 on the CoordMap grid : x is the line,
+** y the position along the lines on the grid of the longest one. Shapes may leave the layout, the
+** part outside is dropped. Every primitive reports the pixels it covers as plot(pixel, coverage),
+** coverage 1..256, so a shape can be added to a buffer, set in a DecayField or used as a mask.
+** Grid positions go to line pixels through the map's reciprocals, no divide per pixel.
+** Distances are in grid units, round shapes on the real object need y scaled by the caller */
+template <typename Layout>
+class BasicPainter
+{
+public:
+    using Index = typename Layout::Index;
+    using Map = BasicCoordMap<Layout>;
+    explicit BasicPainter(const Map* map_) : map(map_) {}
+
+    // bilinear splat on the 4 pixels around the point, coverages sum to 256
+    template <typename Plot> void point(int32_t x, int32_t y, Plot&& plot) const;
+    // Wu line 1 unit wide, the end cells covered by the part of them the segment spans
+    template <typename Plot> void line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, Plot&& plot) const;
+    // disc with a 1 unit soft edge or, when !filled, a ring 1 unit wide. r < 180 << 8
+    template <typename Plot> void circle(int32_t cx, int32_t cy, int32_t r, bool filled, Plot&& plot) const;
+
+    // the shapes added to pixels [0, totalPixels), saturating
+    void point(RGB* pixels, int32_t x, int32_t y, const RGB&) const;
+    void line(RGB* pixels, int32_t x0, int32_t y0, int32_t x1, int32_t y1, const RGB&) const;
+    void circle(RGB* pixels, int32_t cx, int32_t cy, int32_t r, bool filled, const RGB&) const;
+    // every mapped pixel set, c0 at (x0,y0) to c1 at (x1,y1) along the segment, constant beyond
+    void linearGradient(RGB* pixels, int32_t x0, int32_t y0, const RGB& c0, int32_t x1, int32_t y1, const RGB& c1) const;
+    // every mapped pixel set, c0 at the center to c1 at r and beyond. r < 180 << 8
+    void radialGradient(RGB* pixels, int32_t cx, int32_t cy, int32_t r, const RGB& c0, const RGB& c1) const;
+
+private:
+    int lines() const { return int(map->strips->count); }
+    int lineLength(int line) const { return int(map->strips->element[line].count); }
+    // grid y -> 8.8 position in the pixels of the line
+    int32_t along(int32_t y, int line) const
+    {
+        return int32_t(int64_t(y) * int64_t(map->recip[line]) >> Map::RecipShift);
+    }
+    // 1D splat of weight w at grid y of the line
+    template <typename Plot> void pointOnLine(int line, int32_t y, uint32_t w, Plot& plot) const;
+
+    const Map* map;
+};
+template <typename Layout>
+template <typename Plot>
+void BasicPainter<Layout>::pointOnLine(int line, int32_t y, uint32_t w, Plot& plot) const
+{
+    const int32_t py = along(y, line);
+    const int32_t j = py >> 8;
+    const uint32_t f = py & 0xff;
+    const int n = lineLength(line);
+    const Index *row = map->row(Index(line));
+    // the second pixel takes the remainder, the two always sum to w
+    const uint32_t w0 = (256 - f) * w >> 8;
+    if (j >= 0 && j < n && w0) plot(row[j], w0);
+    if (f && j + 1 >= 0 && j + 1 < n && w > w0) plot(row[j + 1], w - w0);
+}
+template <typename Layout>
+template <typename Plot>
+void BasicPainter<Layout>::point(int32_t x, int32_t y, Plot&& plot) const
+{
+    const int line = x >> 8;
+    const uint32_t fx = x & 0xff;
+    if (line >= 0 && line < lines()) pointOnLine(line, y, 256 - fx, plot);
+    if (fx && line + 1 >= 0 && line + 1 < lines()) pointOnLine(line + 1, y, fx, plot);
+}
+template <typename Layout>
+template <typename Plot>
+void BasicPainter<Layout>::line(int32_t x0, int32_t y0, int32_t x1, int32_t y1, Plot&& plot) const
+{
+    if (std::abs(x1 - x0) >= std::abs(y1 - y0))
+    {
+        if (x1 == x0) return;
+        if (x1 < x0)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        // one 1D splat per line crossed, weighted by the part of the line's cell the segment spans
+        const int64_t slope = (int64_t(y1 - y0) << 16) / (x1 - x0);
+        const int first = max((x0 + 128) >> 8, 0), last = min((x1 + 128) >> 8, lines() - 1);
+        for (int l=first;l<=last;++l)
+        {
+            const int32_t c = l << 8;
+            const int32_t span = min(x1, c + 128) - max(x0, c - 128);
+            if (span <= 0) continue;
+            pointOnLine(l, y0 + int32_t((c - x0) * slope >> 16), uint32_t(span), plot);
+        }
+        return;
+    }
+    if (y1 < y0)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    // along the lines : every pixel in the segment's y range, split between the lines around x
+    const int64_t slope = (int64_t(x1 - x0) << 16) / (y1 - y0);
+    const int first = max(min(x0, x1) >> 8, 0), last = min((max(x0, x1) + 255) >> 8, lines() - 1);
+    for (int l=first;l<=last;++l)
+    {
+        const Index *row = map->row(Index(l));
+        const int32_t pa = along(y0, l), pb = along(y1, l);
+        const int jlast = min((pb + 128) >> 8, lineLength(l) - 1);
+        for (int j=max((pa + 128) >> 8, 0);j<=jlast;++j)
+        {
+            const int32_t c = j << 8;
+            const int32_t span = min(pb, c + 128) - max(pa, c - 128);
+            if (span <= 0) continue;
+            const int32_t x = x0 + int32_t((int64_t(map->y(row[j])) - y0) * slope >> 16);
+            const int32_t cover = 256 - std::abs((l << 8) - x);
+            if (cover <= 0) continue;
+            const uint32_t w = uint32_t(cover * span) >> 8;
+            if (w) plot(row[j], w);
+        }
+    }
+}
+template <typename Layout>
+template <typename Plot>
+void BasicPainter<Layout>::circle(int32_t cx, int32_t cy, int32_t r, bool filled, Plot&& plot) const
+{
+    if (r < 0) return;
+    const int32_t reach = r + 256;
+    const int first = max((cx - reach + 255) >> 8, 0), last = min((cx + reach) >> 8, lines() - 1);
+    for (int l=first;l<=last;++l)
+    {
+        const int32_t dx = (l << 8) - cx;
+        // the chord of the reach on this line
+        const int32_t h = sqrt_32b(uint32_t(reach * reach - dx * dx));
+        const Index *row = map->row(Index(l));
+        const int jlast = min(along(cy + h, l) >> 8, lineLength(l) - 1);
+        for (int j=max((along(cy - h, l) + 255) >> 8, 0);j<=jlast;++j)
+        {
+            const int32_t dy = int32_t(map->y(row[j])) - cy;
+            const int32_t d = sqrt_32b(uint32_t(dx * dx + dy * dy));
+            const int32_t cover = min(filled ? r + 128 - d : 256 - std::abs(d - r), 256);
+            if (cover > 0) plot(row[j], uint32_t(cover));
+        }
+    }
+}
+using Painter = BasicPainter<CompactLayout>;
+}
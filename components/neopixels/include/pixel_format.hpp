@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+namespace Neopixel
+{
+enum class PixelType : uint8_t { RGB, RGBW };
+
+/* Wire pixel formats, resolved at compile time by the encoders and LedStripImpl.
+** The order of the color bytes is per segment (ColorCorrection::order) and folded into the
+** ColorPipeline tables, so it costs nothing per pixel. A format fixes what does : the wire
+** size and a white channel taking over the part common to r, g and b (sent last, as SK6812 does) */
+struct PixelRGB
+{
+    static constexpr PixelType type = PixelType::RGB;
+    static constexpr int Bytes = 3;
+    static constexpr bool White = false;
+};
+struct PixelRGBW
+{
+    static constexpr PixelType type = PixelType::RGBW;
+    static constexpr int Bytes = 4;
+    static constexpr bool White = true;
+};
+constexpr int pixelBytes(PixelType type) { return type == PixelType::RGBW ? PixelRGBW::Bytes : PixelRGB::Bytes; }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <color.hpp>
+
+namespace Neopixel
+{
+/* range of the logical buffer read rotated when encoding :
+** position i of the range shows pixel first + (i + offset) % count */
+struct RotationRange
+{
+    uint16_t first, count;
+    uint16_t offset;
+};
+
+/* Physical -> logical view of the pixel buffer used by the encode stage, so scrolling a ring
+** is an offset update and mirrored or dead pixels need no copy.
+** remap[physical] is the logical index, Dead for a pixel that is skipped (sent black) */
+struct PixelMap
+{
+    static constexpr uint16_t Dead = 0xffff;
+    static constexpr int MaxRanges = 16;
+
+    bool identity() const { return !remap && !num_ranges; }
+    // logical index -> buffer index
+    int source(int logical) const
+    {
+        for (int r=0;r<num_ranges;++r)
+        {
+            const auto & rr = ranges[r];
+            if (logical >= rr.first && logical < rr.first + rr.count)
+            {
+                int i = logical - rr.first + rr.offset;
+                if (i >= rr.count) i -= rr.count;
+                return rr.first + i;
+            }
+        }
+        return logical;
+    }
+    /* Splits physical pixels [phys_first, phys_first+count) into runs of consecutive buffer pixels,
+    ** run(source, n, phys_offset) with source -1 for dead pixels */
+    template <typename Run>
+    void forEachRun(int phys_first, int count, Run&& run) const
+    {
+        int p = 0;
+        while (p < count)
+        {
+            const int src = sourceOf(phys_first + p);
+            int n = 1;
+            if (remap)
+            {
+                // merge while the table is a plain forward sequence
+                while (p + n < count && sourceOf(phys_first + p + n) == (src < 0 ? -1 : src + n)) ++n;
+            }
+            else if (src >= 0)
+            {
+                // without a table runs only break at range or wrap boundaries
+                const int end = runEnd(phys_first + p, src);
+                n = end - (phys_first + p);
+                if (n > count - p) n = count - p;
+            }
+            run(src, n, p);
+            p += n;
+        }
+    }
+
+    // physical frame of count pixels from the logical buffer, dead pixels black
+    void apply(const RGB* logical, RGB* physical, int count) const
+    {
+        forEachRun(0, count, [&](int src, int n, int offset) {
+            if (src < 0) memset(physical + offset, 0, sizeof(RGB) * n);
+            else memcpy(physical + offset, logical + src, sizeof(RGB) * n);
+        });
+    }
+
+    const uint16_t* remap = nullptr;
+    RotationRange ranges[MaxRanges];
+    int num_ranges = 0;
+private:
+    int sourceOf(int physical) const
+    {
+        if (!remap) return source(physical);
+        const uint16_t l = remap[physical];
+        return l == Dead ? -1 : source(l);
+    }
+    // first logical index after `logical` where the source stops being contiguous
+    int runEnd(int logical, int src) const
+    {
+        int end = 1 << 30;
+        for (int r=0;r<num_ranges;++r)
+        {
+            const auto & rr = ranges[r];
+            if (logical >= rr.first && logical < rr.first + rr.count)
+            {
+                // up to the wrap of the source or the end of the range
+                const int end_range = rr.first + rr.count;
+                const int left = end_range - src < end_range - logical ? end_range - src : end_range - logical;
+                return logical + left;
+            }
+            if (rr.first > logical && rr.first < end) end = rr.first;
+        }
+        return end;
+    }
+};
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+namespace Neopixel
+{
+/* supply budget of a strip, the current of a channel is linear in its on time,
+** i.e. in the byte sent, whatever gamma or brightness produced it */
+struct PowerBudget
+{
+    uint32_t budget_mA;         //0: estimate only
+    uint16_t channel_uA[3];     //r,g,b current at 255
+    uint16_t idle_uA;           //per pixel, all channels off
+    uint16_t white_uA;          //w current at 255, rgbw strips only
+};
+
+// per wire byte sums of an encoded segment, 3 bytes per pixel
+void sumWireBytes(const uint8_t* wire, int num_pixels, uint32_t sums[3]);
+// rgbw segment, 4 bytes per pixel, the white byte is added to white
+void sumWireBytes(const uint8_t* wire, int num_pixels, uint32_t sums[3], uint32_t& white);
+
+// sums are per color channel (r,g,b)
+uint32_t estimateCurrent_mA(const PowerBudget&, const uint64_t channel_sums[3], int num_pixels, uint64_t white_sum = 0);
+
+/* uniform scale (x/256) bringing a frame of estimated draw under the budget, idle current
+** can not be scaled. @returns 256 when the frame fits */
+uint32_t powerScale(const PowerBudget&, uint32_t estimated_mA, int num_pixels);
+
+void scaleWireBytes(uint8_t* wire, int num_bytes, uint32_t scale);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <color.hpp>
+
+namespace Neopixel
+{
+/* Kernels for the 8 bit strip buffer. Every channel is treated alike, so a span is processed as a
+** byte stream : 4 channels per 32 bit word on the target, 16 per SSE2 register on the host.
+** Results are exact against the scalar formula given for each kernel (c: channel, 0..255) */
+
+// c = c * (scale + 1) >> 8, RGB::scale8 over a span
+void fade8(RGB* px, int count, uint8_t scale);
+void fade8(uint8_t* values, int count, uint8_t scale);
+// c = c * (factor.c + 1) >> 8, one factor per channel
+void scale8(RGB* px, int count, const RGB& factor);
+// dst = min(dst + src, 255)
+void add8(RGB* dst, const RGB* src, int count);
+// dst = (dst * alpha + src * (255 - alpha)) >> 8, RGB::mix over a span
+void mix8(RGB* dst, const RGB* src, int count, uint8_t alpha);
+void mix8(RGB* dst, int count, const RGB& color, uint8_t alpha);
+// dst = max(dst, src)
+void max8(RGB* dst, const RGB* src, int count);
+// dst = dst * (src + 1) >> 8
+void multiply8(RGB* dst, const RGB* src, int count);
+// dst = 255 - ((255 - dst) * (256 - src) >> 8), multiply of the inverted channels
+void screen8(RGB* dst, const RGB* src, int count);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <neopixel_drv.h>
+
+namespace NeopixelDrv
+{
+/* Watches the RMT ping-pong refill from inside the translator.
+** rmt_write_sample fills the whole channel memory (2 halves), then the threshold interrupt
+** fires every time the hardware has sent half of it and the translator refills the half just sent.
+** Item duration is fixed, so refill k is due at start + k * half * item_ns and has to land
+** before the hardware wraps onto that half again, one half later. A refill past that slack
+** means the hardware sent stale items (or idled on an old end marker) : an underrun, as is a
+** frame that ended with refills missing.
+** Time is in ns from any free running clock, wrap around is fine since only differences are used */
+struct RefillMonitor
+{
+    void init(uint32_t item_ns, uint32_t mem_items)
+    {
+        half_items = mem_items / 2;
+        half_ns = item_ns * half_items;
+        stats = {};
+    }
+    // before rmt_write_sample, the next translator call is the initial fill
+    void frameStart(uint32_t items)
+    {
+        const uint32_t mem_items = 2 * half_items;
+        expected = items > mem_items ? (items - mem_items + half_items - 1) / half_items : 0;
+        state = Armed;
+    }
+    inline __attribute__((always_inline)) void onTranslate(uint32_t now_ns)
+    {
+        if (state == Armed)
+        {
+            // the hardware starts right after the initial fill
+            state = Running;
+            start_ns = now_ns;
+            refill = 0;
+            frame_underruns = 0;
+            stats.frame_latency_ns = 0;
+            ++stats.frames;
+            return;
+        }
+        if (state != Running) return;
+        ++refill;
+        ++stats.refills;
+        const int32_t late = int32_t(now_ns - (start_ns + refill * half_ns));
+        const uint32_t latency = late > 0 ? uint32_t(late) : 0;
+        if (latency > stats.frame_latency_ns) stats.frame_latency_ns = latency;
+        if (latency > stats.max_latency_ns) stats.max_latency_ns = latency;
+        if (latency > half_ns) underrun(1);
+    }
+    // tx end, refills still missing never made it in time
+    void frameEnd()
+    {
+        if (state != Running) return;
+        state = Idle;
+        if (refill < expected) underrun(expected - refill);
+        if (frame_underruns) ++stats.glitched_frames;
+    }
+
+    enum State : uint8_t { Idle, Armed, Running };
+    RefillStats stats {};
+    uint32_t half_items = 0;
+    uint32_t half_ns = 0;
+    uint32_t start_ns = 0;
+    uint32_t refill = 0;
+    uint32_t expected = 0;
+    uint32_t frame_underruns = 0;
+    State state = Idle;
+private:
+    void underrun(uint32_t n)
+    {
+        stats.underruns += n;
+        frame_underruns += n;
+    }
+};
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace NeopixelDrv
+{
+/* rmt_item32_t layout : duration0:15 level0:1 duration1:15 level1:1
+** kept as plain uint32_t so the translator builds and runs on the host */
+inline uint32_t makeRmtItem(uint16_t duration0, uint8_t level0, uint16_t duration1, uint8_t level1)
+{
+    return  (uint32_t(duration0) & 0x7FFF)        | (uint32_t(level0 & 1) << 15) |
+           ((uint32_t(duration1) & 0x7FFF) << 16) | (uint32_t(level1 & 1) << 31);
+}
+
+/* Expands every source byte through a 256 entry table of 8 precomputed rmt items (MSB first),
+** so the refill callback does a single 32 byte block copy per byte instead of 8 bit tests */
+struct RmtTranslator
+{
+    static constexpr size_t ItemsPerByte = 8;
+
+    void init(uint32_t bit0, uint32_t bit1)
+    {
+        bits[0] = bit0;
+        bits[1] = bit1;
+        for (int v=0;v<256;++v)
+        {
+            for (int i=0;i<8;++i) {
+                table[v][i] = bits[ (v >> (7 - i)) & 1 ];
+            }
+        }
+    }
+    // same contract as sample_to_rmt_t, forced inline so it lands in the caller's IRAM section
+    inline __attribute__((always_inline)) void translate(const void *src, uint32_t *dest, size_t src_size,
+            size_t wanted_num, size_t *translated_size, size_t *item_num) const
+    {
+        if (src == nullptr || dest == nullptr) {
+            *translated_size = 0;
+            *item_num = 0;
+            return;
+        }
+        const size_t n_bytes = min_size(src_size, (wanted_num + ItemsPerByte - 1) / ItemsPerByte);
+        const auto *psrc = reinterpret_cast<const uint8_t*>(src);
+        for (size_t i=0;i<n_bytes;++i)
+        {
+            const uint32_t *item = table[ psrc[i] ];
+            dest[0] = item[0]; dest[1] = item[1]; dest[2] = item[2]; dest[3] = item[3];
+            dest[4] = item[4]; dest[5] = item[5]; dest[6] = item[6]; dest[7] = item[7];
+            dest += ItemsPerByte;
+        }
+        *translated_size = n_bytes;
+        *item_num = n_bytes * ItemsPerByte;
+    }
+    static constexpr size_t min_size(size_t a, size_t b) { return a < b ? a : b; }
+
+    uint32_t bits[2];
+    uint32_t table[256][ItemsPerByte];
+};
+}
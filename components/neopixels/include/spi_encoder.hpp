@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <neopixel_drv.h>
+
+namespace NeopixelDrv
+{
+/* Every led bit becomes bits_per_symbol SPI bits (MSB first) clocked at clock_hz,
+** the first t0h_bits / t1h_bits of a 0 / 1 symbol are high, the rest low */
+struct SpiBitPattern
+{
+    uint32_t clock_hz;
+    uint8_t bits_per_symbol;
+    uint8_t t0h_bits, t1h_bits;
+    uint16_t reset_bytes;
+
+    static SpiBitPattern fromTiming(const Timing&, int bits_per_symbol);
+    size_t frameBytes(size_t src_size) const { return src_size * bits_per_symbol + reset_bytes; }
+};
+
+/* Expands a byte into its 3 or 4 SPI bytes through a 256 entry table, the encoded
+** frame ends with reset_bytes of zeros so the strip latches */
+struct SpiEncoder
+{
+    void init(const SpiBitPattern&);
+    size_t encode(const uint8_t* src, size_t src_size, uint8_t* out) const;
+
+    SpiBitPattern pattern;
+    uint32_t table[256];
+};
+
+struct SpiWaveformCheck
+{
+    size_t n_decoded;
+    int max_error_ns;   //worst deviation of a high or low pulse from the timing table
+    uint32_t reset_ns;  //low time after the last bit
+    bool timing_ok;
+    bool reset_ok;
+};
+/* Decodes an encoded SPI stream back to bytes measuring every high and low pulse
+** against the timing table, host side verification of the waveform */
+SpiWaveformCheck verifySpiWaveform(const uint8_t* stream, size_t size, uint32_t clock_hz,
+                                   const Timing&, int tolerance_ns, uint8_t* decoded, size_t max_decoded);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+namespace Neopixel
+{
+/* Two regions reserved once at boot : a reconfigured strip is laid out in the idle one while
+** the current strip keeps running in the other, swap() flips them.
+** Reconfiguring never mallocs or frees, so it cannot fragment the heap */
+struct StripArena
+{
+    // false when the reservation fails, region_bytes is the limit for any one strip
+    bool init(uint32_t region_bytes);
+    void release();
+    // the region a new strip is built in, nullptr when bytes do not fit
+    void* idle(uint32_t bytes) const;
+    void* active() const { return region(current); }
+    void swap() { current ^= 1; }
+    uint32_t regionBytes() const { return region_bytes; }
+
+private:
+    void* region(int i) const { return mem ? mem + i * region_bytes : nullptr; }
+    uint8_t *mem = nullptr;
+    uint32_t region_bytes = 0;
+    int current = 0;
+};
+}
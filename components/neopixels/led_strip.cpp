@@ -0,0 +1,435 @@
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#include <color.hpp>
+#include <hsv.hpp>
+#include <math_utils.hpp>
+#include <led_strip_impl.hpp>
+#include <mem_tracker.hpp>
+
+namespace Neopixel
+{
+template <typename Format>
+LedStripImpl<Format>::LedStripImpl(int totSize, int nSegments, SegmentInfo* segments, SegmentStats* stats,
+                           RGB* front, RGB* back, void* rawMem, Clock clock) :
+    _nSegments(nSegments), _totSize(totSize), _physSize(totSize), _segments(segments),
+    _front(front), _back(back),
+    _rawMem(rawMem), _clock(clock), _segStats(stats)
+{
+    memset(stats, 0, sizeof(SegmentStats) * nSegments);
+    _stats = {0, 0, 0, nSegments, stats, 0, 256, 0, 0, 0, 0, 0};
+    for (int i=0;i<nSegments;++i) {
+        segments[i].hash_valid = false;
+    }
+}
+namespace
+{
+    // multiply-rotate over words, only has to tell two frames of the same segment apart
+    uint32_t wireHash(const uint8_t* p, int size)
+    {
+        uint32_t h = 0x811c9dc5u ^ uint32_t(size);
+        int i = 0;
+        for (; i + 4 <= size; i += 4)
+        {
+            uint32_t w;
+            memcpy(&w, p + i, 4);
+            h = (h ^ w) * 0x9e3779b1u;
+            h = (h << 13) | (h >> 19);
+        }
+        for (; i < size; ++i) {
+            h = (h ^ p[i]) * 0x01000193u;
+        }
+        return h;
+    }
+    // interpolated frames are mapped when they are pushed
+    const PixelMap physical {};
+}
+template <typename Format>
+void LedStripImpl<Format>::markDirty(int first, int count)
+{
+    if (count <= 0) return;
+    if (_dirtyFirst == _dirtyEnd)
+    {
+        _dirtyFirst = first;
+        _dirtyEnd = first + count;
+        return;
+    }
+    _dirtyFirst = min(_dirtyFirst, first);
+    _dirtyEnd = max(_dirtyEnd, first + count);
+}
+/* The dirty range alone says what changed since the last sent frame only when the back buffer
+** held that frame, nothing was written behind the setters' back and the encoding is unchanged.
+** Dithered and power limited output depends on more than the pixels, those always re-encode.
+** A zero budget only estimates : the wire bytes are the frame's, the estimate reads them whole */
+template <typename Format>
+bool LedStripImpl<Format>::rangeTracked() const
+{
+    return !_directWrites && _backInSync && !_pipelineDirty && _brightness == _pipelineBrightness
+        && !_front16 && (!_powerMeter || !_power.budget_mA) && _map.identity();
+}
+template <typename Format>
+void LedStripImpl<Format>::setRemap(const uint16_t* phys_to_logical, int logical_length)
+{
+    _map.remap = phys_to_logical;
+    _totSize = phys_to_logical ? min(logical_length, _physSize) : _physSize;
+    // the wire bytes follow the old map, the unchanged pixels say nothing about them
+    _directWrites = true;
+}
+template <typename Format>
+void LedStripImpl<Format>::setRotationRanges(const RotationRange* ranges, int count)
+{
+    // an empty range or one past the buffer rejects the whole set, the current ranges stay
+    count = clamp(count, 0, int(PixelMap::MaxRanges));
+    for (int i=0;i<count;++i) {
+        if (!ranges[i].count || ranges[i].first + ranges[i].count > _totSize) return;
+    }
+    _map.num_ranges = count;
+    for (int i=0;i<_map.num_ranges;++i) {
+        _map.ranges[i] = ranges[i];
+    }
+    _directWrites = true;
+}
+template <typename Format>
+void LedStripImpl<Format>::setRotation(int range, int offset)
+{
+    if (range < 0 || range >= _map.num_ranges) return;
+    auto & rr = _map.ranges[range];
+    offset %= int(rr.count);
+    rr.offset = uint16_t(offset < 0 ? offset + rr.count : offset);
+}
+template <typename Format>
+void LedStripImpl<Format>::setHdrBuffers(RGB16* front, RGB16* back)
+{
+    _front16 = front;
+    _back16 = back;
+    _front = _back = nullptr;
+    _pipelineDirty = true;
+}
+template <typename Format>
+void LedStripImpl<Format>::setPixelsRGB(int first, int count, const RGB* rgb)
+{
+    count = min(count, _totSize - first);
+    markDirty(first, count);
+    if (_back16)
+    {
+        for (int i=0; i<count; ++i) {
+            _back16[first + i] = RGB16::fromRGB(rgb[i]);
+        }
+        return;
+    }
+    memcpy(_back + first, rgb, count * sizeof(RGB));
+}
+template <typename Format>
+void LedStripImpl<Format>::fillPixelsRGB(int first, int count, const RGB& rgb)
+{
+    count = min(count, _totSize - first);
+    markDirty(first, count);
+    if (_back16)
+    {
+        auto * ptr = _back16 + first;
+        const auto c = RGB16::fromRGB(rgb);
+        while(count--) *ptr++ = c;
+        return;
+    }
+    auto * ptr = _back + first;
+    while(count--) *ptr++ = rgb;
+}
+template <typename Format>
+void LedStripImpl<Format>::setPixelsHSV(int first, int count, const HSV* hsv)
+{
+    count = min(count, _totSize - first);
+    // converted in chunks, each one stored like setPixelsRGB
+    constexpr int Chunk = 32;
+    RGB rgb[Chunk];
+    for (int done=0; done<count; done+=Chunk)
+    {
+        const int n = min(Chunk, count - done);
+        hsvToRgb(hsv + done, rgb, n);
+        setPixelsRGB(first + done, n, rgb);
+    }
+}
+template <typename Format>
+PixelSpan LedStripImpl<Format>::writeSpan(int first, int count)
+{
+    // hdr strips take the setters, they convert to 16 bit
+    if (!_back || first < 0 || first >= _totSize) return {nullptr, 0};
+    count = min(count, _totSize - first);
+    markDirty(first, count);
+    return {_back + first, count};
+}
+template <typename Format>
+void LedStripImpl<Format>::setBrightness(uint8_t brightness)
+{
+    // the pipelines follow when a frame refreshed with it is sent
+    _brightness = brightness;
+}
+template <typename Format>
+FrameState LedStripImpl<Format>::snapshot() const
+{
+    FrameState st;
+    st.brightness = _brightness;
+    for (int r=0;r<_map.num_ranges;++r) {
+        st.offsets[r] = _map.ranges[r].offset;
+    }
+    return st;
+}
+template <typename Format>
+void LedStripImpl<Format>::setInterpolationBuffers(RGB* mem)
+{
+    _interp.init(mem, _physSize);
+    _interpolate = true;
+}
+template <typename Format>
+void LedStripImpl<Format>::setFrameQueue(RGB* mem, int slots, Yield yield)
+{
+    _queue.init(mem, slots, _physSize);
+    _front = _back = _queue.producerSlot();
+    _yield = yield;
+    _queued = true;
+}
+template <typename Format>
+void LedStripImpl<Format>::refresh(bool wait)
+{
+    if (_queued)
+    {
+        // never touches the drivers, they belong to the output task
+        const FrameState st = snapshot();
+        if (!_queue.tryCommit(_clock(), st))
+        {
+            ++_stats.queue_full;
+            do { _yield(); } while (!_queue.tryCommit(_clock(), st));
+        }
+        _front = _back = _queue.producerSlot();
+        _dirtyFirst = _dirtyEnd = 0;
+        if (wait) {
+            while (_queue.size()) _yield();
+        }
+        return;
+    }
+    if (_interpolate)
+    {
+        // only hands the frame over, outputFrame sends it. The map is applied here, so the
+        // rotation and remap are the ones of this frame and the blend is between physical frames
+        std::swap(_front, _back);
+        if (_map.identity()) _interp.push(_front, _clock(), snapshot());
+        else
+        {
+            _map.apply(_front, _interp.producerSlot(), _physSize);
+            _interp.commit(_clock(), snapshot());
+        }
+        _dirtyFirst = _dirtyEnd = 0;
+        _backInSync = _front == _back;
+        return;
+    }
+    // wire buffers belong to the drivers until the previous frame is out
+    if (_statsPending) {
+        waitReady(1000);
+    }
+    const bool tracked = rangeTracked();
+    std::swap(_front, _back);
+    std::swap(_front16, _back16);
+    send(_front, _front16, tracked, _map, snapshot());
+    _dirtyFirst = _dirtyEnd = 0;
+    _directWrites = false;
+    _backInSync = _front == _back;
+    if (wait) {
+        waitReady(1000);
+    }
+}
+template <typename Format>
+bool LedStripImpl<Format>::outputFrame()
+{
+    if (_queued)
+    {
+        const RGB *frame = _queue.peek();
+        if (!frame) return false;
+        if (_statsPending) {
+            waitReady(1000);
+        }
+        // the rotation of the frame on the ranges and remap set up with the strip
+        const FrameState & st = _queue.peekState();
+        _outMap.remap = _map.remap;
+        _outMap.num_ranges = _map.num_ranges;
+        for (int r=0;r<_outMap.num_ranges;++r) {
+            _outMap.ranges[r] = { _map.ranges[r].first, _map.ranges[r].count, st.offsets[r] };
+        }
+        // encoded into the wire buffers, the slot can go back to the renderer
+        send(frame, nullptr, false, _outMap, st);
+        _queue.pop();
+        _stats.queued = _queue.size();
+        return true;
+    }
+    if (!_interpolate) return false;
+    if (_statsPending) {
+        waitReady(1000);
+    }
+    const RGB *frame = _interp.output(_clock());
+    send(frame, nullptr, false, physical, _interp.outputState());
+    return true;
+}
+template <typename Format>
+void LedStripImpl<Format>::send(const RGB* frame, const RGB16* frame16, bool tracked, const PixelMap& map, const FrameState& state)
+{
+    if (_pipelineDirty || state.brightness != _pipelineBrightness)
+    {
+        // picked up at the frame boundary, all segments switch on the same frame
+        _pipelineDirty = false;
+        _pipelineBrightness = state.brightness;
+        for (int i=0;i<_nSegments;++i) {
+            _segments[i].pipeline.build(_segments[i].color, state.brightness, frame16 != nullptr);
+        }
+    }
+    // encode / queue every segment first, then kick all of them in a tight loop
+    // so the start skew is only the cost of start() and segments latch together
+    int first = 0;
+    for (int i=0;i<_nSegments;++i)
+    {
+        auto & s = _segments[i];
+        auto & st = _segStats[i];
+        st.bytes = Format::Bytes * s.num_leds;
+        if (tracked)
+        {
+            // pixels past the last changed one keep their color when the frame is cut short
+            const int from = clamp(_dirtyFirst - first, 0, s.num_leds);
+            const int to = clamp(_dirtyEnd - first, 0, s.num_leds);
+            st.bytes = from < to ? Format::Bytes * to : 0;
+            if (from < to)
+            {
+                // the wire bytes before from are still the ones sent last time
+                s.pipeline.encode<Format>(frame + first + from, to - from, s.wire + Format::Bytes * from);
+                s.hash_valid = false;
+            }
+        }
+        else if (!map.identity())
+        {
+            map.forEachRun(first, s.num_leds, [&](int src, int n, int offset) {
+                uint8_t *wire = s.wire + Format::Bytes * offset;
+                if (src < 0) memset(wire, 0, Format::Bytes * n);
+                else if (frame16) s.pipeline.encode<Format>(frame16 + src, n, wire, s.dither + Format::Bytes * offset);
+                else s.pipeline.encode<Format>(frame + src, n, wire);
+            });
+        }
+        else if (frame16) {
+            s.pipeline.encode<Format>(frame16 + first, s.num_leds, s.wire, s.dither);
+        } else {
+            s.pipeline.encode<Format>(frame + first, s.num_leds, s.wire);
+        }
+        first += s.num_leds;
+    }
+    if (_powerMeter) {
+        limitPower();
+    }
+    if (!tracked)
+    {
+        for (int i=0;i<_nSegments;++i)
+        {
+            auto & s = _segments[i];
+            const uint32_t h = wireHash(s.wire, Format::Bytes * s.num_leds);
+            if (s.hash_valid && h == s.hash) {
+                _segStats[i].bytes = 0;
+            }
+            s.hash = h;
+            s.hash_valid = true;
+        }
+    }
+    _stats.skipped_bytes = 0;
+    bool sending = false;
+    for (int i=0;i<_nSegments;++i)
+    {
+        auto & s = _segments[i];
+        _stats.skipped_bytes += Format::Bytes * s.num_leds - _segStats[i].bytes;
+        sending |= _segStats[i].bytes > 0;
+        s.driver->prepare(_segStats[i].bytes, s.wire);
+    }
+    _stats.total_skipped_bytes += _stats.skipped_bytes;
+    for (int i=0;i<_nSegments;++i)
+    {
+        if (0 == _segStats[i].bytes) continue;
+        _segStats[i].start_us = _clock();
+        _segments[i].driver->start();
+    }
+    _statsPending = sending;
+}
+// estimated on the encoded bytes, so gamma, brightness and dithering are accounted for
+template <typename Format>
+void LedStripImpl<Format>::limitPower()
+{
+    uint64_t channel_sums[3] = {};
+    uint64_t white_sum = 0;
+    for (int i=0;i<_nSegments;++i)
+    {
+        auto & s = _segments[i];
+        uint32_t sums[3] = {};
+        if constexpr (Format::White)
+        {
+            uint32_t white = 0;
+            sumWireBytes(s.wire, s.num_leds, sums, white);
+            white_sum += white;
+        }
+        else {
+            sumWireBytes(s.wire, s.num_leds, sums);
+        }
+        for (int k=0;k<3;++k) {
+            channel_sums[s.pipeline.channel[k]] += sums[k];
+        }
+    }
+    _stats.power_mA = estimateCurrent_mA(_power, channel_sums, _physSize, white_sum);
+    _stats.power_scale = powerScale(_power, _stats.power_mA, _physSize);
+    if (_stats.power_scale >= 256) return;
+    ++_stats.limited_frames;
+    for (int i=0;i<_nSegments;++i) {
+        scaleWireBytes(_segments[i].wire, Format::Bytes * _segments[i].num_leds, _stats.power_scale);
+    }
+}
+template <typename Format>
+bool LedStripImpl<Format>::waitReady(uint32_t timeout_ms)
+{
+    bool done = true;
+    for (int i=0;i<_nSegments;++i) {
+        done &= _segments[i].driver->wait(timeout_ms);
+    }
+    if (done && _statsPending)
+    {
+        _statsPending = false;
+        uint32_t first_start = 0, last_start = 0, first_done = 0, last_done = 0;
+        bool any = false;
+        for (int i=0;i<_nSegments;++i)
+        {
+            auto & st = _segStats[i];
+            if (0 == st.bytes) continue;    //skipped, keeps the timings of its last transmission
+            st.done_us = _segments[i].driver->doneTimestamp();
+            st.tx_us = st.done_us - st.start_us;
+            if (!any || int32_t(st.start_us - first_start) < 0) first_start = st.start_us;
+            if (!any || int32_t(st.start_us - last_start)  > 0) last_start  = st.start_us;
+            if (!any || int32_t(st.done_us  - first_done)  < 0) first_done  = st.done_us;
+            if (!any || int32_t(st.done_us  - last_done)   > 0) last_done   = st.done_us;
+            any = true;
+        }
+        _stats.start_skew_us = last_start - first_start;
+        _stats.latch_skew_us = last_done - first_done;
+        ++_stats.frames;
+    }
+    return done;
+}
+template <typename Format>
+void LedStripImpl<Format>::copyFrontToBack()
+{
+    _backInSync = true;
+    if (_back16) {
+        memcpy(_back16, _front16, sizeof(RGB16)*_physSize);
+    } else {
+        memcpy(_back, _front, sizeof(RGB)*_physSize);
+    }
+}
+template <typename Format>
+void LedStripImpl<Format>::release()
+{
+    for (int i=0;i<_nSegments;++i) {
+        // drivers are placement-new'ed into _rawMem, unload releases their resources
+        if (_segments[i].driver) _segments[i].driver->unload();
+    }
+    Mem::free(_rawMem);
+}
+template struct LedStripImpl<PixelRGB>;
+template struct LedStripImpl<PixelRGBW>;
+}
@@ -56,4 +56,18 @@ int16_t cos_16b(uint16_t theta)
 int8_t  cos_8b(uint8_t theta)
 {
     return sin_8b( theta + 64);
-}
\ No newline at end of file
+}
+uint16_t sqrt_32b(uint32_t v)
+{
+    if (!v) return 0;
+    uint32_t root = 0;
+    // highest even power of 4 below v, then branch free steps
+    for (uint32_t bit = 1u << ((31 - __builtin_clz(v)) & ~1); bit; bit >>= 2)
+    {
+        const uint32_t t = root + bit;
+        const uint32_t take = 0u - uint32_t(v >= t);
+        v -= t & take;
+        root = (root >> 1) + (bit & take);
+    }
+    return uint16_t(root);
+}
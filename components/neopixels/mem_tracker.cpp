@@ -0,0 +1,142 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mem_tracker.hpp>
+#ifndef UNIT_TEST
+#include <esp_heap_caps.h>
+#endif
+
+namespace Neopixel
+{
+namespace
+{
+    constexpr int NumTags = int(MemTag::Count);
+    // in front of every block, 8 bytes so the block keeps the allocator alignment
+    struct Header
+    {
+        uint32_t bytes;
+        uint8_t tag;
+        uint8_t pad[3];
+    };
+    static_assert(sizeof(Header) == 8);
+
+    struct Counters
+    {
+        std::atomic<uint32_t> current {0};
+        std::atomic<uint32_t> peak {0};
+        std::atomic<uint32_t> blocks {0};
+    };
+    Counters counters[NumTags];
+    std::atomic<uint32_t> failed {0};
+
+    MemPlace policy[NumTags] = {
+        MemPlace::Internal,     //Strip
+        MemPlace::Dma,          //Driver
+        MemPlace::Any,          //Layout
+        MemPlace::Any,          //Fire
+        MemPlace::Any,          //DigitalRain
+        MemPlace::Any,          //RandomWalk
+        MemPlace::Any,          //Particles
+        MemPlace::Any,          //Random
+    };
+    const char* names[NumTags] = { "strip", "driver", "layout", "fire", "digital_rain", "random_walk", "particles", "random" };
+
+    void* platformAlloc(size_t bytes, MemPlace place)
+    {
+#ifdef UNIT_TEST
+        (void)place;
+        return malloc(bytes);
+#else
+        switch (place)
+        {
+            case MemPlace::Internal: return heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            case MemPlace::Dma:      return heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+            default:                 return heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        }
+#endif
+    }
+    void platformFree(void *p)
+    {
+#ifdef UNIT_TEST
+        ::free(p);
+#else
+        heap_caps_free(p);
+#endif
+    }
+}
+namespace Mem
+{
+void* alloc(size_t bytes, MemTag tag, MemPlace place)
+{
+    if (place == MemPlace::Default) place = placement(tag);
+    auto *h = reinterpret_cast<Header*>(platformAlloc(sizeof(Header) + bytes, place));
+    if (!h)
+    {
+        failed.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    h->bytes = uint32_t(bytes);
+    h->tag = uint8_t(tag);
+    auto & c = counters[int(tag)];
+    const uint32_t now = c.current.fetch_add(uint32_t(bytes), std::memory_order_relaxed) + uint32_t(bytes);
+    uint32_t peak = c.peak.load(std::memory_order_relaxed);
+    while (now > peak && !c.peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+    c.blocks.fetch_add(1, std::memory_order_relaxed);
+    return h + 1;
+}
+void free(void *p)
+{
+    if (!p) return;
+    auto *h = reinterpret_cast<Header*>(p) - 1;
+    auto & c = counters[h->tag];
+    c.current.fetch_sub(h->bytes, std::memory_order_relaxed);
+    c.blocks.fetch_sub(1, std::memory_order_relaxed);
+    platformFree(h);
+}
+MemPlace placement(MemTag tag)
+{
+    return policy[int(tag)];
+}
+void setPlacement(MemTag tag, MemPlace place)
+{
+    policy[int(tag)] = place == MemPlace::Default ? MemPlace::Any : place;
+}
+TagStats stats(MemTag tag)
+{
+    const auto & c = counters[int(tag)];
+    return { c.current.load(std::memory_order_relaxed), c.peak.load(std::memory_order_relaxed),
+             c.blocks.load(std::memory_order_relaxed) };
+}
+uint32_t failures()
+{
+    return failed.load(std::memory_order_relaxed);
+}
+const char* name(MemTag tag)
+{
+    return int(tag) < NumTags ? names[int(tag)] : "?";
+}
+void resetPeaks()
+{
+    for (auto & c : counters) c.peak.store(c.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+int report(char *buffer, int size)
+{
+    int len = 0;
+    auto put = [&](int n) { if (n > 0) len = len + n < size ? len + n : (size > 0 ? size - 1 : 0); };
+    for (int t=0;t<NumTags;++t)
+    {
+        const auto s = stats(MemTag(t));
+        put(snprintf(buffer + len, size - len, "%s %u %u %u\n", names[t], unsigned(s.current), unsigned(s.peak), unsigned(s.blocks)));
+    }
+    put(snprintf(buffer + len, size - len, "failed %u\n", unsigned(failures())));
+#ifndef UNIT_TEST
+    // how close the internal heap has come to running out
+    put(snprintf(buffer + len, size - len, "internal_free %u %u\ndma_largest %u\n",
+        unsigned(heap_caps_get_free_size(MALLOC_CAP_INTERNAL)),
+        unsigned(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL)),
+        unsigned(heap_caps_get_largest_free_block(MALLOC_CAP_DMA))));
+#endif
+    return len;
+}
+}
+}
@@ -1,9 +1,15 @@
 #include <cstring>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <driver/gpio.h>
+#include <soc/soc_caps.h>
 #include <esp_log.h>
 #include <neopixel.h>
+#include <color_pipeline.hpp>
+#include <power_limiter.hpp>
+#include <frame_queue.hpp>
+#include <strip_arena.hpp>
 #include <neopixel_app.h>
 #include <utils.hpp>
 #include <animation.hpp>
@@ -13,6 +19,19 @@
 using namespace Neopixel;
 uint32_t esp_random(void);
 
+namespace NeopixelApp
+{
+// set while a reconfigure swaps the strip, tasks using it stop at their next frame boundary
+static volatile bool park_animation = false, park_output = false;
+static SemaphoreHandle_t parked = nullptr;
+
+static void frame_boundary(volatile bool& park)
+{
+    if (!park) return;
+    xSemaphoreGive(parked);
+    vTaskSuspend(NULL);
+}
+}
 namespace Neopixel
 {
 void Animation::main(void*param)
@@ -21,6 +40,7 @@ void Animation::main(void*param)
     for(;;)
     {
         anim->step();
+        NeopixelApp::frame_boundary(NeopixelApp::park_animation);
         vTaskDelay(pdMS_TO_TICKS(anim->get_delay_ms()));
     }
 }
@@ -29,7 +49,37 @@ namespace NeopixelApp
 {
 ESP_EVENT_DEFINE_BASE(NEOPIXEL_EVENTS);
 TaskHandle_t animationTask = NULL;
+TaskHandle_t outputTask = NULL;
 LedStrip *strip = nullptr;
+// one rmt output shifts the 450 leds in ~27ms
+static constexpr int output_fps = 30;
+// 450 leds with interpolation take ~12k, leaves room for a longer chain or more outputs
+static constexpr uint32_t strip_region_bytes = 24 * 1024;
+static constexpr int max_segments = 8;
+static StripArena arena;
+
+// interpolating strip : blended frames at a fixed rate whatever the animation delay is
+static void output_main(void*)
+{
+    TickType_t last = xTaskGetTickCount();
+    for(;;)
+    {
+        strip->outputFrame();
+        frame_boundary(park_output);
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(1000 / output_fps));
+    }
+}
+// queued strip : frames go out as soon as they are rendered, the queue absorbs stalls of either side
+static void queue_main(void*)
+{
+    for(;;)
+    {
+        if (strip->outputFrame()) continue;
+        // only parks with the queue drained, no rendered frame is dropped
+        frame_boundary(park_output);
+        vTaskDelay(1);
+    }
+}
 
 class EspRandomGenerator : public RandomGenerator
 {
@@ -45,6 +95,11 @@ class EspRandomGenerator : public RandomGenerator
 EspRandomGenerator radomGen;
 Animation *currentAnimation = nullptr;
 static const char* TAG = "npx-app";
+// last CmdStartAnimation payload, replayed on the new strip after a reconfigure
+static uint8_t animation_cmd[64];
+static int animation_cmd_size = 0;
+// last CmdSetBrightness, carried over to the new strip after a reconfigure
+static uint8_t brightness = 255;
 
 static constexpr Strips rings { 8, {
         {0, 42, 0},
@@ -78,6 +133,11 @@ static constexpr Strips strips { 16, {
     }
 };
 
+// lines the animations see, clipped to the strip length after a reconfigure
+static const Strips* geometry = &strips;
+// ws2811 drives 18.5mA per channel, set budget_mA to the supply rating to enable the limiter
+static constexpr PowerBudget tree_power { 0, {18500,18500,18500}, 1000, 0 };
+
 esp_event_loop_handle_t create_event_loop()
 {
     esp_event_loop_args_t loop_args = {
@@ -114,9 +174,23 @@ static void execute_CmdSet(LedStrip *strip, void *data)
     }
 }
 
+static void execute_CmdSetBrightness(LedStrip *strip, void *data)
+{
+    brightness = decode<uint8_t>(data);
+    ESP_LOGI(TAG, "execute_CmdSetBrightness : %d", brightness);
+    strip->setBrightness(brightness);
+}
+
 static void execute_CmdStartAnimation(LedStrip *strip,void *data)
 {
+    void *payload = data;
     const uint16_t animation_id = decode<uint16_t>(data);
+    void *params = data;
+    const int size = 2 * sizeof(uint16_t) + decode<uint16_t>(params);
+    animation_cmd_size = size <= int(sizeof(animation_cmd)) ? size : 0;
+    if (animation_cmd_size) {
+        memcpy(animation_cmd, payload, animation_cmd_size);
+    }
 
     if (animationTask != NULL) {
         vTaskDelete(animationTask);
@@ -126,34 +200,150 @@ static void execute_CmdStartAnimation(LedStrip *strip,void *data)
         delete currentAnimation;
         currentAnimation = nullptr;
     }
-    currentAnimation = Animation::create(strip,animation_id, data, &strips,&radomGen);
+    currentAnimation = Animation::create(strip,animation_id, data, geometry,&radomGen);
     strip->fillPixelsRGB(0,strip->getLength(),{0,0,0});
     if (currentAnimation)
     {
         xTaskCreatePinnedToCore(Animation::main, "neopixel_animation", 2048, currentAnimation, 5, &animationTask, 1);
     }
 }
-static LedStrip* execute_CmdReconfigure(LedStrip *strip,void *data)
+static void start_output_task(const LedStripConfig& cfg)
 {
-#if 0
-    strip->release();
-    const uint8_t num_buffers = decode<uint8_t>(data);
-    const uint8_t num_segments = decode<uint8_t>(data);
-
-    for (int s=0;s<num_segments;++s)
+    if (cfg.interpolate) {
+        xTaskCreatePinnedToCore(output_main, "neopixel_output", 2048, nullptr, 6, &outputTask, 1);
+    } else if (cfg.num_buffers > 2) {
+        xTaskCreatePinnedToCore(queue_main, "neopixel_output", 2048, nullptr, 6, &outputTask, 1);
+    }
+}
+// animation first, so the output task can drain a frame queue behind it
+static void park_tasks()
+{
+    static constexpr TickType_t timeout = pdMS_TO_TICKS(2000);
+    if (animationTask)
     {
-        const uint16_t num_leds = decode<uint16_t>(data);
-        const uint8_t segment_type = decode<uint8_t>(data);
-        const uint8_t driver_type = decode<uint8_t>(data);
-        switch(driver_type)
-        case DriverType::RMT: {
-            const uint8_t gpio_num = decode<uint8_t>(data);
-            const uint8_t channel_num = decode<uint8_t>(data);
-            const uint8_t mem_block_num = decode<uint8_t>(data);
+        park_animation = true;
+        if (xSemaphoreTake(parked, timeout) != pdTRUE) ESP_LOGW(TAG, "animation did not reach a frame boundary");
+        vTaskDelete(animationTask);
+        animationTask = NULL;
+        park_animation = false;
+    }
+    if (outputTask)
+    {
+        park_output = true;
+        if (xSemaphoreTake(parked, timeout) != pdTRUE) ESP_LOGW(TAG, "output did not reach a frame boundary");
+        vTaskDelete(outputTask);
+        outputTask = NULL;
+        park_output = false;
+    }
+}
+static LedStrip* execute_CmdReconfigure(LedStrip *current,void *data)
+{
+    LedStripConfig cfg {};
+    cfg.num_buffers = decode<uint8_t>(data);
+    cfg.interpolate = decode<uint8_t>(data) & ReconfigureInterpolate;
+    cfg.pixel = PixelType(decode<uint8_t>(data));
+    cfg.num_segments = decode<uint8_t>(data);
+    cfg.power = &tree_power;
+    if (cfg.num_segments < 1 || cfg.num_segments > max_segments || cfg.num_buffers < 1 || cfg.num_buffers > FrameQueue::MaxSlots)
+    {
+        ESP_LOGE(TAG, "execute_CmdReconfigure : invalid %d segments %d buffers", cfg.num_segments, cfg.num_buffers);
+        return current;
+    }
+    LedSegmentConfig segments[max_segments];
+    union {
+        RMTDriverConfig rmt;
+        I2SDriverConfig i2s;
+        SPIDriverConfig spi;
+    } drivers[max_segments];
+    int num_leds = 0;
+    for (int s=0;s<cfg.num_segments;++s)
+    {
+        auto & seg = segments[s];
+        seg.num_leds = decode<uint16_t>(data);
+        seg.strip = SegmentType(decode<uint8_t>(data));
+        seg.driver = DriverType(decode<uint8_t>(data));
+        const auto gpio = gpio_num_t(decode<uint8_t>(data));
+        const uint8_t channel = decode<uint8_t>(data);
+        const uint8_t param = decode<uint8_t>(data);
+        // rmt channels borrow the memory blocks of the channels after them, spi1 is the flash,
+        // spi symbols are 3 or 4 bits
+        bool valid = GPIO_IS_VALID_OUTPUT_GPIO(gpio);
+        switch(seg.driver)
+        {
+            case DriverType::RMT:
+                valid = valid && channel < RMT_CHANNEL_MAX && param >= 1 && channel + param <= RMT_CHANNEL_MAX;
+                drivers[s].rmt = { gpio, rmt_channel_t(channel), param };
+                break;
+            case DriverType::I2C:
+                valid = valid && param >= 1 && param <= I2SDriverConfig::MaxLanes && channel < param;
+                drivers[s].i2s = { gpio, channel, param };
+                break;
+            case DriverType::SPI:
+                valid = valid && channel >= SPI2_HOST && channel < SOC_SPI_PERIPH_NUM && (param == 3 || param == 4);
+                drivers[s].spi = { gpio, spi_host_device_t(channel), param };
+                break;
+            default:
+                ESP_LOGE(TAG, "execute_CmdReconfigure : segment %d invalid driver %d", s, int(seg.driver));
+                return current;
         }
+        if (!valid)
+        {
+            ESP_LOGE(TAG, "execute_CmdReconfigure : segment %d driver %d invalid gpio %d channel %d param %d", s, int(seg.driver), int(gpio), channel, param);
+            return current;
+        }
+        seg.driver_config = &drivers[s];
+        seg.color = nullptr;
+        num_leds += seg.num_leds;
     }
-#endif
-    return strip;
+    cfg.segments = segments;
+    const uint32_t size = LedStrip::allocSize(cfg);
+    void *mem = arena.idle(size);
+    if (!mem)
+    {
+        ESP_LOGE(TAG, "execute_CmdReconfigure : %d leds need %d bytes, region has %d", num_leds, size, arena.regionBytes());
+        return current;
+    }
+    const Strips *next_geometry = clipStrips(&strips, num_leds);
+    if (!next_geometry)
+    {
+        ESP_LOGE(TAG, "execute_CmdReconfigure : no memory for the layout");
+        return current;
+    }
+    // built while the current animation keeps running, no peripheral is claimed yet
+    auto *next = LedStrip::createInPlace(cfg, mem);
+    if (!next)
+    {
+        ESP_LOGE(TAG, "execute_CmdReconfigure : strip not created");
+        release(const_cast<Strips*>(next_geometry));
+        return current;
+    }
+    next->setBrightness(brightness);
+    Animation *next_animation = nullptr;
+    if (animation_cmd_size)
+    {
+        void *d = animation_cmd;
+        const uint16_t animation_id = decode<uint16_t>(d);
+        next_animation = Animation::create(next, animation_id, d, next_geometry, &radomGen);
+    }
+    park_tasks();
+    // the old animation may still reset its strip when deleted, so before that strip is released
+    delete currentAnimation;
+    currentAnimation = nullptr;
+    // the last frame of the old strip is out, its peripherals go to the new one
+    current->waitReady(1000);
+    current->release();
+    LedStrip::attach(next, cfg);
+    arena.swap();
+    strip = next;
+    if (geometry != &strips) release(const_cast<Strips*>(geometry));
+    geometry = next_geometry;
+    currentAnimation = next_animation;
+    start_output_task(cfg);
+    if (currentAnimation) {
+        xTaskCreatePinnedToCore(Animation::main, "neopixel_animation", 2048, currentAnimation, 5, &animationTask, 1);
+    }
+    ESP_LOGI(TAG, "execute_CmdReconfigure : %d leds on %d segments, %d bytes", num_leds, cfg.num_segments, size);
+    return next;
 }
 #if 0
 static void start_default_animation(esp_event_loop_handle_t loop_handle)
@@ -214,6 +404,9 @@ static void neopixel_event_handler(void* handler_args, esp_event_base_t base, in
             ESP_LOGI(TAG, "neopixel_event_handler : CmdReconfigure");
             strip = execute_CmdReconfigure(strip,event_data);
             break;
+        case NeopixelApp::CmdSetBrightness:
+            execute_CmdSetBrightness(strip, event_data);
+            break;
         default:
             ESP_LOGE(TAG, "neopixel_event_handler : invalid command id %d", command_id);
     }
@@ -221,17 +414,35 @@ static void neopixel_event_handler(void* handler_args, esp_event_base_t base, in
 extern "C" void neopixel_main(void* params)
 {
     auto loop_handle = reinterpret_cast<esp_event_loop_handle_t>(params);
+    // every extra output takes a share of the chain, segments start at the first pixel of a line
 #if 0
+    // second string is a GRB one, gamma corrected and slightly less blue
+    static constexpr ColorCorrection grb { ColorOrder::GRB, true, {255,255,220} };
     RMTDriverConfig rmt[] = {{GPIO_NUM_16, RMT_CHANNEL_0, 4}, {GPIO_NUM_17, RMT_CHANNEL_4, 4}};
-    LedSegmentConfig segments[] = { {150, SegmentType::WS2811, DriverType::RMT, &rmt[0]},
-                                    {150, SegmentType::WS2811, DriverType::RMT, &rmt[1]} };
-    LedStripConfig cfg = {1,2,segments};
+    LedOutputConfig outputs[] = { {DriverType::RMT, &rmt[0], nullptr}, {DriverType::RMT, &rmt[1], &grb} };
 #else
-    RMTDriverConfig rmt = {GPIO_NUM_16, RMT_CHANNEL_0, 8};
-    LedSegmentConfig segment {450, SegmentType::WS2811, DriverType::RMT, &rmt};
-    LedStripConfig cfg = {1,1,&segment};
+    RMTDriverConfig rmt[] = {{GPIO_NUM_16, RMT_CHANNEL_0, 8}};
+    LedOutputConfig outputs[] = { {DriverType::RMT, &rmt[0], nullptr} };
 #endif
-    strip = LedStrip::create(cfg);
+    constexpr int num_outputs = sizeof(outputs)/sizeof(outputs[0]);
+    uint16_t cuts[strips.count];
+    for (int i=0;i<strips.count;++i) {
+        cuts[i] = strips.element[i].first;
+    }
+    LedChainConfig chain {450, SegmentType::WS2811, num_outputs, outputs, cuts, strips.count};
+    static_assert(num_outputs <= LedChainConfig::MaxOutputs);
+    LedSegmentConfig segments[num_outputs];
+    LedStripConfig cfg = {1, makeSegments(chain, segments), segments, false, &tree_power, true};
+    // reserved once, later strips are built in the other region
+    parked = xSemaphoreCreateCounting(2, 0);
+    const bool reserved = arena.init(strip_region_bytes);
+    void *mem = arena.idle(LedStrip::allocSize(cfg));
+    configASSERT(reserved && mem);
+    strip = LedStrip::createInPlace(cfg, mem);
+    configASSERT(strip);
+    LedStrip::attach(strip, cfg);
+    arena.swap();
+    start_output_task(cfg);
     ESP_ERROR_CHECK(esp_event_handler_instance_register_with(loop_handle, NEOPIXEL_EVENTS, ESP_EVENT_ANY_ID, neopixel_event_handler, NULL, NULL));
 
     start_default_animation(loop_handle);
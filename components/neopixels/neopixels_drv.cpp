@@ -2,77 +2,89 @@
 #include <string.h>
 #include <tuple>
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_intr_alloc.h>
+#include <driver/periph_ctrl.h>
+#include <soc/i2s_struct.h>
+#include <soc/i2s_reg.h>
+#include <esp32/rom/lldesc.h>
 #include <neopixel.h>
 #include <neopixel_drv.h>
 #include <math_utils.hpp>
+#include <led_strip_impl.hpp>
+#include <chain_partition.hpp>
+#include <rmt_translator.hpp>
+#include <rmt_refill.hpp>
+#include <i2s_parallel.hpp>
+#include <spi_encoder.hpp>
+#include <mem_tracker.hpp>
 
 using namespace Neopixel;
 using namespace NeopixelDrv;
 
 namespace NeopixelDrv
 {
-static rmt_item32_t ws2811_bits[2];
-static rmt_item32_t ws2812_bits[2];    
+static RmtTranslator ws2811_translator;
+static RmtTranslator ws2812_translator;
+static RmtTranslator sk6812_translator;
 
-static inline void IRAM_ATTR rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
-        size_t wanted_num, size_t *translated_size, size_t *item_num, const rmt_item32_t *bits)
+static RefillMonitor rmt_refill[RMT_CHANNEL_MAX];
+
+// the translator context is the channel monitor, stamped after the items are written
+static inline __attribute__((always_inline)) void rmt_monitor_refill(const size_t *item_num)
 {
-    if (src == NULL || dest == NULL) {
-        *translated_size = 0;
-        *item_num = 0;
-        return;
-    }
-    size_t size = 0;
-    size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
-    rmt_item32_t *pdest = dest;
-    while (size < src_size && num < wanted_num) 
-    {
-        for (int i = 0; i < 8; i++) 
-        {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bits[1].val;
-            } else {
-                pdest->val =  bits[0].val;
-            }
-            num++;
-            pdest++;
-        }
-        size++;
-        psrc++;
+    void *ctx = nullptr;
+    if (rmt_translator_get_context(item_num, &ctx) == ESP_OK && ctx) {
+        static_cast<RefillMonitor*>(ctx)->onTranslate(uint32_t(esp_timer_get_time()) * 1000);
     }
-    *translated_size = size;
-    *item_num = num;
 }
 
 static void IRAM_ATTR rmt_adapter_ws2811(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    rmt_adapter(src,dest,src_size,wanted_num,translated_size,item_num,ws2811_bits);
+    ws2811_translator.translate(src, &dest->val, src_size, wanted_num, translated_size, item_num);
+    rmt_monitor_refill(item_num);
 }
 
 static void IRAM_ATTR rmt_adapter_ws2812(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    rmt_adapter(src,dest,src_size,wanted_num,translated_size,item_num,ws2812_bits);
+    ws2812_translator.translate(src, &dest->val, src_size, wanted_num, translated_size, item_num);
+    rmt_monitor_refill(item_num);
+}
+
+static void IRAM_ATTR rmt_adapter_sk6812(const void *src, rmt_item32_t *dest, size_t src_size,
+        size_t wanted_num, size_t *translated_size, size_t *item_num)
+{
+    sk6812_translator.translate(src, &dest->val, src_size, wanted_num, translated_size, item_num);
+    rmt_monitor_refill(item_num);
+}
+
+static volatile uint32_t rmt_done_us[RMT_CHANNEL_MAX];
+
+static void IRAM_ATTR rmt_tx_end(rmt_channel_t channel, void *arg)
+{
+    rmt_done_us[channel] = uint32_t(esp_timer_get_time());
+    rmt_refill[channel].frameEnd();
 }
 
 static const Timing& get_timing(SegmentType type)
 {
-    static const Timing ws2811 { 500, 2000, 1200, 1300, 500 };
-    static const Timing ws2812 { 350, 1000, 1000,  350, 280 };
     switch(type) {
         default:
-        case SegmentType::WS2811: return ws2811;
-        case SegmentType::WS2812: return ws2812;
+        case SegmentType::WS2811: return Timing::ws2811();
+        case SegmentType::WS2812: return Timing::ws2812();
+        case SegmentType::SK6812: return Timing::sk6812();
     }
 }
 struct RMT : public Driver
 {
     RMT(gpio_num_t gpio_port, rmt_channel_t channel, int mem_block_num, SegmentType segType) :
-        tx_channel( channel)
+        tx_channel( channel), mem_items(mem_block_num * 64)
     {
         rmt_config_t config = RMT_DEFAULT_CONFIG_TX(gpio_port, tx_channel);
         // set counter clock to 40MHz
@@ -83,6 +95,7 @@ struct RMT : public Driver
         ESP_LOGI("drv","rmt_config done");
         ESP_ERROR_CHECK(rmt_driver_install(config.channel, 0, 0));
         ESP_LOGI("drv","rmt_driver_install done");
+        rmt_register_tx_end_callback(rmt_tx_end, nullptr);
         initTiming(segType);
         ESP_LOGI("drv","initTiming done");
     }
@@ -99,125 +112,408 @@ struct RMT : public Driver
         const auto t1l_ticks = (uint16_t)(ratio * tm.T1L_NS);
         reset_ticks          = (uint16_t)(ratio * tm.RESET_NS);
 
-        rmt_item32_t *bits;
+        const uint32_t bit0 = makeRmtItem(t0h_ticks, 1, t0l_ticks, 0); //Logical 0
+        const uint32_t bit1 = makeRmtItem(t1h_ticks, 1, t1l_ticks, 0); //Logical 1
+        // one item per bit, at the tick rounded durations
+        const uint32_t item_ns = uint32_t((t0h_ticks + t0l_ticks) / ratio);
+        rmt_refill[tx_channel].init(item_ns, mem_items);
+        rmt_translator_set_context(tx_channel, &rmt_refill[tx_channel]);
         switch(segType){
             default:
             case SegmentType::WS2811:
-                bits = ws2811_bits;
+                ws2811_translator.init(bit0, bit1);
                 rmt_translator_init(tx_channel, rmt_adapter_ws2811);
                 break;
             case SegmentType::WS2812:
-                bits = ws2812_bits;
+                ws2812_translator.init(bit0, bit1);
                 rmt_translator_init(tx_channel, rmt_adapter_ws2812);
                 break;
+            case SegmentType::SK6812:
+                sk6812_translator.init(bit0, bit1);
+                rmt_translator_init(tx_channel, rmt_adapter_sk6812);
+                break;
         }
-        bits[0] = {{{ t0h_ticks, 1, t0l_ticks, 0 }}}; //Logical 0
-        bits[1] = {{{ t1h_ticks, 1, t1l_ticks, 0 }}}; //Logical 1
     }
-    void write(int size, Neopixel::RGB* data, bool wait) override
+    // the translator fills the first memory block inside rmt_write_sample, with the table
+    // driven translator that is short enough to do it in start()
+    void prepare(int size, const uint8_t* data) override
+    {
+        pending = data;
+        pending_size = size;
+    }
+    void start() override
     {
-        ESP_ERROR_CHECK(rmt_write_sample(tx_channel, (uint8_t*)data, size * 3, wait));
+        rmt_refill[tx_channel].frameStart(uint32_t(pending_size) * RmtTranslator::ItemsPerByte);
+        ESP_ERROR_CHECK(rmt_write_sample(tx_channel, pending, pending_size, false));
     }
     bool wait(uint32_t timeout_ms) override
     {
-        return rmt_wait_tx_done(tx_channel, pdMS_TO_TICKS(timeout_ms)) == ESP_OK;
+        if (rmt_wait_tx_done(tx_channel, pdMS_TO_TICKS(timeout_ms)) != ESP_OK) return false;
+        const auto & rs = rmt_refill[tx_channel].stats;
+        if (rs.underruns != reported_underruns)
+        {
+            reported_underruns = rs.underruns;
+            ESP_LOGW("drv","rmt %d refill underrun, %d frames glitched, refill late by %d us", tx_channel,
+                     int(rs.glitched_frames), int(rs.frame_latency_ns / 1000));
+        }
+        return true;
     }
+    uint32_t doneTimestamp() const override { return rmt_done_us[tx_channel]; }
+    const RefillStats* refillStats() const override { return &rmt_refill[tx_channel].stats; }
     void unload() override
     {
         ESP_ERROR_CHECK(rmt_driver_uninstall(tx_channel));
     }
     const rmt_channel_t tx_channel;
+    const uint32_t mem_items;
+    uint32_t reported_underruns = 0;
     uint16_t reset_ticks;
+    const uint8_t* pending = nullptr;
+    int pending_size = 0;
 };
-}
 
-namespace Neopixel
+/* I2S1 in 16 bit LCD mode, sample bit n drives lane n (I2S1O_DATA_OUT8 + n).
+** All lanes are encoded into one DMA buffer and latch together, so the frame
+** time is set by the longest lane instead of the sum of all of them */
+struct I2SBus
 {
+    static constexpr int MaxLanes = I2SDriverConfig::MaxLanes;
+    static constexpr int BaseClockHz = 80000000;
+    static constexpr int MaxDescBytes = 4092;
+    static constexpr int SlotsPerBit = 3;
 
-struct SegmentInfo
-{
-    int num_leds;
-    Driver *driver;
-};
+    I2SBus(int num_lanes, SegmentType segType) : num_lanes(num_lanes)
+    {
+        const Timing& tm = get_timing(segType);
+        const int bit_ns  = tm.T0H_NS + tm.T0L_NS;
+        const int slots   = segType == SegmentType::WS2811 ? 2*SlotsPerBit : SlotsPerBit;
+        const int slot_ns = bit_ns / slots;
+        pattern.slots     = slots;
+        pattern.t0h_slots = (tm.T0H_NS + slot_ns/2) / slot_ns;
+        pattern.t1h_slots = (tm.T1H_NS + slot_ns/2) / slot_ns;
+        pattern.reset_slots = (tm.RESET_NS + slot_ns - 1) / slot_ns;
+        ready = xSemaphoreCreateBinary();
+        xSemaphoreGive(ready);
+        initPeripheral(1000000000 / slot_ns);
+        ESP_LOGI("drv","i2s bus lanes %d slots %d t0h %d t1h %d", num_lanes, pattern.slots, pattern.t0h_slots, pattern.t1h_slots);
+    }
+    ~I2SBus()
+    {
+        esp_intr_free(isr_handle);
+        periph_module_disable(PERIPH_I2S1_MODULE);
+        Mem::free(samples);
+        Mem::free(desc);
+        vSemaphoreDelete(ready);
+    }
+    void initPeripheral(int slot_rate_hz)
+    {
+        periph_module_enable(PERIPH_I2S1_MODULE);
+        I2S1.conf.tx_reset = 1;     I2S1.conf.tx_reset = 0;
+        I2S1.conf.rx_reset = 1;     I2S1.conf.rx_reset = 0;
+        I2S1.lc_conf.out_rst = 1;   I2S1.lc_conf.out_rst = 0;
+        I2S1.conf.tx_fifo_reset = 1;I2S1.conf.tx_fifo_reset = 0;
 
-struct LedStripImpl : public LedStrip
-{
-    LedStripImpl(int totSize, int nSegments, SegmentInfo* segments, RGB* front, RGB* back, void* rawMem) : 
-        _nSegments(nSegments), _totSize(totSize), _segments(segments), 
-        _front(front), _back(back),
-        _rawMem(rawMem)
-    {}
-    int getLength() const override { return _totSize; } 
-    RGB* getBuffer() override { return _back; }
-    void setPixelsRGB(int first, int count, const RGB* rgb) override
+        I2S1.conf2.val = 0;
+        I2S1.conf2.lcd_en = 1;
+        I2S1.sample_rate_conf.val = 0;
+        I2S1.sample_rate_conf.tx_bits_mod = 16;
+        I2S1.sample_rate_conf.tx_bck_div_num = 1;
+
+        // slot rate = 80MHz / (N + b/a)
+        const int div_x63 = int((int64_t(BaseClockHz) * 63) / slot_rate_hz);
+        I2S1.clkm_conf.val = 0;
+        I2S1.clkm_conf.clka_en = 0;
+        I2S1.clkm_conf.clkm_div_num = div_x63 / 63;
+        I2S1.clkm_conf.clkm_div_b = div_x63 % 63;
+        I2S1.clkm_conf.clkm_div_a = 63;
+
+        I2S1.fifo_conf.val = 0;
+        I2S1.fifo_conf.tx_fifo_mod_force_en = 1;
+        I2S1.fifo_conf.tx_fifo_mod = 1;
+        I2S1.fifo_conf.tx_data_num = 32;
+        I2S1.fifo_conf.dscr_en = 1;
+        I2S1.conf1.val = 0;
+        I2S1.conf1.tx_stop_en = 0;
+        I2S1.conf1.tx_pcm_bypass = 1;
+        I2S1.conf_chan.val = 0;
+        I2S1.conf_chan.tx_chan_mod = 1;
+        I2S1.conf.tx_right_first = 1;
+        I2S1.timing.val = 0;
+        I2S1.lc_conf.val = 0;
+        I2S1.lc_conf.out_eof_mode = 1;
+
+        I2S1.int_clr.val = I2S1.int_raw.val;
+        I2S1.int_ena.val = 0;
+        I2S1.int_ena.out_total_eof = 1;
+        ESP_ERROR_CHECK(esp_intr_alloc(ETS_I2S1_INTR_SOURCE, ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL3, &I2SBus::isr, this, &isr_handle));
+    }
+    void attachLane(int lane, gpio_num_t gpio)
     {
-        count = min(count, _totSize - first);
-        memcpy(_back + first, rgb, count * sizeof(RGB));
+        gpio_set_direction(gpio, GPIO_MODE_OUTPUT);
+        gpio_matrix_out(gpio, I2S1O_DATA_OUT8_IDX + lane, false, false);
     }
-    void fillPixelsRGB(int first, int count, const RGB& rgb) override
+    // the last lane to prepare encodes the whole frame, the first lane to start kicks the DMA
+    void prepare(int lane, int size, const uint8_t* data)
     {
-        count = min(count, _totSize - first);
-        auto * ptr = _back + first;
-        while(count--) *ptr++ = rgb;
+        lanes[lane] = data;
+        lane_bytes[lane] = size;
+        if (++pending == num_lanes)
+        {
+            pending = 0;
+            encode();
+        }
     }
-    void setPixelsHSV(int first, int count, const HSV* hsv) override
+    void encode()
     {
-        count = min(count, _totSize - first);
-        for (int i=0; i<count; ++i) {
-            _back[first + i] = hsv[i].toRGB();
+        size_t max_bytes = 0;
+        for (int l=0;l<num_lanes;++l) {
+            if (lane_bytes[l] > max_bytes) max_bytes = lane_bytes[l];
+        }
+        if (0 == max_bytes) return;     //no lane changed, nothing is started either
+        xSemaphoreTake(ready, portMAX_DELAY);
+        if (!reserve(i2sParallelSamples(max_bytes, pattern)))
+        {
+            // frame dropped, the bus stays ready with its previous buffers
+            ESP_LOGE("drv", "i2s parallel : no dma memory for %d bytes per lane", int(max_bytes));
+            xSemaphoreGive(ready);
+            return;
         }
+        const size_t n = encodeI2SParallel<uint16_t>(lanes, lane_bytes, num_lanes, pattern, samples);
+        linkDescriptors(n * sizeof(uint16_t));
+        encoded = true;
     }
-    void refresh(bool wait) override
+    void start()
     {
-        RGB *data = _back;
-        _back = _front;
-        _front = data;
-        for (int i=0;i<_nSegments;++i)
+        if (!encoded) return;
+        encoded = false;
+        I2S1.lc_conf.out_rst = 1;   I2S1.lc_conf.out_rst = 0;
+        I2S1.conf.tx_fifo_reset = 1;I2S1.conf.tx_fifo_reset = 0;
+        I2S1.out_link.addr = uint32_t(desc);
+        I2S1.out_link.start = 1;
+        I2S1.conf.tx_start = 1;
+    }
+    bool wait(uint32_t timeout_ms)
+    {
+        if (xSemaphoreTake(ready, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) return false;
+        xSemaphoreGive(ready);
+        return true;
+    }
+    // false when the dma memory is not there, the previous buffers and capacity are kept
+    bool reserve(size_t n_samples)
+    {
+        if (n_samples <= capacity) return true;
+        const size_t bytes = n_samples * sizeof(uint16_t);
+        const size_t new_n_desc = (bytes + MaxDescBytes - 1) / MaxDescBytes;
+        auto *new_samples = Mem::alloc<uint16_t>(n_samples, MemTag::Driver, MemPlace::Dma);
+        auto *new_desc = Mem::alloc<lldesc_t>(new_n_desc, MemTag::Driver, MemPlace::Dma);
+        if (!new_samples || !new_desc)
         {
-            auto & s = _segments[i];
-            s.driver->write(s.num_leds, data);
-            data += s.num_leds;
+            Mem::free(new_samples);
+            Mem::free(new_desc);
+            return false;
         }
-        if (wait) {
-            waitReady(1000);
+        Mem::free(samples);
+        Mem::free(desc);
+        samples = new_samples;
+        desc = new_desc;
+        n_desc = new_n_desc;
+        capacity = n_samples;
+        return true;
+    }
+    void linkDescriptors(size_t bytes)
+    {
+        auto *buf = reinterpret_cast<uint8_t*>(samples);
+        int i = 0;
+        while (bytes > 0)
+        {
+            const size_t len = min(bytes, size_t(MaxDescBytes));
+            auto & d = desc[i];
+            d.size = len;
+            d.length = len;
+            d.offset = 0;
+            d.sosf = 0;
+            d.owner = 1;
+            d.buf = buf;
+            bytes -= len;
+            buf += len;
+            d.eof = bytes == 0 ? 1 : 0;
+            d.qe.stqe_next = bytes == 0 ? nullptr : &desc[i+1];
+            ++i;
+        }
+    }
+    static void IRAM_ATTR isr(void* arg)
+    {
+        auto *bus = reinterpret_cast<I2SBus*>(arg);
+        if (I2S1.int_st.out_total_eof)
+        {
+            I2S1.conf.tx_start = 0;
+            I2S1.out_link.stop = 1;
+            bus->done_us = uint32_t(esp_timer_get_time());
+            BaseType_t woken = pdFALSE;
+            xSemaphoreGiveFromISR(bus->ready, &woken);
+            if (woken) portYIELD_FROM_ISR();
         }
+        I2S1.int_clr.val = I2S1.int_st.val;
     }
-    bool waitReady(uint32_t timeout_ms) override
+
+    const int num_lanes;
+    int pending = 0;
+    int attached = 0;
+    bool encoded = false;
+    volatile uint32_t done_us = 0;
+    I2SBitPattern pattern;
+    const uint8_t* lanes[MaxLanes] = {};
+    size_t lane_bytes[MaxLanes] = {};
+    uint16_t *samples = nullptr;
+    lldesc_t *desc = nullptr;
+    size_t capacity = 0, n_desc = 0;
+    SemaphoreHandle_t ready;
+    intr_handle_t isr_handle;
+};
+static I2SBus* i2s_bus = nullptr;
+
+struct I2SLane : public Driver
+{
+    I2SLane(gpio_num_t gpio, int lane, int num_lanes, SegmentType segType) : lane(lane)
     {
-        bool done = true;
-        for (int i=0;i<_nSegments;++i) {
-            done &= _segments[i].driver->wait(timeout_ms);
+        if (!i2s_bus)
+        {
+            // counted with the other driver memory, internal as the isr reads it
+            void *mem = Mem::alloc(sizeof(I2SBus), MemTag::Driver, MemPlace::Internal);
+            if (!mem) {
+                ESP_LOGE("drv","i2s lane %d : no memory for the bus, nothing is sent", lane);
+                return;
+            }
+            i2s_bus = new (mem) I2SBus(num_lanes, segType);
         }
-        return done;
+        bus = i2s_bus;
+        bus->attachLane(lane, gpio);
+        ++bus->attached;
+    }
+    void prepare(int size, const uint8_t* data) override
+    {
+        if (bus) bus->prepare(lane, size, data);
     }
-    void copyFrontToBack() override
+    void start() override
     {
-        memcpy(_back, _front, sizeof(RGB)*_totSize);
+        if (bus) bus->start();
     }
-    void release() override
+    bool wait(uint32_t timeout_ms) override
     {
-        for (int i=0;i<_nSegments;++i) {
-            _segments[i].driver->unload();
-            //TODO: remove when in-place driver new will be fixed
-            delete reinterpret_cast<NeopixelDrv::RMT*>(_segments[i].driver);
+        return !bus || bus->wait(timeout_ms);
+    }
+    uint32_t doneTimestamp() const override { return bus ? bus->done_us : 0; }
+    void unload() override
+    {
+        if (bus && --bus->attached == 0)
+        {
+            bus->wait(1000);
+            bus->~I2SBus();
+            Mem::free(bus);
+            i2s_bus = nullptr;
         }
-        free(_rawMem);
+        bus = nullptr;
     }
+    const int lane;
+    I2SBus* bus = nullptr;     //nullptr when the bus could not be allocated
+};
+
+/* Frames are encoded in task context into a preallocated DMA buffer and sent as one
+** SPI transaction, nothing runs in an ISR per bit */
+struct SPI : public Driver
+{
+    SPI(gpio_num_t gpio, spi_host_device_t host, int bits_per_symbol, int num_bytes, SegmentType segType) :
+        host(host)
+    {
+        encoder.init(SpiBitPattern::fromTiming(get_timing(segType), bits_per_symbol));
+        capacity = encoder.pattern.frameBytes(num_bytes);
+        buffer = Mem::alloc<uint8_t>(capacity, MemTag::Driver, MemPlace::Dma);
+        // the buffer holds the encoding of num_bytes, every source byte takes bits_per_symbol
+        source_bytes = buffer ? num_bytes : 0;
+        if (!buffer) ESP_LOGE("drv","spi : no dma memory for %d bytes, nothing is sent", int(capacity));
 
-    int _nSegments, _totSize;
-    const SegmentInfo* _segments;
-    RGB *_front, *_back;
-    void* _rawMem;
+        spi_bus_config_t bus = {};
+        bus.mosi_io_num = gpio;
+        bus.miso_io_num = -1;
+        bus.sclk_io_num = -1;
+        bus.quadwp_io_num = -1;
+        bus.quadhd_io_num = -1;
+        bus.max_transfer_sz = capacity;
+        ESP_ERROR_CHECK(spi_bus_initialize(host, &bus, SPI_DMA_CH_AUTO));
+
+        spi_device_interface_config_t dev = {};
+        dev.clock_speed_hz = encoder.pattern.clock_hz;
+        dev.mode = 0;
+        dev.spics_io_num = -1;
+        dev.queue_size = 1;
+        dev.post_cb = spi_tx_end;
+        ESP_ERROR_CHECK(spi_bus_add_device(host, &dev, &device));
+        ESP_LOGI("drv","spi clock %d bits per symbol %d buffer %d", encoder.pattern.clock_hz, bits_per_symbol, capacity);
+    }
+    static void IRAM_ATTR spi_tx_end(spi_transaction_t *t)
+    {
+        reinterpret_cast<SPI*>(t->user)->done_us = uint32_t(esp_timer_get_time());
+    }
+    void prepare(int size, const uint8_t* data) override
+    {
+        wait(portMAX_DELAY);
+        if (0 == size) return;
+        transaction = {};
+        if (!buffer) return;
+        const size_t n = encoder.encode(data, min(size_t(size), source_bytes), buffer);
+        transaction.length = n * 8;
+        transaction.tx_buffer = buffer;
+        transaction.user = this;
+    }
+    void start() override
+    {
+        if (!transaction.tx_buffer) return;
+        ESP_ERROR_CHECK(spi_device_queue_trans(device, &transaction, portMAX_DELAY));
+        in_flight = true;
+    }
+    bool wait(uint32_t timeout_ms) override
+    {
+        if (!in_flight) return true;
+        spi_transaction_t *done;
+        const TickType_t ticks = timeout_ms == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+        if (spi_device_get_trans_result(device, &done, ticks) != ESP_OK) return false;
+        in_flight = false;
+        return true;
+    }
+    uint32_t doneTimestamp() const override { return done_us; }
+    void unload() override
+    {
+        wait(1000);
+        ESP_ERROR_CHECK(spi_bus_remove_device(device));
+        ESP_ERROR_CHECK(spi_bus_free(host));
+        Mem::free(buffer);
+    }
+    const spi_host_device_t host;
+    spi_device_handle_t device;
+    spi_transaction_t transaction = {};
+    SpiEncoder encoder;
+    uint8_t *buffer;
+    size_t capacity;        //encoded bytes
+    size_t source_bytes;    //frame bytes they encode
+    bool in_flight = false;
+    volatile uint32_t done_us = 0;
 };
+}
+
+namespace Neopixel
+{
 
 static uint32_t calc_led_driver_size(DriverType type)
 {
     switch(type){
         case DriverType::RMT : return sizeof(NeopixelDrv::RMT);
+        case DriverType::I2C : return sizeof(NeopixelDrv::I2SLane);
+        case DriverType::SPI : return sizeof(NeopixelDrv::SPI);
         default: return 0;
     }
 }
 
+template <typename Format>
 static std::tuple<uint32_t,uint32_t> calc_alloc_size(const LedStripConfig& cfg)
 {
     uint32_t total_alloc_size = 0;
@@ -227,14 +523,22 @@ static std::tuple<uint32_t,uint32_t> calc_alloc_size(const LedStripConfig& cfg)
         auto & segment = cfg.segments[i];
         total_led_count += segment.num_leds;
         total_alloc_size += calc_led_driver_size(segment.driver);
-        total_alloc_size += sizeof(SegmentInfo);
+        total_alloc_size += sizeof(SegmentInfo) + sizeof(SegmentStats);
+    }
+    if (cfg.hdr) {
+        total_alloc_size += cfg.num_buffers * sizeof(RGB16) * total_led_count;
+        total_alloc_size += Format::Bytes * total_led_count;    //dither residuals
+        total_alloc_size += sizeof(ColorPipeline::Lut16) * cfg.num_segments;
+    } else {
+        total_alloc_size += cfg.num_buffers * sizeof(RGB) * total_led_count;
+        if (cfg.interpolate) total_alloc_size += FrameInterpolator::Buffers * sizeof(RGB) * total_led_count;
     }
-    total_alloc_size += cfg.num_buffers * sizeof(RGB) * total_led_count;
-    total_alloc_size += sizeof(LedStripImpl);
+    total_alloc_size += Format::Bytes * total_led_count;    //encoded wire bytes
+    total_alloc_size += sizeof(LedStripImpl<Format>) + 2 * alignof(LedStripImpl<Format>);
     return {total_alloc_size, total_led_count};
 }
 
-static NeopixelDrv::Driver* create_driver(const LedSegmentConfig& cfg, uint8_t*& raw_mem)
+static NeopixelDrv::Driver* create_driver(const LedSegmentConfig& cfg, int pixel_bytes, uint8_t*& raw_mem)
 {
     switch(cfg.driver) 
     {
@@ -245,25 +549,129 @@ static NeopixelDrv::Driver* create_driver(const LedSegmentConfig& cfg, uint8_t*&
             raw_mem += sizeof(NeopixelDrv::RMT);
             return drv;
         }
+        case DriverType::I2C:
+        {
+            const auto & i2s_cfg = *reinterpret_cast<I2SDriverConfig*>(cfg.driver_config);
+            auto * drv = new (raw_mem) NeopixelDrv::I2SLane(i2s_cfg.gpio, i2s_cfg.lane, i2s_cfg.num_lanes, cfg.strip);
+            raw_mem += sizeof(NeopixelDrv::I2SLane);
+            return drv;
+        }
+        case DriverType::SPI:
+        {
+            const auto & spi_cfg = *reinterpret_cast<SPIDriverConfig*>(cfg.driver_config);
+            auto * drv = new (raw_mem) NeopixelDrv::SPI(spi_cfg.gpio, spi_cfg.host, spi_cfg.bits_per_symbol, cfg.num_leds * pixel_bytes, cfg.strip);
+            raw_mem += sizeof(NeopixelDrv::SPI);
+            return drv;
+        }
         default:
             return nullptr;
     }
 }
 
-LedStrip* LedStrip::create(const LedStripConfig& cfg)
+int makeSegments(const LedChainConfig& cfg, LedSegmentConfig* segments)
 {
-    auto [total_size,total_led_count] = calc_alloc_size(cfg);
-    void* raw_mem = malloc(total_size);
-    memset(raw_mem, 0xcd, total_size);
-    auto *next_ptr = reinterpret_cast<uint8_t*>(raw_mem);
+    if (cfg.num_outputs < 1 || cfg.num_outputs > LedChainConfig::MaxOutputs)
+    {
+        ESP_LOGE("drv","%d outputs, 1 to %d supported", cfg.num_outputs, LedChainConfig::MaxOutputs);
+        return 0;
+    }
+    ChainPart parts[LedChainConfig::MaxOutputs];
+    const int n = partitionChain(cfg.num_leds, cfg.num_outputs, cfg.cuts, cfg.num_cuts, parts);
+    const auto fm = modelFrameTime(parts, n, get_timing(cfg.strip), true, 0, pixelBytes(cfg.pixel));
+    for (int i=0;i<n;++i)
+    {
+        const auto & out = cfg.outputs[i];
+        segments[i] = { parts[i].count, cfg.strip, out.driver, out.driver_config, out.color };
+        ESP_LOGI("drv","segment %d first %d count %d", i, parts[i].first, parts[i].count);
+    }
+    ESP_LOGI("drv","%d leds on %d outputs, modelled frame %d us, %d fps", cfg.num_leds, n, fm.frame_ns/1000, int(fm.fps));
+    return n;
+}
+
+// byte sized wire buffers leave the pointer unaligned, xtensa faults on unaligned 16/32 bit access
+static uint8_t* align_ptr(uint8_t* p)
+{
+    constexpr uintptr_t a = alignof(LedStripImpl<>);
+    return reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(p) + a - 1) & ~(a - 1));
+}
+
+static uint32_t clock_us()
+{
+    return uint32_t(esp_timer_get_time());
+}
+
+static void yield_tick()
+{
+    vTaskDelay(1);
+}
+
+// drivers follow the segment stats, attach constructs them there
+template <typename Format>
+static void attach_drivers(LedStripImpl<Format>* strip, const LedStripConfig& cfg)
+{
+    auto *next_ptr = reinterpret_cast<uint8_t*>(strip->_segStats + strip->_nSegments);
+    for (int s=0;s<cfg.num_segments;++s)
+    {
+        auto & seg = strip->_segments[s];
+        seg.driver = create_driver(cfg.segments[s], Format::Bytes, next_ptr);
+        // only once the strip exists, its constructor clears the segment stats
+        strip->_segStats[s].refill = seg.driver->refillStats();
+    }
+}
+
+// raw_mem is what release frees, nullptr for strips placed in memory the caller owns
+template <typename Format>
+static LedStripImpl<Format>* create_strip(const LedStripConfig& cfg, void* mem, void* raw_mem)
+{
+    const uint32_t total_led_count = std::get<1>(calc_alloc_size<Format>(cfg));
+    auto *next_ptr = reinterpret_cast<uint8_t*>(mem);
     auto *segments = reinterpret_cast<SegmentInfo*>(next_ptr);
     next_ptr += sizeof(SegmentInfo)*cfg.num_segments;
+    auto *stats = reinterpret_cast<SegmentStats*>(next_ptr);
+    next_ptr += sizeof(SegmentStats)*cfg.num_segments;
+    for (int s=0;s<cfg.num_segments;++s)
+    {
+        auto & seg = cfg.segments[s];
+        segments[s].num_leds = seg.num_leds;
+        segments[s].driver = nullptr;
+        segments[s].color = seg.color ? *seg.color : NoCorrection;
+        segments[s].pipeline.lut16 = nullptr;
+        next_ptr += calc_led_driver_size(seg.driver);
+    }
     for (int s=0;s<cfg.num_segments;++s)
     {
-        segments[s].num_leds = cfg.segments[s].num_leds;
-        segments[s].driver = create_driver(cfg.segments[s], next_ptr);
+        segments[s].wire = next_ptr;
+        next_ptr += Format::Bytes * segments[s].num_leds;
+        segments[s].dither = nullptr;
+        if (cfg.hdr)
+        {
+            segments[s].dither = next_ptr;
+            memset(next_ptr, 0, Format::Bytes * segments[s].num_leds);
+            next_ptr += Format::Bytes * segments[s].num_leds;
+        }
+    }
+    next_ptr = align_ptr(next_ptr);
+    if (cfg.hdr)
+    {
+        RGB16* front = reinterpret_cast<RGB16*>(next_ptr);
+        memset(front, 0, sizeof(RGB16) * cfg.num_buffers * total_led_count);
+        next_ptr += sizeof(RGB16) * total_led_count;
+        RGB16* back = front;
+        if (2==cfg.num_buffers){
+            back = reinterpret_cast<RGB16*>(next_ptr);
+            next_ptr += sizeof(RGB16) * total_led_count;
+        }
+        // 16 bit tables per segment, 8 bit strips leave them out
+        auto* lut16 = reinterpret_cast<ColorPipeline::Lut16*>(next_ptr);
+        next_ptr += sizeof(ColorPipeline::Lut16) * cfg.num_segments;
+        for (int s=0;s<cfg.num_segments;++s) segments[s].pipeline.lut16 = &lut16[s];
+        auto *strip = new (align_ptr(next_ptr)) LedStripImpl<Format>(total_led_count, cfg.num_segments, segments, stats, nullptr, nullptr, raw_mem, clock_us);
+        strip->setHdrBuffers(front, back);
+        if (cfg.power) strip->setPowerBudget(*cfg.power);
+        return strip;
     }
     RGB* front = reinterpret_cast<RGB*>(next_ptr);
+    memset(front, 0, sizeof(RGB) * cfg.num_buffers * total_led_count);
     next_ptr += sizeof(RGB) * total_led_count;
     RGB *back;
     if (2==cfg.num_buffers){
@@ -272,6 +680,65 @@ LedStrip* LedStrip::create(const LedStripConfig& cfg)
     } else{
         back = front;
     }
-    return  new (next_ptr) LedStripImpl(total_led_count, cfg.num_segments, segments, front, back, raw_mem);
+    // the queue slots follow each other, front is the first one
+    const bool queued = cfg.num_buffers > 2 && !cfg.interpolate;
+    if (cfg.num_buffers > 2) next_ptr += sizeof(RGB) * (cfg.num_buffers - 1) * total_led_count;
+    RGB *interp = nullptr;
+    if (cfg.interpolate){
+        interp = reinterpret_cast<RGB*>(next_ptr);
+        next_ptr += sizeof(RGB) * FrameInterpolator::Buffers * total_led_count;
+    }
+    auto *strip = new (align_ptr(next_ptr)) LedStripImpl<Format>(total_led_count, cfg.num_segments, segments, stats, front, back, raw_mem, clock_us);
+    if (cfg.power) strip->setPowerBudget(*cfg.power);
+    if (interp) strip->setInterpolationBuffers(interp);
+    if (queued) strip->setFrameQueue(front, cfg.num_buffers, yield_tick);
+    return strip;
+}
+
+uint32_t LedStrip::allocSize(const LedStripConfig& cfg)
+{
+    switch(cfg.pixel)
+    {
+        case PixelType::RGBW: return std::get<0>(calc_alloc_size<PixelRGBW>(cfg));
+        default:
+        case PixelType::RGB:  return std::get<0>(calc_alloc_size<PixelRGB>(cfg));
+    }
+}
+
+LedStrip* LedStrip::createInPlace(const LedStripConfig& cfg, void* mem)
+{
+    if (!mem) return nullptr;
+    switch(cfg.pixel)
+    {
+        case PixelType::RGBW: return create_strip<PixelRGBW>(cfg, mem, nullptr);
+        default:
+        case PixelType::RGB:  return create_strip<PixelRGB>(cfg, mem, nullptr);
+    }
+}
+
+void LedStrip::attach(LedStrip* strip, const LedStripConfig& cfg)
+{
+    switch(cfg.pixel)
+    {
+        case PixelType::RGBW: attach_drivers(static_cast<LedStripImpl<PixelRGBW>*>(strip), cfg); break;
+        default:
+        case PixelType::RGB:  attach_drivers(static_cast<LedStripImpl<PixelRGB>*>(strip), cfg); break;
+    }
+}
+
+LedStrip* LedStrip::create(const LedStripConfig& cfg)
+{
+    // read by the output isr, kept in internal ram by the Strip policy
+    void* raw_mem = Mem::alloc(allocSize(cfg), MemTag::Strip);
+    if (!raw_mem) return nullptr;
+    LedStrip* strip;
+    switch(cfg.pixel)
+    {
+        case PixelType::RGBW: strip = create_strip<PixelRGBW>(cfg, raw_mem, raw_mem); break;
+        default:
+        case PixelType::RGB:  strip = create_strip<PixelRGB>(cfg, raw_mem, raw_mem); break;
+    }
+    attach(strip, cfg);
+    return strip;
 }
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include <neopixel_drv.h>
+
+namespace NeopixelDrv
+{
+// reset is the low time that latches the frame (datasheet minimum)
+const Timing& Timing::ws2811()
+{
+    static const Timing ws2811 { 500, 2000, 1200, 1300, 50000 };
+    return ws2811;
+}
+const Timing& Timing::ws2812()
+{
+    static const Timing ws2812 { 350, 1000, 1000,  350, 280000 };
+    return ws2812;
+}
+const Timing& Timing::sk6812()
+{
+    static const Timing sk6812 { 300, 900, 600, 600, 80000 };
+    return sk6812;
+}
+}
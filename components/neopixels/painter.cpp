@@ -0,0 +1,74 @@
+#include <painter.hpp>
+
+namespace Neopixel
+{
+namespace
+{
+    constexpr int32_t One = 1 << 16;
+    // a to b, t 0..One, rounded
+    inline RGB lerp(const RGB& a, const RGB& b, int32_t t)
+    {
+        return { uint8_t(a.r + (((int32_t(b.r) - a.r) * t + One / 2) >> 16)),
+                 uint8_t(a.g + (((int32_t(b.g) - a.g) * t + One / 2) >> 16)),
+                 uint8_t(a.b + (((int32_t(b.b) - a.b) * t + One / 2) >> 16)) };
+    }
+    // c * coverage added to the pixel
+    struct Add
+    {
+        RGB* pixels;
+        RGB c;
+        template <typename Index>
+        void operator()(Index i, uint32_t w) const
+        {
+            const RGB v { uint8_t(c.r * w >> 8), uint8_t(c.g * w >> 8), uint8_t(c.b * w >> 8) };
+            pixels[i] = sat_add(pixels[i], v);
+        }
+    };
+}
+template <typename Layout>
+void BasicPainter<Layout>::point(RGB* pixels, int32_t x, int32_t y, const RGB& c) const
+{
+    point(x, y, Add{pixels, c});
+}
+template <typename Layout>
+void BasicPainter<Layout>::line(RGB* pixels, int32_t x0, int32_t y0, int32_t x1, int32_t y1, const RGB& c) const
+{
+    line(x0, y0, x1, y1, Add{pixels, c});
+}
+template <typename Layout>
+void BasicPainter<Layout>::circle(RGB* pixels, int32_t cx, int32_t cy, int32_t r, bool filled, const RGB& c) const
+{
+    circle(cx, cy, r, filled, Add{pixels, c});
+}
+template <typename Layout>
+void BasicPainter<Layout>::linearGradient(RGB* pixels, int32_t x0, int32_t y0, const RGB& c0, int32_t x1, int32_t y1, const RGB& c1) const
+{
+    const int64_t dx = x1 - x0, dy = y1 - y0;
+    const int64_t len2 = dx * dx + dy * dy;
+    // t = One * dot / len2 with the divide taken once, rounded up so the far end reaches One
+    const uint64_t inv = len2 ? ((uint64_t(One) << 32) + len2 - 1) / len2 : 0;
+    const size_t total = map->totalPixels;
+    for (size_t i=0;i<total;++i)
+    {
+        if (map->x(Index(i)) == Map::Unmapped) continue;
+        const int64_t dot = (int64_t(map->x(Index(i))) - x0) * dx + (int64_t(map->y(Index(i))) - y0) * dy;
+        const uint64_t along = uint64_t(clamp<int64_t>(dot, 0, len2));
+        pixels[i] = lerp(c0, c1, len2 ? min(int32_t(along * inv >> 32), One) : One);
+    }
+}
+template <typename Layout>
+void BasicPainter<Layout>::radialGradient(RGB* pixels, int32_t cx, int32_t cy, int32_t r, const RGB& c0, const RGB& c1) const
+{
+    const uint64_t inv = r > 0 ? ((uint64_t(One) << 16) + r - 1) / r : 0;
+    const size_t total = map->totalPixels;
+    for (size_t i=0;i<total;++i)
+    {
+        if (map->x(Index(i)) == Map::Unmapped) continue;
+        const int32_t dx = int32_t(map->x(Index(i))) - cx, dy = int32_t(map->y(Index(i))) - cy;
+        const uint64_t d = sqrt_32b(uint32_t(dx * dx + dy * dy));
+        pixels[i] = lerp(c0, c1, r > 0 ? int32_t(min<uint64_t>(d * inv >> 16, One)) : One);
+    }
+}
+template class BasicPainter<CompactLayout>;
+template class BasicPainter<WideLayout>;
+}
@@ -0,0 +1,57 @@
+#include <power_limiter.hpp>
+
+namespace Neopixel
+{
+void sumWireBytes(const uint8_t* wire, int num_pixels, uint32_t sums[3])
+{
+    uint32_t s0 = 0, s1 = 0, s2 = 0;
+    for (int i=0;i<num_pixels;++i)
+    {
+        s0 += wire[0];
+        s1 += wire[1];
+        s2 += wire[2];
+        wire += 3;
+    }
+    sums[0] += s0;
+    sums[1] += s1;
+    sums[2] += s2;
+}
+void sumWireBytes(const uint8_t* wire, int num_pixels, uint32_t sums[3], uint32_t& white)
+{
+    uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i=0;i<num_pixels;++i)
+    {
+        s0 += wire[0];
+        s1 += wire[1];
+        s2 += wire[2];
+        s3 += wire[3];
+        wire += 4;
+    }
+    sums[0] += s0;
+    sums[1] += s1;
+    sums[2] += s2;
+    white += s3;
+}
+uint32_t estimateCurrent_mA(const PowerBudget& pb, const uint64_t channel_sums[3], int num_pixels, uint64_t white_sum)
+{
+    uint64_t uA = uint64_t(pb.idle_uA) * num_pixels + white_sum * pb.white_uA / 255;
+    for (int c=0;c<3;++c) {
+        uA += channel_sums[c] * pb.channel_uA[c] / 255;
+    }
+    return uint32_t(uA / 1000);
+}
+uint32_t powerScale(const PowerBudget& pb, uint32_t estimated_mA, int num_pixels)
+{
+    if (0 == pb.budget_mA || estimated_mA <= pb.budget_mA) return 256;
+    const uint32_t idle_mA = uint32_t(uint64_t(pb.idle_uA) * num_pixels / 1000);
+    if (pb.budget_mA <= idle_mA) return 0;
+    // rounded down, the scaled frame never goes over
+    return uint32_t(uint64_t(pb.budget_mA - idle_mA) * 256 / (estimated_mA - idle_mA));
+}
+void scaleWireBytes(uint8_t* wire, int num_bytes, uint32_t scale)
+{
+    for (int i=0;i<num_bytes;++i) {
+        wire[i] = uint8_t((wire[i] * scale) >> 8);
+    }
+}
+}
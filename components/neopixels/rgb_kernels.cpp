@@ -0,0 +1,216 @@
+#include <cstring>
+#include <rgb_kernels.hpp>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Neopixel
+{
+namespace
+{
+    constexpr uint32_t Even = 0x00ff00ff;   //bytes 0 and 2, each in its own 16 bit lane
+    constexpr uint32_t High = 0x80808080;
+
+    inline uint8_t* bytes(RGB* px) { return reinterpret_cast<uint8_t*>(px); }
+    inline const uint8_t* bytes(const RGB* px) { return reinterpret_cast<const uint8_t*>(px); }
+    inline uint32_t load(const uint8_t* p) { uint32_t w; memcpy(&w, p, 4); return w; }
+    inline void store(uint8_t* p, uint32_t w) { memcpy(p, &w, 4); }
+
+    // every byte times m >> 8, m <= 256 so a product never leaves its 16 bit lane
+    inline uint32_t mulWord(uint32_t w, uint32_t m)
+    {
+        const uint32_t even = ((w & Even) * m >> 8) & Even;
+        const uint32_t odd  = (((w >> 8) & Even) * m) & ~Even;
+        return even | odd;
+    }
+    // (d * a + s * na) >> 8 per byte, a + na = 255 keeps the sum within the lane
+    inline uint32_t mixWord(uint32_t d, uint32_t s, uint32_t a, uint32_t na)
+    {
+        const uint32_t even = (((d & Even) * a + (s & Even) * na) >> 8) & Even;
+        const uint32_t odd  = (((d >> 8) & Even) * a + ((s >> 8) & Even) * na) & ~Even;
+        return even | odd;
+    }
+    inline uint32_t addWord(uint32_t a, uint32_t b)
+    {
+        // add the low 7 bits, put the top bit back, saturate bytes that carried out
+        const uint32_t t = ((a & ~High) + (b & ~High)) ^ ((a ^ b) & High);
+        const uint32_t carry = ((a & b) | ((a | b) & ~t)) & High;
+        return t | ((carry >> 7) * 0xff);
+    }
+    inline uint32_t maxWord(uint32_t a, uint32_t b)
+    {
+        // top bit of x : low 7 bits of a >= low 7 bits of b, no borrow crosses a byte
+        const uint32_t x = (a | High) - (b & ~High);
+        const uint32_t ge = ((a & ~b) | (~(a ^ b) & x)) & High;
+        const uint32_t mask = (ge >> 7) * 0xff;
+        return (a & mask) | (b & ~mask);
+    }
+
+#if defined(__SSE2__)
+    inline __m128i loadv(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline void storev(uint8_t* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    inline __m128i lo16(__m128i v) { return _mm_unpacklo_epi8(v, _mm_setzero_si128()); }
+    inline __m128i hi16(__m128i v) { return _mm_unpackhi_epi8(v, _mm_setzero_si128()); }
+    // d * m >> 8 in 16 bit lanes, m <= 256
+    inline __m128i mulv(__m128i d, __m128i m_lo, __m128i m_hi)
+    {
+        return _mm_packus_epi16(_mm_srli_epi16(_mm_mullo_epi16(lo16(d), m_lo), 8),
+                                _mm_srli_epi16(_mm_mullo_epi16(hi16(d), m_hi), 8));
+    }
+    // lanes of the channel factor + add for a 16 byte block starting at channel phase
+    inline void phaseLanes(const uint16_t f[3], int phase, __m128i& lo, __m128i& hi)
+    {
+        alignas(16) uint16_t l[16];
+        for (int j=0;j<16;++j) l[j] = f[(phase + j) % 3];
+        lo = _mm_load_si128(reinterpret_cast<const __m128i*>(l));
+        hi = _mm_load_si128(reinterpret_cast<const __m128i*>(l + 8));
+    }
+#endif
+}
+void fade8(uint8_t* v, int count, uint8_t scale)
+{
+    const uint32_t m = uint32_t(scale) + 1;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i mv = _mm_set1_epi16(short(m));
+    for (; i + 16 <= count; i += 16) storev(v + i, mulv(loadv(v + i), mv, mv));
+#endif
+    for (; i + 4 <= count; i += 4) store(v + i, mulWord(load(v + i), m));
+    for (; i < count; ++i) v[i] = uint8_t(v[i] * m >> 8);
+}
+void fade8(RGB* px, int count, uint8_t scale)
+{
+    fade8(bytes(px), 3 * count, scale);
+}
+void scale8(RGB* px, int count, const RGB& factor)
+{
+    uint8_t *v = bytes(px);
+    const int n = 3 * count;
+    const uint16_t f[3] = { uint16_t(factor.r + 1), uint16_t(factor.g + 1), uint16_t(factor.b + 1) };
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i m_lo[3], m_hi[3];
+    for (int p=0;p<3;++p) phaseLanes(f, p, m_lo[p], m_hi[p]);
+    // 16 bytes move the phase by one channel
+    for (int p=0; i + 16 <= n; i += 16, p = p == 2 ? 0 : p + 1) {
+        storev(v + i, mulv(loadv(v + i), m_lo[p], m_hi[p]));
+    }
+#endif
+    // per channel factors do not share a word multiply, the target takes this loop
+    for (int k=i%3; i < n; ++i, k = k == 2 ? 0 : k + 1) v[i] = uint8_t(v[i] * f[k] >> 8);
+}
+void add8(RGB* dst, const RGB* src, int count)
+{
+    uint8_t *d = bytes(dst);
+    const uint8_t *s = bytes(src);
+    const int n = 3 * count;
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) storev(d + i, _mm_adds_epu8(loadv(d + i), loadv(s + i)));
+#endif
+    for (; i + 4 <= n; i += 4) store(d + i, addWord(load(d + i), load(s + i)));
+    for (; i < n; ++i) d[i] = uint8_t(min(d[i] + s[i], 255));
+}
+void mix8(RGB* dst, const RGB* src, int count, uint8_t alpha)
+{
+    uint8_t *d = bytes(dst);
+    const uint8_t *s = bytes(src);
+    const int n = 3 * count;
+    const uint32_t a = alpha, na = 255 - a;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i av = _mm_set1_epi16(short(a)), nav = _mm_set1_epi16(short(na));
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i dv = loadv(d + i), sv = loadv(s + i);
+        const __m128i l = _mm_add_epi16(_mm_mullo_epi16(lo16(dv), av), _mm_mullo_epi16(lo16(sv), nav));
+        const __m128i h = _mm_add_epi16(_mm_mullo_epi16(hi16(dv), av), _mm_mullo_epi16(hi16(sv), nav));
+        storev(d + i, _mm_packus_epi16(_mm_srli_epi16(l, 8), _mm_srli_epi16(h, 8)));
+    }
+#endif
+    for (; i + 4 <= n; i += 4) store(d + i, mixWord(load(d + i), load(s + i), a, na));
+    for (; i < n; ++i) d[i] = uint8_t((d[i] * a + s[i] * na) >> 8);
+}
+void mix8(RGB* dst, int count, const RGB& color, uint8_t alpha)
+{
+    uint8_t *d = bytes(dst);
+    const int n = 3 * count;
+    const uint32_t a = alpha;
+    // the color term is a constant per channel
+    const uint16_t add[3] = { uint16_t(color.r * (255 - a)), uint16_t(color.g * (255 - a)), uint16_t(color.b * (255 - a)) };
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i av = _mm_set1_epi16(short(a));
+    __m128i a_lo[3], a_hi[3];
+    for (int p=0;p<3;++p) phaseLanes(add, p, a_lo[p], a_hi[p]);
+    for (int p=0; i + 16 <= n; i += 16, p = p == 2 ? 0 : p + 1)
+    {
+        const __m128i dv = loadv(d + i);
+        const __m128i l = _mm_add_epi16(_mm_mullo_epi16(lo16(dv), av), a_lo[p]);
+        const __m128i h = _mm_add_epi16(_mm_mullo_epi16(hi16(dv), av), a_hi[p]);
+        storev(d + i, _mm_packus_epi16(_mm_srli_epi16(l, 8), _mm_srli_epi16(h, 8)));
+    }
+#endif
+    // a word starts one channel further than the previous one
+    uint32_t even[3], odd[3];
+    for (int p=0;p<3;++p)
+    {
+        even[p] = add[p] | uint32_t(add[(p + 2) % 3]) << 16;
+        odd[p]  = add[(p + 1) % 3] | uint32_t(add[p]) << 16;
+    }
+    for (int p=i%3; i + 4 <= n; i += 4, p = p == 2 ? 0 : p + 1)
+    {
+        const uint32_t w = load(d + i);
+        const uint32_t e = (((w & Even) * a + even[p]) >> 8) & Even;
+        const uint32_t o = (((w >> 8) & Even) * a + odd[p]) & ~Even;
+        store(d + i, e | o);
+    }
+    for (int k=i%3; i < n; ++i, k = k == 2 ? 0 : k + 1) d[i] = uint8_t((d[i] * a + add[k]) >> 8);
+}
+void max8(RGB* dst, const RGB* src, int count)
+{
+    uint8_t *d = bytes(dst);
+    const uint8_t *s = bytes(src);
+    const int n = 3 * count;
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) storev(d + i, _mm_max_epu8(loadv(d + i), loadv(s + i)));
+#endif
+    for (; i + 4 <= n; i += 4) store(d + i, maxWord(load(d + i), load(s + i)));
+    for (; i < n; ++i) d[i] = max(d[i], s[i]);
+}
+void multiply8(RGB* dst, const RGB* src, int count)
+{
+    uint8_t *d = bytes(dst);
+    const uint8_t *s = bytes(src);
+    const int n = 3 * count;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i one = _mm_set1_epi16(1);
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i sv = loadv(s + i);
+        storev(d + i, mulv(loadv(d + i), _mm_add_epi16(lo16(sv), one), _mm_add_epi16(hi16(sv), one)));
+    }
+#endif
+    // a product per byte, nothing to share in a word
+    for (; i < n; ++i) d[i] = uint8_t(d[i] * (s[i] + 1) >> 8);
+}
+void screen8(RGB* dst, const RGB* src, int count)
+{
+    uint8_t *d = bytes(dst);
+    const uint8_t *s = bytes(src);
+    const int n = 3 * count;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i one = _mm_set1_epi16(1), ones = _mm_set1_epi8(char(0xff));
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i sv = _mm_xor_si128(loadv(s + i), ones);
+        const __m128i dv = _mm_xor_si128(loadv(d + i), ones);
+        storev(d + i, _mm_xor_si128(mulv(dv, _mm_add_epi16(lo16(sv), one), _mm_add_epi16(hi16(sv), one)), ones));
+    }
+#endif
+    for (; i < n; ++i) d[i] = uint8_t(255 - ((255 - d[i]) * (256 - s[i]) >> 8));
+}
+}
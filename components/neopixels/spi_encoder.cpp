@@ -0,0 +1,108 @@
+#include <spi_encoder.hpp>
+#include <cstring>
+
+namespace NeopixelDrv
+{
+SpiBitPattern SpiBitPattern::fromTiming(const Timing& tm, int bits_per_symbol)
+{
+    const uint32_t bit_ns = tm.T0H_NS + tm.T0L_NS;
+    SpiBitPattern p;
+    p.bits_per_symbol = bits_per_symbol;
+    p.clock_hz = uint32_t(uint64_t(bits_per_symbol) * 1000000000ull / bit_ns);
+    p.t0h_bits = uint8_t((tm.T0H_NS * bits_per_symbol + bit_ns/2) / bit_ns);
+    p.t1h_bits = uint8_t((tm.T1H_NS * bits_per_symbol + bit_ns/2) / bit_ns);
+    if (p.t0h_bits < 1) p.t0h_bits = 1;
+    if (p.t1h_bits >= bits_per_symbol) p.t1h_bits = bits_per_symbol - 1;
+    const uint64_t reset_bits = (uint64_t(tm.RESET_NS) * p.clock_hz + 999999999ull) / 1000000000ull;
+    p.reset_bytes = uint16_t((reset_bits + 7) / 8);
+    return p;
+}
+void SpiEncoder::init(const SpiBitPattern& p)
+{
+    pattern = p;
+    const uint32_t n = p.bits_per_symbol;
+    const uint32_t sym0 = ((1u << p.t0h_bits) - 1) << (n - p.t0h_bits);
+    const uint32_t sym1 = ((1u << p.t1h_bits) - 1) << (n - p.t1h_bits);
+    for (int v=0;v<256;++v)
+    {
+        uint32_t bits = 0;
+        for (int i=7;i>=0;--i) {
+            bits = (bits << n) | (((v >> i) & 1) ? sym1 : sym0);
+        }
+        table[v] = bits;
+    }
+}
+size_t SpiEncoder::encode(const uint8_t* src, size_t src_size, uint8_t* out) const
+{
+    uint8_t *pout = out;
+    if (4 == pattern.bits_per_symbol)
+    {
+        for (size_t i=0;i<src_size;++i)
+        {
+            const uint32_t bits = table[src[i]];
+            *pout++ = uint8_t(bits >> 24);
+            *pout++ = uint8_t(bits >> 16);
+            *pout++ = uint8_t(bits >> 8);
+            *pout++ = uint8_t(bits);
+        }
+    }
+    else
+    {
+        for (size_t i=0;i<src_size;++i)
+        {
+            const uint32_t bits = table[src[i]];
+            *pout++ = uint8_t(bits >> 16);
+            *pout++ = uint8_t(bits >> 8);
+            *pout++ = uint8_t(bits);
+        }
+    }
+    memset(pout, 0, pattern.reset_bytes);
+    pout += pattern.reset_bytes;
+    return pout - out;
+}
+SpiWaveformCheck verifySpiWaveform(const uint8_t* stream, size_t size, uint32_t clock_hz,
+                                   const Timing& tm, int tolerance_ns, uint8_t* decoded, size_t max_decoded)
+{
+    SpiWaveformCheck result {0, 0, 0, true, false};
+    const double bit_ns = 1e9 / clock_hz;
+    const size_t n_bits = size * 8;
+    auto bit = [&](size_t k) { return (stream[k >> 3] >> (7 - (k & 7))) & 1; };
+    auto track = [&](double measured, int expected) {
+        const int err = int(measured - expected + (measured >= expected ? 0.5 : -0.5));
+        const int aerr = err < 0 ? -err : err;
+        if (aerr > result.max_error_ns) result.max_error_ns = aerr;
+    };
+
+    size_t k = 0;
+    size_t n_led_bits = 0;
+    uint8_t current = 0;
+    while (k < n_bits && !bit(k)) ++k;  // idle low before the first bit
+    while (k < n_bits)
+    {
+        size_t high = 0, low = 0;
+        while (k < n_bits && bit(k))  { ++high; ++k; }
+        while (k < n_bits && !bit(k)) { ++low;  ++k; }
+        const double high_ns = high * bit_ns;
+        const double low_ns  = low * bit_ns;
+        const int d0 = int(high_ns) - tm.T0H_NS;
+        const int d1 = int(high_ns) - tm.T1H_NS;
+        const int v = (d0 < 0 ? -d0 : d0) <= (d1 < 0 ? -d1 : d1) ? 0 : 1;
+        track(high_ns, v ? tm.T1H_NS : tm.T0H_NS);
+        if (k < n_bits) {
+            track(low_ns, v ? tm.T1L_NS : tm.T0L_NS);
+        } else {
+            result.reset_ns = uint32_t(low_ns);
+        }
+        current = uint8_t((current << 1) | v);
+        if (0 == (++n_led_bits & 7))
+        {
+            if (result.n_decoded < max_decoded) decoded[result.n_decoded] = current;
+            ++result.n_decoded;
+            current = 0;
+        }
+    }
+    result.timing_ok = result.max_error_ns <= tolerance_ns;
+    result.reset_ok  = result.reset_ns >= uint32_t(tm.RESET_NS);
+    return result;
+}
+}
@@ -0,0 +1,25 @@
+#include <strip_arena.hpp>
+#include <mem_tracker.hpp>
+
+namespace Neopixel
+{
+bool StripArena::init(uint32_t bytes)
+{
+    // strips keep 32 bit fields, the second region starts aligned as well
+    bytes = (bytes + 7) & ~7u;
+    mem = Mem::alloc<uint8_t>(2 * bytes, MemTag::Strip);
+    region_bytes = mem ? bytes : 0;
+    current = 0;
+    return mem != nullptr;
+}
+void StripArena::release()
+{
+    Mem::free(mem);
+    mem = nullptr;
+    region_bytes = 0;
+}
+void* StripArena::idle(uint32_t bytes) const
+{
+    return bytes <= region_bytes ? region(current ^ 1) : nullptr;
+}
+}
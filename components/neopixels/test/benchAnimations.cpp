@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <FireAnimation.hpp>
+#include <DigitalRainAnimation.hpp>
+#include <led_strip.hpp>
+#include <collections.hpp>
+#include <random.hpp>
+#include <color.hpp>
+#include <utils.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+namespace
+{
+constexpr int Lines = 10, LineLeds = 45, FrameLeds = Lines * LineLeds;
+
+// plain buffer, refresh costs nothing so the benches time the animation alone
+struct BufferStrip : LedStrip
+{
+    explicit BufferStrip(int n) : buffer(n) {}
+    int getLength() const override { return int(buffer.size()); }
+    RGB* getBuffer() override { return buffer.data(); }
+    void setPixelsRGB(int first, int num, const RGB* rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb[i];
+    }
+    void fillPixelsRGB(int first, int num, const RGB& rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb;
+    }
+    void setPixelsHSV(int first, int num, const HSV* hsv) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = hsv[i].toRGB();
+    }
+    PixelSpan writeSpan(int first, int count) override
+    {
+        return {buffer.data() + first, min(count, getLength() - first)};
+    }
+    void refresh(bool) override { Bench::keep(buffer[0]); }
+    void copyFrontToBack() override {}
+    bool waitReady(uint32_t) override { return true; }
+    void release() override {}
+    std::vector<RGB> buffer;
+};
+struct XorShift : RandomGenerator
+{
+    uint32_t make_random() override
+    {
+        s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+        return s;
+    }
+    void make_random_n(uint32_t *values, int length) override
+    {
+        for (int i=0;i<length;++i) values[i] = make_random();
+    }
+    void release() override {}
+    uint32_t s = 2463534242u;
+};
+Strips* makeTree()
+{
+    Subset su[Lines];
+    for (int i=0;i<Lines;++i) su[i] = { uint16_t(i * LineLeds), LineLeds, int8_t(i & 1 ? -1 : 1) };
+    return makeStrips(su);
+}
+}
+
+TEST(AnimationBench, fire_step_450_leds)
+{
+    auto *tree = makeTree();
+    BufferStrip strip(FrameLeds);
+    XorShift random;
+    uint8_t params[5];
+    void *p = params;
+    encode<uint16_t>(p, 20);    //delay
+    encode<uint8_t>(p, 55);     //cooling
+    encode<uint8_t>(p, 120);    //sparking
+    encode<uint8_t>(p, 0);      //direction
+    FireAnimation fire(&strip, sizeof(params), params, tree, &random);
+    auto r = Bench::measure(20000, [&]{ fire.step(); });
+    Bench::report("fire step", r, FrameLeds, "led");
+    release(tree);
+}
+
+TEST(AnimationBench, digital_rain_step_450_leds)
+{
+    auto *tree = makeTree();
+    BufferStrip strip(FrameLeds);
+    XorShift random;
+    uint8_t params[14];
+    void *p = params;
+    encode<uint16_t>(p, 20);    //delay
+    encode<uint16_t>(p, 100);   //hue min
+    encode<uint16_t>(p, 140);   //hue max
+    encode<int8_t>(p, 1);       //hue inc
+    encode<uint8_t>(p, 0);      //hue mode
+    encode<int16_t>(p, 255);    //color value
+    encode<int8_t>(p, 3);       //head length
+    encode<uint8_t>(p, 15);     //tail length min
+    encode<uint8_t>(p, 40);     //tail length max
+    DigitalRainAnimation rain(&strip, (uint8_t*)p - params, params, tree, &random);
+    auto r = Bench::measure(20000, [&]{ rain.step(); });
+    Bench::report("digital rain step", r, FrameLeds, "led");
+    release(tree);
+}
+
+// Wave and Reel100 rainbow : one setter call per pixel against one transform per frame
+TEST(AnimationBench, rainbow_450_leds)
+{
+    BufferStrip buffer(FrameLeds);
+    LedStrip *strip = &buffer;
+    uint16_t hue = 0;
+    auto per_pixel = Bench::measure(20000, [&]{
+        HSV hsv = {hue,255,240};
+        for (int i=0;i<FrameLeds;++i) {
+            strip->fillPixelsRGB(i,1,hsv.toRGB());
+            hsv.h += 3;
+        }
+        hue = hsv.h;
+        Bench::keep(buffer.buffer[0]);
+    });
+    auto bulk = Bench::measure(20000, [&]{
+        HSV hsv = {hue,255,240};
+        strip->transform(0, FrameLeds, [&](int) { const RGB c = hsv.toRGB(); hsv.h += 3; return c; });
+        hue = hsv.h;
+        Bench::keep(buffer.buffer[0]);
+    });
+    Bench::report("rainbow per pixel setter", per_pixel, FrameLeds, "led");
+    Bench::report("rainbow transform",        bulk,      FrameLeds, "led");
+}
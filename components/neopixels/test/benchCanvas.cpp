@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <canvas.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+namespace
+{
+Subset tree[] = {{0,28,1},{29,27,-1},{57,28,1},{86,26,-1},{113,28,1},{142,28,-1},{171,28,1},{200,28,-1},
+                 {229,27,1},{257,27,-1},{285,27,1},{313,28,-1},{342,28,1},{371,28,-1},{402,22,1},{425,22,-1}};
+}
+
+// the per frame cost of showing a canvas on the tree, for a canvas one cell per pixel and a finer one
+TEST(CanvasBench, resample_to_the_tree)
+{
+    Strips *pstrips = makeStrips(tree);
+    const auto *coords = CoordMap::acquire(pstrips);
+    std::vector<RGB> px(coords->totalPixels);
+    for (auto [w, h] : {std::pair{16, 28}, std::pair{32, 32}, std::pair{64, 64}})
+    {
+        Canvas canvas;
+        canvas.init(w, h, MemTag::Layout);
+        for (int i=0;i<w*h;++i) canvas.cells[i] = { uint8_t(i), uint8_t(i * 3), uint8_t(i * 7) };
+        CanvasMap map;
+        auto build = Bench::measure(200, [&]{ map.build(coords, w, h, MemTag::Layout); });
+        auto resample = Bench::measure(20000, [&]{
+            map.resample(canvas, px.data());
+            Bench::keep(px[0]);
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "%dx%d resample, %d taps", w, h, map.numTaps());
+        Bench::report(name, resample, int(px.size()), "led");
+        snprintf(name, sizeof(name), "%dx%d build", w, h);
+        Bench::report(name, build, 1, "map");
+    }
+    CoordMap::release(coords);
+    release(pstrips);
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <color_pipeline.hpp>
+#include <vector>
+#include <cstring>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+// dimming used to be a scale8 pass over the pixel buffer before sending it,
+// the pipeline folds it into the copy to the wire buffer
+TEST(ColorPipelineBench, frame_450_leds)
+{
+    std::vector<RGB> px(FrameLeds), work(FrameLeds);
+    for (int i=0;i<FrameLeds;++i) px[i] = { uint8_t(i), uint8_t(i*3), uint8_t(i*7) };
+    std::vector<uint8_t> wire(3*FrameLeds);
+
+    auto scale_pass = Bench::measureFrame([&]{
+        memcpy(work.data(), px.data(), sizeof(RGB)*FrameLeds);
+        for (auto & p : work) p.scale8(128);
+        memcpy(wire.data(), work.data(), wire.size());
+        Bench::keep(wire[0]);
+    });
+    ColorPipeline cp;
+    cp.build({ColorOrder::GRB, true, {255,240,220}}, 128);
+    auto pipeline = Bench::measureFrame([&]{
+        cp.encode(px.data(), FrameLeds, wire.data());
+        Bench::keep(wire[0]);
+    });
+    auto rebuild = Bench::measureFrame([&]{
+        cp.build({ColorOrder::GRB, true, {255,240,220}}, 100);
+        Bench::keep(cp.lut[0][255]);
+    });
+    Bench::reportFrame("scale8 pass + copy", scale_pass);
+    Bench::reportFrame("pipeline encode",    pipeline);
+    Bench::report("pipeline rebuild",   rebuild,    1, "build");
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <coord_map.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+namespace
+{
+// the tree of the app, 16 lines of 22..28 pixels
+Subset tree[] = {{0,28,1},{29,27,-1},{57,28,1},{86,26,-1},{113,28,1},{142,28,-1},{171,28,1},{200,28,-1},
+                 {229,27,1},{257,27,-1},{285,27,1},{313,28,-1},{342,28,1},{371,28,-1},{402,22,1},{425,22,-1}};
+constexpr int Points = 1024;
+}
+
+// particle positions as the Particles animation looks them up, one 2D point each
+TEST(CoordMapBench, point_lookup_1024_particles)
+{
+    Strips *pstrips = makeStrips(tree);
+    const uint16_t nmax = pstrips->getLongestLine();
+    std::vector<uint16_t> xs(Points), ys(Points);
+    uint32_t s = 2463534242u;
+    for (int i=0;i<Points;++i)
+    {
+        s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+        xs[i] = uint16_t(s % (15 << 8));
+        ys[i] = uint16_t((s >> 16) % ((nmax - 1) << 8));
+    }
+    auto divide = Bench::measure(2000, [&]{
+        uint32_t acc = 0;
+        for (int i=0;i<Points;++i) acc += pstrips->getPoint2D(xs[i], ys[i], nmax).idx[0];
+        Bench::keep(acc);
+    });
+    const auto *m = CoordMap::acquire(pstrips);
+    auto cached = Bench::measure(2000, [&]{
+        uint32_t acc = 0;
+        for (int i=0;i<Points;++i) acc += m->getPoint2D(xs[i], ys[i]).idx[0];
+        Bench::keep(acc);
+    });
+    CoordMap::release(m);
+    auto build = Bench::measure(2000, [&]{
+        auto *b = CoordMap::acquire(pstrips);
+        Bench::keep(b->rowSize);
+        CoordMap::release(b);
+    });
+    // what a second animation on the same layout pays
+    auto *held = CoordMap::acquire(pstrips);
+    auto shared = Bench::measure(2000, [&]{
+        auto *again = CoordMap::acquire(pstrips);
+        Bench::keep(again->rowSize);
+        CoordMap::release(again);
+    });
+    CoordMap::release(held);
+    auto neighbours = Bench::measure(200, [&]{
+        auto *n = NeighboursMatrix::fromStrips(pstrips);
+        Bench::keep(n->count);
+        release(n);
+    });
+    Bench::report("Strips::getPoint2D",            divide,     Points, "point");
+    Bench::report("CoordMap::getPoint2D",          cached,     Points, "point");
+    Bench::report("CoordMap build",                build,      1, "map");
+    Bench::report("CoordMap acquire, map held",    shared,     1, "map");
+    Bench::report("NeighboursMatrix::fromStrips",  neighbours, 1, "table");
+    release(pstrips);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <decay_field.hpp>
+#include <rgb_kernels.hpp>
+#include <led_strip.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+namespace
+{
+struct BufferStrip : LedStrip
+{
+    explicit BufferStrip(int n) : buffer(n) {}
+    int getLength() const override { return int(buffer.size()); }
+    RGB* getBuffer() override { return buffer.data(); }
+    void setPixelsRGB(int first, int num, const RGB* rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb[i];
+    }
+    void fillPixelsRGB(int first, int num, const RGB& rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb;
+    }
+    void setPixelsHSV(int, int, const HSV*) override {}
+    PixelSpan writeSpan(int first, int count) override
+    {
+        return {buffer.data() + first, min(count, getLength() - first)};
+    }
+    void refresh(bool) override { Bench::keep(buffer[0]); }
+    void copyFrontToBack() override {}
+    bool waitReady(uint32_t) override { return true; }
+    void release() override {}
+    std::vector<RGB> buffer;
+};
+}
+
+// one new pixel and one fade tick per frame, as the Random animation runs with equal delays
+TEST(DecayFieldBench, one_new_pixel_per_frame_450_leds)
+{
+    for (uint8_t fade : {200, 250})
+    {
+        BufferStrip strip(FrameLeds);
+        uint32_t pos = 0;
+        auto full = Bench::measureFrame([&]{
+            fade8(strip.getBuffer(), FrameLeds, fade);
+            pos = (pos + 97) % FrameLeds;
+            strip.fillPixelsRGB(int(pos), 1, {255, 128, 0});
+            strip.refresh(false);
+        });
+        DecayField field;
+        field.init(FrameLeds, fade, MemTag::Random);
+        auto lazy = Bench::measureFrame([&]{
+            field.tick();
+            pos = (pos + 97) % FrameLeds;
+            field.set(pos, {255, 128, 0});
+            field.render(&strip);
+            strip.refresh(false);
+        });
+        printf("fade %3d : %3d live pixels\n", fade, field.liveCount());
+        Bench::report("  fade8 full buffer + set", full, 1, "frame");
+        Bench::report("  decay field tick + set + render", lazy, 1, "frame");
+    }
+}
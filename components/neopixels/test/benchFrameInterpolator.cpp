@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <frame_interpolator.hpp>
+#include <color_pipeline.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+// work added per output frame by interpolation, against encoding that frame
+TEST(FrameInterpolatorBench, output_frame_450_leds)
+{
+    std::vector<RGB> mem(FrameInterpolator::Buffers * FrameLeds), a(FrameLeds), b(FrameLeds), out(FrameLeds);
+    for (int i=0;i<FrameLeds;++i)
+    {
+        a[i] = { uint8_t(i), uint8_t(i*3), uint8_t(i*7) };
+        b[i] = { uint8_t(i*5), uint8_t(i*11), uint8_t(i*13) };
+    }
+    FrameInterpolator fi;
+    fi.init(mem.data(), FrameLeds);
+    fi.push(a.data(), 0);
+    fi.output(0);
+    fi.push(b.data(), 100000);
+    fi.output(100000);
+    std::vector<uint8_t> wire(3*FrameLeds);
+    ColorPipeline cp;
+    cp.build({ColorOrder::GRB, true, {255,255,255}}, 200);
+
+    uint16_t alpha = 1;
+    auto blend = Bench::measureFrame([&]{
+        blendFrames(a.data(), b.data(), out.data(), FrameLeds, alpha);
+        alpha = (alpha + 37) & 0xff;
+        Bench::keep(out[0]);
+    });
+    uint32_t t = 100000;
+    auto output = Bench::measureFrame([&]{
+        const RGB *px = fi.output(t);
+        t = 100001 + (t + 4999) % 99000;
+        Bench::keep(px[0]);
+    });
+    auto push = Bench::measureFrame([&]{
+        fi.push(a.data(), 100000);
+        Bench::keep(mem[0]);
+    });
+    auto encode = Bench::measureFrame([&]{
+        cp.encode(out.data(), FrameLeds, wire.data());
+        Bench::keep(wire[0]);
+    });
+    Bench::reportFrame("blendFrames",          blend);
+    Bench::reportFrame("output, mid blend",    output);
+    Bench::reportFrame("push rendered frame",  push);
+    Bench::reportFrame("encode 8 bit",         encode);
+}
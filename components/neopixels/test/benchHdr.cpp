@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <hdr.hpp>
+#include <color_pipeline.hpp>
+#include <rgb_kernels.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+// per frame cost of the 16 bit path on the tree against the 8 bit one
+TEST(HdrBench, frame_450_leds)
+{
+    std::vector<RGB> px8(FrameLeds);
+    std::vector<RGB16> px16(FrameLeds), src16(FrameLeds);
+    for (int i=0;i<FrameLeds;++i)
+    {
+        px8[i] = { uint8_t(i), uint8_t(i*3), uint8_t(i*7) };
+        px16[i] = src16[i] = RGB16::fromRGB(px8[i]);
+    }
+    std::vector<uint8_t> wire(3*FrameLeds), residual(3*FrameLeds);
+    ColorPipeline cp;
+    ColorPipeline::Lut16 lut16;
+    cp.lut16 = &lut16;
+    cp.build({ColorOrder::GRB, true, {255,255,255}}, 200, true);
+
+    auto fade8bit = Bench::measureFrame([&]{
+        fade8(px8.data(), FrameLeds, 250);
+        Bench::keep(px8[0]);
+    });
+    auto fade = Bench::measureFrame([&]{
+        fade16(px16.data(), FrameLeds, 0xfa00);
+        Bench::keep(px16[0]);
+    });
+    auto blend = Bench::measureFrame([&]{
+        blend16(px16.data(), src16.data(), FrameLeds, 0x1000);
+        Bench::keep(px16[0]);
+    });
+    auto encode8 = Bench::measureFrame([&]{
+        cp.encode(px8.data(), FrameLeds, wire.data());
+        Bench::keep(wire[0]);
+    });
+    auto encode16 = Bench::measureFrame([&]{
+        cp.encode(px16.data(), FrameLeds, wire.data(), residual.data());
+        Bench::keep(wire[0]);
+    });
+    Bench::reportFrame("fade8",                 fade8bit);
+    Bench::reportFrame("fade16",                fade);
+    Bench::reportFrame("blend16",               blend);
+    Bench::reportFrame("encode 8 bit",          encode8);
+    Bench::reportFrame("encode 16 bit dithered", encode16);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <hsv.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+// a rainbow with a varying value, as most animations convert it
+TEST(HsvBench, convert_450_leds)
+{
+    std::vector<HSV> hsv(FrameLeds);
+    std::vector<uint16_t> hues(FrameLeds);
+    for (int i=0;i<FrameLeds;++i)
+    {
+        hsv[i] = { uint16_t(i * 7 % 360), 255, uint8_t(255 - i % 200) };
+        hues[i] = hsv[i].h;
+    }
+    std::vector<RGB> rgb(FrameLeds);
+
+    auto per_pixel = Bench::measureFrame([&]{
+        for (int i=0;i<FrameLeds;++i) rgb[i] = hsv[i].toRGB();
+        Bench::keep(rgb[0]);
+    });
+    auto batch = Bench::measureFrame([&]{
+        hsvToRgb(hsv.data(), rgb.data(), FrameLeds);
+        Bench::keep(rgb[0]);
+    });
+    HueSpectrum sp;
+    sp.build(255, 240);
+    auto lookup = Bench::measureFrame([&]{
+        sp.toRgb(hues.data(), rgb.data(), FrameLeds);
+        Bench::keep(rgb[0]);
+    });
+    auto rainbow = Bench::measureFrame([&]{
+        sp.fill(hues[0], 7, rgb.data(), FrameLeds);
+        Bench::keep(rgb[0]);
+    });
+    auto build = Bench::measureFrame([&]{
+        sp.build(255, 239);
+        Bench::keep(sp.rgb[0]);
+    });
+    auto report = [](const char* name, const Bench::Result& r) {
+        printf("%-40s %10.1f px/us %8.2f cycles/led\n", name, FrameLeds * 1000.0 / r.ns_per_iter,
+            r.cycles_per_iter / FrameLeds);
+    };
+    report("HSV::toRGB per pixel",     per_pixel);
+    report("hsvToRgb batch",           batch);
+    report("HueSpectrum lookup",       lookup);
+    report("HueSpectrum rainbow fill", rainbow);
+    Bench::report("HueSpectrum build", build, 1, "build");
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <painter.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+using Index = CoordMap::Index;
+
+namespace
+{
+Subset tree[] = {{0,28,1},{29,27,-1},{57,28,1},{86,26,-1},{113,28,1},{142,28,-1},{171,28,1},{200,28,-1},
+                 {229,27,1},{257,27,-1},{285,27,1},{313,28,-1},{342,28,1},{371,28,-1},{402,22,1},{425,22,-1}};
+}
+
+// each primitive on the app tree, shapes moved a little every call
+TEST(PainterBench, primitives)
+{
+    Strips *pstrips = makeStrips(tree);
+    const auto *map = CoordMap::acquire(pstrips);
+    const Painter painter(map);
+    std::vector<RGB> px(map->totalPixels);
+    const RGB c {40, 20, 10};
+    int k = 0;
+    auto next = [&] { k = (k + 97) & 0xfff; return k; };
+    // a point within the layout, 0..15 x 0..27
+    auto nextX = [&] { return next() * 15 / 16; };
+    auto nextY = [&] { return next() * 27 / 16; };
+
+    auto r = Bench::measure(200000, [&] {
+        const auto ip = map->getPoint2D(Index(nextX()), Index(nextY()));
+        for (int j=0;j<ip.n_points;++j) px[ip.idx[j]] = sat_add(px[ip.idx[j]], c);
+    });
+    Bench::report("CoordMap::getPoint2D, added", r, 1, "point");
+    r = Bench::measure(200000, [&] { painter.point(px.data(), nextX(), nextY(), c); });
+    Bench::report("point", r, 1, "point");
+    r = Bench::measure(20000, [&] { painter.line(px.data(), 100, next() * 6, 3700, next() * 6, c); });
+    Bench::report("line across 14 lines", r, 1, "line");
+    r = Bench::measure(20000, [&] { painter.line(px.data(), next() / 2 + 500, 200, next() / 2 + 600, 6500, c); });
+    Bench::report("line along 25 pixels", r, 1, "line");
+    r = Bench::measure(20000, [&] { painter.circle(px.data(), next() + 100, next() + 1000, 3 * 256, true, c); });
+    Bench::report("disc r=3", r, 1, "disc");
+    r = Bench::measure(20000, [&] { painter.circle(px.data(), next() + 100, next() + 1000, 3 * 256, false, c); });
+    Bench::report("ring r=3", r, 1, "ring");
+    r = Bench::measure(5000, [&] { painter.linearGradient(px.data(), 0, next(), c, 3840, next(), {0, 0, 0}); });
+    Bench::report("linear gradient", r, int(px.size()), "led");
+    r = Bench::measure(5000, [&] { painter.radialGradient(px.data(), next(), next() + 2000, 8 * 256, c, {0, 0, 0}); });
+    Bench::report("radial gradient", r, int(px.size()), "led");
+    Bench::keep(px[0]);
+
+    CoordMap::release(map);
+    release(pstrips);
+}
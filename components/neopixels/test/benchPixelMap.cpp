@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <pixel_map.hpp>
+#include <color_pipeline.hpp>
+#include <utils.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+// scrolling the whole tree by one pixel per frame, both sides include the encode
+TEST(PixelMapBench, scroll_450_leds)
+{
+    std::vector<RGB> px(FrameLeds);
+    for (int i=0;i<FrameLeds;++i) px[i] = { uint8_t(i), uint8_t(i*3), uint8_t(i*7) };
+    std::vector<uint8_t> wire(3*FrameLeds);
+    ColorPipeline cp;
+    cp.build(NoCorrection, 255);
+
+    auto move = Bench::measureFrame([&]{
+        RGB tmp;
+        rotLeft(0, FrameLeds, 1, px.data(), &tmp);
+        cp.encode(px.data(), FrameLeds, wire.data());
+        Bench::keep(wire[0]);
+    });
+    auto move_only = Bench::measureFrame([&]{
+        RGB tmp;
+        rotLeft(0, FrameLeds, 1, px.data(), &tmp);
+        Bench::keep(px[0]);
+    });
+    PixelMap map;
+    map.ranges[0] = {0, FrameLeds, 0};
+    map.num_ranges = 1;
+    auto offset = Bench::measureFrame([&]{
+        map.ranges[0].offset = map.ranges[0].offset + 1 == FrameLeds ? 0 : map.ranges[0].offset + 1;
+        map.forEachRun(0, FrameLeds, [&](int src, int n, int off) {
+            cp.encode(px.data() + src, n, wire.data() + 3 * off);
+        });
+        Bench::keep(wire[0]);
+    });
+    Bench::reportFrame("rotLeft",                 move_only);
+    Bench::reportFrame("rotLeft + encode",        move);
+    Bench::reportFrame("rotation offset + encode", offset);
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+#include <power_limiter.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+// estimate runs on every frame, scaling only on frames over the budget
+TEST(PowerLimiterBench, frame_450_leds)
+{
+    const PowerBudget pb { 5000, {18500,18500,18500}, 1000, 0 };
+    std::vector<uint8_t> wire(3*FrameLeds);
+    for (int i=0;i<3*FrameLeds;++i) wire[i] = uint8_t(i*13);
+
+    auto estimate = Bench::measureFrame([&]{
+        uint32_t sums[3] = {};
+        sumWireBytes(wire.data(), FrameLeds, sums);
+        const uint64_t ch[3] = { sums[0], sums[1], sums[2] };
+        Bench::keep(powerScale(pb, estimateCurrent_mA(pb, ch, FrameLeds), FrameLeds));
+    });
+    auto scale = Bench::measureFrame([&]{
+        scaleWireBytes(wire.data(), wire.size(), 255);
+        Bench::keep(wire[0]);
+    });
+    Bench::reportFrame("power estimate",      estimate);
+    Bench::reportFrame("power scale (over)",  scale);
+}
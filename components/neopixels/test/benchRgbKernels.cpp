@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <rgb_kernels.hpp>
+#include <vector>
+#include "benchmark.hpp"
+
+using namespace Neopixel;
+
+using Bench::FrameLeds;
+
+namespace
+{
+// per pixel loops as the animations wrote them before the kernels
+__attribute__((noinline)) void fadeLoop(RGB* px, int n, uint8_t scale)  { for (int i=0;i<n;++i) px[i].scale8(scale); }
+__attribute__((noinline)) void addLoop(RGB* d, const RGB* s, int n)     { for (int i=0;i<n;++i) d[i] = sat_add(d[i], s[i]); }
+__attribute__((noinline)) void mixLoop(RGB* d, const RGB* s, int n, uint8_t a) { for (int i=0;i<n;++i) d[i] = d[i].mix(s[i], a); }
+__attribute__((noinline)) void maxLoop(RGB* d, const RGB* s, int n)
+{
+    for (int i=0;i<n;++i) d[i] = { max(d[i].r, s[i].r), max(d[i].g, s[i].g), max(d[i].b, s[i].b) };
+}
+__attribute__((noinline)) void multiplyLoop(RGB* d, const RGB* s, int n)
+{
+    for (int i=0;i<n;++i) d[i] = { uint8_t(d[i].r * (s[i].r + 1) >> 8), uint8_t(d[i].g * (s[i].g + 1) >> 8), uint8_t(d[i].b * (s[i].b + 1) >> 8) };
+}
+}
+
+TEST(RgbKernelsBench, kernels_450_leds)
+{
+    std::vector<RGB> dst(FrameLeds), src(FrameLeds);
+    for (int i=0;i<FrameLeds;++i)
+    {
+        dst[i] = { uint8_t(i), uint8_t(i*3), uint8_t(i*7) };
+        src[i] = { uint8_t(i*5), uint8_t(i*11), uint8_t(i*13) };
+    }
+    auto *d = dst.data();
+    const auto *s = src.data();
+    auto run = [&](auto f) { return Bench::measureFrame([&]{ f(); Bench::keep(dst[0]); }); };
+    auto report = [](const char* name, const Bench::Result& loop, const Bench::Result& kernel) {
+        printf("%-12s loop %8.1f px/us   kernel %8.1f px/us   x%.1f\n", name,
+            FrameLeds * 1000.0 / loop.ns_per_iter, FrameLeds * 1000.0 / kernel.ns_per_iter,
+            loop.ns_per_iter / kernel.ns_per_iter);
+    };
+    report("fade",     run([&]{ fadeLoop(d, FrameLeds, 250); }),     run([&]{ fade8(d, FrameLeds, 250); }));
+    report("add",      run([&]{ addLoop(d, s, FrameLeds); }),        run([&]{ add8(d, s, FrameLeds); }));
+    report("mix",      run([&]{ mixLoop(d, s, FrameLeds, 200); }),   run([&]{ mix8(d, s, FrameLeds, 200); }));
+    report("max",      run([&]{ maxLoop(d, s, FrameLeds); }),        run([&]{ max8(d, s, FrameLeds); }));
+    report("multiply", run([&]{ multiplyLoop(d, s, FrameLeds); }),   run([&]{ multiply8(d, s, FrameLeds); }));
+    Bench::reportFrame("scale8",       run([&]{ scale8(d, FrameLeds, {255, 128, 64}); }));
+    Bench::reportFrame("mix8 color",   run([&]{ mix8(d, FrameLeds, {255, 0, 40}, 240); }));
+    Bench::reportFrame("screen8",      run([&]{ screen8(d, s, FrameLeds); }));
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <rmt_translator.hpp>
+#include <vector>
+#include <cstdint>
+#include "benchmark.hpp"
+
+using namespace NeopixelDrv;
+
+namespace
+{
+// the per bit adapter the table driven translator replaced, kept as the baseline
+void rmt_adapter_bitloop(const void *src, uint32_t *dest, size_t src_size,
+        size_t wanted_num, size_t *translated_size, size_t *item_num, const uint32_t *bits)
+{
+    size_t size = 0;
+    size_t num = 0;
+    const uint8_t *psrc = (const uint8_t *)src;
+    uint32_t *pdest = dest;
+    while (size < src_size && num < wanted_num)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            if (*psrc & (1 << (7 - i))) {
+                *pdest = bits[1];
+            } else {
+                *pdest = bits[0];
+            }
+            num++;
+            pdest++;
+        }
+        size++;
+        psrc++;
+    }
+    *translated_size = size;
+    *item_num = num;
+}
+constexpr size_t FrameBytes = 450 * 3;
+// rmt driver refills half of 8 memory blocks (8 * 64 / 2 items) per interrupt
+constexpr size_t RefillItems = 256;
+
+template <typename F>
+void translateFrame(const uint8_t* src, uint32_t* block, F&& translate)
+{
+    size_t offset = 0;
+    while (offset < FrameBytes)
+    {
+        size_t translated, num;
+        translate(src + offset, block, FrameBytes - offset, RefillItems, &translated, &num);
+        offset += translated;
+    }
+}
+}
+
+TEST(RmtTranslatorBench, frame_450_leds)
+{
+    static RmtTranslator tr;
+    const uint32_t bits[2] = { makeRmtItem(20, 1, 80, 0), makeRmtItem(48, 1, 52, 0) };
+    tr.init(bits[0], bits[1]);
+    std::vector<uint8_t> src(FrameBytes);
+    for (size_t i=0;i<FrameBytes;++i) src[i] = uint8_t(i*31+7);
+    std::vector<uint32_t> block(RefillItems);
+
+    auto bitloop = Bench::measure(2000, [&]{
+        translateFrame(src.data(), block.data(), [&](auto... a){ rmt_adapter_bitloop(a..., bits); });
+        Bench::keep(block[0]);
+    });
+    auto table = Bench::measure(2000, [&]{
+        translateFrame(src.data(), block.data(), [&](auto... a){ tr.translate(a...); });
+        Bench::keep(block[0]);
+    });
+    Bench::report("rmt bit loop",   bitloop, FrameBytes, "byte");
+    Bench::report("rmt table",      table,   FrameBytes, "byte");
+
+    std::vector<uint32_t> a(FrameBytes*8), b(FrameBytes*8);
+    size_t ta, na, tb, nb;
+    rmt_adapter_bitloop(src.data(), a.data(), FrameBytes, a.size(), &ta, &na, bits);
+    tr.translate(src.data(), b.data(), FrameBytes, b.size(), &tb, &nb);
+    EXPECT_EQ(ta, tb);
+    EXPECT_EQ(na, nb);
+    EXPECT_EQ(a, b);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+#endif
+
+namespace Bench
+{
+struct Result
+{
+    double ns_per_iter;
+    double cycles_per_iter;
+};
+inline uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+// keeps the optimizer from dropping a computed value
+template <typename T>
+inline void keep(T const& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+template <typename F>
+Result measure(int iterations, F&& f)
+{
+    for (int i=0;i<iterations/10+1;++i) f();  //warm up
+    const auto t0 = std::chrono::steady_clock::now();
+    const auto c0 = cycles();
+    for (int i=0;i<iterations;++i) f();
+    const auto c1 = cycles();
+    const auto t1 = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double,std::nano>(t1-t0).count();
+    return { ns / iterations, double(c1-c0) / iterations };
+}
+inline void report(const char* name, const Result& r, double units_per_iter, const char* unit)
+{
+    printf("%-40s %10.1f ns/iter %10.2f ns/%s %8.2f cycles/%s\n", name, r.ns_per_iter,
+        r.ns_per_iter / units_per_iter, unit, r.cycles_per_iter / units_per_iter, unit);
+}
+// one frame of the tree, the size the per frame benchmarks run on
+constexpr int FrameLeds = 450;
+constexpr int FrameIterations = 20000;
+template <typename F>
+Result measureFrame(F&& f)
+{
+    return measure(FrameIterations, f);
+}
+inline void reportFrame(const char* name, const Result& r)
+{
+    report(name, r, FrameLeds, "led");
+}
+}
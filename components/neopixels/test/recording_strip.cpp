@@ -0,0 +1,188 @@
+#include <cstring>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "recording_strip.hpp"
+
+namespace Neopixel
+{
+namespace
+{
+    uint64_t steady_us()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+    uint8_t* recordAt(uint8_t* map, const RecordingHeader& h, uint32_t slot)
+    {
+        return map + sizeof(RecordingHeader) + size_t(slot) * h.record_size;
+    }
+    RecordingHeader& header(uint8_t* map) { return *reinterpret_cast<RecordingHeader*>(map); }
+}
+RecordingLedStrip* RecordingLedStrip::create(const char* path, int num_pixels, uint32_t capacity, Clock clock)
+{
+    if (num_pixels <= 0 || capacity == 0) return nullptr;
+    const uint32_t record_size = (8 + 3 * num_pixels + 3) & ~3u;
+    const size_t size = sizeof(RecordingHeader) + size_t(capacity) * record_size;
+    const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return nullptr;
+    void* map = MAP_FAILED;
+    if (0 == ftruncate(fd, off_t(size))) {
+        map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED)
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    auto* strip = new RecordingLedStrip;
+    strip->num_pixels = num_pixels;
+    strip->buffer.assign(num_pixels, RGB{0,0,0});
+    strip->fd = fd;
+    strip->map = reinterpret_cast<uint8_t*>(map);
+    strip->map_size = size;
+    strip->clock = clock;
+    strip->created_us = steady_us();
+    header(strip->map) = { RecordingHeader::Magic, RecordingHeader::Version, uint32_t(num_pixels), capacity, record_size, 0, 0 };
+    return strip;
+}
+RecordingLedStrip::~RecordingLedStrip()
+{
+    release();
+}
+void RecordingLedStrip::release()
+{
+    if (map) munmap(map, map_size);
+    if (fd >= 0) ::close(fd);
+    map = nullptr;
+    fd = -1;
+}
+uint32_t RecordingLedStrip::now_us() const
+{
+    return clock ? clock() : uint32_t(steady_us() - created_us);
+}
+uint64_t RecordingLedStrip::framesRecorded() const
+{
+    return map ? header(map).frames : 0;
+}
+void RecordingLedStrip::setPixelsRGB(int first, int num, const RGB* rgb)
+{
+    num = min(num, num_pixels - first);
+    if (num > 0) memcpy(buffer.data() + first, rgb, num * sizeof(RGB));
+}
+void RecordingLedStrip::fillPixelsRGB(int first, int num, const RGB& rgb)
+{
+    num = min(num, num_pixels - first);
+    for (int i=0;i<num;++i) buffer[first + i] = rgb;
+}
+void RecordingLedStrip::setPixelsHSV(int first, int num, const HSV* hsv)
+{
+    num = min(num, num_pixels - first);
+    for (int i=0;i<num;++i) buffer[first + i] = hsv[i].toRGB();
+}
+PixelSpan RecordingLedStrip::writeSpan(int first, int count)
+{
+    if (first < 0 || first >= num_pixels) return {nullptr, 0};
+    return {buffer.data() + first, min(count, num_pixels - first)};
+}
+void RecordingLedStrip::refresh(bool)
+{
+    if (!map) return;
+    auto& h = header(map);
+    uint8_t* rec = recordAt(map, h, h.head);
+    const uint32_t stamp[2] = { now_us(), uint32_t(h.frames) };
+    memcpy(rec, stamp, sizeof(stamp));
+    memcpy(rec + sizeof(stamp), buffer.data(), 3 * num_pixels);
+    // the record is complete before the header points past it
+    h.head = h.head + 1 == h.capacity ? 0 : h.head + 1;
+    ++h.frames;
+}
+
+bool Recording::open(const char* path)
+{
+    close();
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (0 == fstat(fd, &st) && size_t(st.st_size) >= sizeof(RecordingHeader)) {
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);    //the mapping keeps the file
+    if (map == MAP_FAILED) return false;
+    const auto* h = reinterpret_cast<const RecordingHeader*>(map);
+    const bool valid = h->magic == RecordingHeader::Magic && h->version == RecordingHeader::Version &&
+        size_t(st.st_size) >= sizeof(RecordingHeader) + size_t(h->capacity) * h->record_size &&
+        h->record_size >= 8 + 3 * h->num_pixels;
+    if (!valid)
+    {
+        munmap(map, st.st_size);
+        return false;
+    }
+    hdr = h;
+    map_size = st.st_size;
+    return true;
+}
+void Recording::close()
+{
+    if (hdr) munmap(const_cast<RecordingHeader*>(hdr), map_size);
+    hdr = nullptr;
+}
+int Recording::frames() const
+{
+    if (!hdr) return 0;
+    return hdr->frames < hdr->capacity ? int(hdr->frames) : int(hdr->capacity);
+}
+RecordedFrame Recording::frame(int i) const
+{
+    // the oldest frame is at head once the ring wrapped
+    const uint32_t oldest = hdr->frames < hdr->capacity ? 0 : hdr->head;
+    const uint32_t slot = (oldest + uint32_t(i)) % hdr->capacity;
+    const auto* rec = reinterpret_cast<const uint8_t*>(hdr) + sizeof(RecordingHeader) + size_t(slot) * hdr->record_size;
+    uint32_t stamp[2];
+    memcpy(stamp, rec, sizeof(stamp));
+    return { stamp[0], stamp[1], reinterpret_cast<const RGB*>(rec + sizeof(stamp)) };
+}
+
+RecordingDiff diffRecordings(const Recording& a, const Recording& b)
+{
+    RecordingDiff d {0, 0, -1, 0, 0, a.numPixels() != b.numPixels() || a.frames() != b.frames()};
+    if (a.numPixels() != b.numPixels()) return d;
+    d.frames_compared = min(a.frames(), b.frames());
+    const int n = 3 * a.numPixels();
+    for (int f=0;f<d.frames_compared;++f)
+    {
+        const auto* pa = reinterpret_cast<const uint8_t*>(a.frame(f).pixels);
+        const auto* pb = reinterpret_cast<const uint8_t*>(b.frame(f).pixels);
+        if (0 == memcmp(pa, pb, n)) continue;
+        ++d.differing_frames;
+        if (d.first_difference < 0) d.first_difference = f;
+        for (int i=0;i<n;i+=3)
+        {
+            bool differs = false;
+            for (int k=0;k<3;++k)
+            {
+                const uint8_t delta = pa[i+k] > pb[i+k] ? pa[i+k] - pb[i+k] : pb[i+k] - pa[i+k];
+                differs |= delta != 0;
+                d.max_delta = max(d.max_delta, delta);
+            }
+            d.differing_pixels += differs;
+        }
+    }
+    return d;
+}
+int replay(const Recording& rec, LedStrip* strip, void (*wait_us)(uint32_t))
+{
+    const int n = min(rec.numPixels(), strip->getLength());
+    for (int f=0;f<rec.frames();++f)
+    {
+        const auto fr = rec.frame(f);
+        if (wait_us && f > 0) wait_us(fr.t_us - rec.frame(f-1).t_us);
+        strip->setPixelsRGB(0, n, fr.pixels);
+        strip->refresh();
+    }
+    return rec.frames();
+}
+}
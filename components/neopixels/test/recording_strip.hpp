@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <led_strip.hpp>
+#include <color.hpp>
+
+namespace Neopixel
+{
+/* Ring file layout : a header, then capacity fixed size records of one frame each,
+** {t_us, seq, num_pixels rgb} padded to 4 bytes. Once full the oldest frame is overwritten.
+** Integers are host endian, the file is only read back on the machine that wrote it */
+struct RecordingHeader
+{
+    static constexpr uint32_t Magic = 0x5258504e;   //"NPXR"
+    static constexpr uint32_t Version = 1;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_pixels;
+    uint32_t capacity;      //records in the ring
+    uint32_t record_size;
+    uint32_t head;          //next record written
+    uint64_t frames;        //written since creation, the ring holds the last min(frames, capacity)
+};
+struct RecordedFrame
+{
+    uint32_t t_us;
+    uint32_t seq;           //frame number since creation, low 32 bits
+    const RGB* pixels;
+};
+
+/* Headless LedStrip for the host : every refresh() appends the buffer to a memory mapped
+** ring file, so animations can be recorded at full speed and replayed or diffed later.
+** Single buffered like a num_buffers=1 strip, setters write the buffer refresh records */
+class RecordingLedStrip : public LedStrip
+{
+public:
+    using Clock = uint32_t (*)();   //microseconds, steady clock since creation when null
+
+    // @returns nullptr when the file can not be created or mapped
+    static RecordingLedStrip* create(const char* path, int num_pixels, uint32_t capacity, Clock clock = nullptr);
+    ~RecordingLedStrip();
+
+    int getLength() const override { return num_pixels; }
+    RGB* getBuffer() override { return buffer.data(); }
+    void setPixelsRGB(int first, int num, const RGB*) override;
+    void fillPixelsRGB(int first, int num, const RGB&) override;
+    void setPixelsHSV(int first, int num, const HSV*) override;
+    PixelSpan writeSpan(int first, int count) override;
+    void refresh(bool wait=false) override;
+    void copyFrontToBack() override {}
+    bool waitReady(uint32_t) override { return true; }
+    // unmaps and closes the file, the frames recorded so far stay in it
+    void release() override;
+    uint64_t framesRecorded() const;
+
+private:
+    RecordingLedStrip() = default;
+    uint32_t now_us() const;
+
+    int num_pixels = 0;
+    std::vector<RGB> buffer;
+    int fd = -1;
+    uint8_t* map = nullptr;
+    size_t map_size = 0;
+    Clock clock = nullptr;
+    uint64_t created_us = 0;
+};
+
+/* Read only view of a ring file, frames in recording order */
+class Recording
+{
+public:
+    Recording() = default;
+    Recording(const Recording&) = delete;
+    ~Recording() { close(); }
+    bool open(const char* path);
+    void close();
+    int numPixels() const { return hdr ? int(hdr->num_pixels) : 0; }
+    int frames() const;
+    // 0 is the oldest frame still in the ring
+    RecordedFrame frame(int i) const;
+private:
+    const RecordingHeader* hdr = nullptr;
+    size_t map_size = 0;
+};
+
+struct RecordingDiff
+{
+    int frames_compared;        //the shorter of the two
+    int differing_frames;
+    int first_difference;       //frame index, -1 when identical
+    uint64_t differing_pixels;
+    uint8_t max_delta;          //largest channel difference
+    bool size_mismatch;         //pixel counts or frame counts differ
+};
+// pixel by pixel, frame i of a against frame i of b, timestamps are not compared
+RecordingDiff diffRecordings(const Recording& a, const Recording& b);
+
+/* Sends every recorded frame to strip (setPixelsRGB + refresh), wait_us gets the recorded
+** time to the next frame, full speed without it. @returns frames sent */
+int replay(const Recording&, LedStrip* strip, void (*wait_us)(uint32_t) = nullptr);
+}
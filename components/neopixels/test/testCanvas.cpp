@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <canvas.hpp>
+#include <led_strip.hpp>
+#include <cstdlib>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+// the app tree, 16 lines of 22..28 pixels with unlit pixels between them
+Subset tree[] = {{0,28,1},{29,27,-1},{57,28,1},{86,26,-1},{113,28,1},{142,28,-1},{171,28,1},{200,28,-1},
+                 {229,27,1},{257,27,-1},{285,27,1},{313,28,-1},{342,28,1},{371,28,-1},{402,22,1},{425,22,-1}};
+
+struct SetterStrip : LedStrip
+{
+    explicit SetterStrip(int n) : buffer(n, RGB{7,7,7}) {}
+    int getLength() const override { return int(buffer.size()); }
+    RGB* getBuffer() override { return buffer.data(); }
+    void setPixelsRGB(int first, int num, const RGB* rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb[i];
+    }
+    void fillPixelsRGB(int first, int num, const RGB& rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb;
+    }
+    void setPixelsHSV(int, int, const HSV*) override {}
+    void refresh(bool) override {}
+    void copyFrontToBack() override {}
+    bool waitReady(uint32_t) override { return true; }
+    void release() override {}
+    std::vector<RGB> buffer;
+};
+}
+
+TEST(Canvas, one_cell_per_pixel_is_a_copy)
+{
+    Subset su[] = {{0,4,1},{4,4,-1},{8,4,1}};
+    Strips *pstrips = makeStrips(su);
+    const auto *coords = CoordMap::acquire(pstrips);
+    Canvas canvas;
+    ASSERT_TRUE(canvas.init(3, 4, MemTag::Layout));
+    for (int y=0;y<4;++y)
+        for (int x=0;x<3;++x) canvas.at(x, y) = { uint8_t(x * 50), uint8_t(y * 60), uint8_t(x * 4 + y) };
+    CanvasMap map;
+    ASSERT_TRUE(map.build(coords, 3, 4, MemTag::Layout));
+    EXPECT_EQ(map.numTaps(), 12);
+    std::vector<RGB> px(12);
+    map.resample(canvas, px.data());
+    for (int line=0;line<3;++line)
+    {
+        for (int j=0;j<4;++j)
+        {
+            const auto & p = px[coords->row(line)[j]];
+            EXPECT_EQ(p.r, line * 50);
+            EXPECT_EQ(p.g, j * 60);
+            EXPECT_EQ(p.b, line * 4 + j);
+        }
+    }
+    CoordMap::release(coords);
+    release(pstrips);
+}
+TEST(Canvas, weights_keep_full_scale_and_follow_gradients)
+{
+    Strips *pstrips = makeStrips(tree);
+    const auto *coords = CoordMap::acquire(pstrips);
+    constexpr int W = 32, H = 32;
+    Canvas canvas;
+    ASSERT_TRUE(canvas.init(W, H, MemTag::Layout));
+    CanvasMap map;
+    ASSERT_TRUE(map.build(coords, W, H, MemTag::Layout));
+    EXPECT_EQ(map.numPixels(), 447);
+    EXPECT_LE(map.numTaps(), 4 * 446);
+
+    for (int i=0;i<W*H;++i) canvas.cells[i] = {255, 255, 255};
+    std::vector<RGB> px(map.numPixels());
+    map.resample(canvas, px.data());
+    for (int i=0;i<map.numPixels();++i)
+    {
+        const RGB expected = coords->x(i) == CoordMap::Unmapped ? RGB{0,0,0} : RGB{255,255,255};
+        EXPECT_EQ(px[i].r, expected.r) << i;
+        EXPECT_EQ(px[i].b, expected.b) << i;
+    }
+    // linear ramps across and along the lines come back as the pixel positions
+    for (int y=0;y<H;++y)
+        for (int x=0;x<W;++x) canvas.at(x, y) = { uint8_t(x * 255 / (W - 1)), uint8_t(y * 255 / (H - 1)), 0 };
+    map.resample(canvas, px.data());
+    for (int i=0;i<map.numPixels();++i)
+    {
+        if (coords->x(i) == CoordMap::Unmapped) continue;
+        const double across = coords->x(i) / 256.0 / 15 * 255;
+        const double along  = coords->y(i) / 256.0 / 27 * 255;
+        EXPECT_NEAR(px[i].r, across, 2.5) << i;
+        EXPECT_NEAR(px[i].g, along, 2.5) << i;
+    }
+    CoordMap::release(coords);
+    release(pstrips);
+}
+TEST(Canvas, render_writes_the_strip_up_to_its_length)
+{
+    Strips *pstrips = makeStrips(tree);
+    const auto *coords = CoordMap::acquire(pstrips);
+    const auto before = Mem::stats(MemTag::Random);
+    {
+        Canvas canvas;
+        ASSERT_TRUE(canvas.init(16, 28, MemTag::Random));
+        for (int i=0;i<16*28;++i) canvas.cells[i] = {1, 2, 3};
+        CanvasMap map;
+        ASSERT_TRUE(map.build(coords, 16, 28, MemTag::Random));
+        EXPECT_EQ(Mem::stats(MemTag::Random).blocks, before.blocks + 3);
+        EXPECT_FALSE(CanvasMap().build(coords, 300, 300, MemTag::Random));
+
+        SetterStrip strip(100);
+        map.render(canvas, &strip);
+        EXPECT_EQ(strip.buffer[0].b, 3);
+        EXPECT_EQ(strip.buffer[28].b, 0);
+        EXPECT_EQ(strip.buffer[99].g, 2);
+    }
+    EXPECT_EQ(Mem::stats(MemTag::Random).current, before.current);
+    CoordMap::release(coords);
+    release(pstrips);
+}
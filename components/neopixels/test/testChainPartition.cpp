@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <chain_partition.hpp>
+
+using namespace Neopixel;
+using NeopixelDrv::Timing;
+
+namespace
+{
+// first pixels of the tree lines
+const uint16_t tree_cuts[] = {0,29,57,86,113,142,171,200,229,257,285,313,342,371,402,425};
+constexpr int tree_leds = 447;
+constexpr int tree_cuts_n = sizeof(tree_cuts)/sizeof(tree_cuts[0]);
+
+bool isCut(int idx)
+{
+    for (auto c : tree_cuts) if (c == idx) return true;
+    return false;
+}
+void expectContiguous(const ChainPart* parts, int n, int num_leds)
+{
+    int next = 0;
+    for (int i=0;i<n;++i)
+    {
+        EXPECT_EQ(parts[i].first, next);
+        EXPECT_GT(parts[i].count, 0);
+        next += parts[i].count;
+    }
+    EXPECT_EQ(next, num_leds);
+}
+}
+
+TEST(ChainPartition, balanced_without_cuts)
+{
+    ChainPart parts[8];
+    for (int n=1;n<=8;++n)
+    {
+        ASSERT_EQ(partitionChain(450, n, nullptr, 0, parts), n);
+        expectContiguous(parts, n, 450);
+        int lo = 450, hi = 0;
+        for (int i=0;i<n;++i)
+        {
+            lo = std::min<int>(lo, parts[i].count);
+            hi = std::max<int>(hi, parts[i].count);
+        }
+        EXPECT_LE(hi - lo, 1);
+    }
+}
+
+TEST(ChainPartition, more_outputs_than_leds)
+{
+    ChainPart parts[8];
+    ASSERT_EQ(partitionChain(3, 8, nullptr, 0, parts), 3);
+    expectContiguous(parts, 3, 3);
+    EXPECT_EQ(partitionChain(0, 8, nullptr, 0, parts), 0);
+}
+
+TEST(ChainPartition, parts_start_on_line_boundaries)
+{
+    ChainPart parts[4];
+    const int expected_longest[] = {447, 229, 162, 116};
+    for (int n=1;n<=4;++n)
+    {
+        const int used = partitionChain(tree_leds, n, tree_cuts, tree_cuts_n, parts);
+        ASSERT_GT(used, 0);
+        ASSERT_LE(used, n);
+        expectContiguous(parts, used, tree_leds);
+        int longest = 0;
+        for (int i=0;i<used;++i)
+        {
+            EXPECT_TRUE(isCut(parts[i].first)) << parts[i].first;
+            longest = std::max<int>(longest, parts[i].count);
+        }
+        EXPECT_EQ(longest, expected_longest[n-1]) << n << " outputs";
+    }
+}
+
+TEST(ChainPartition, locate_pixel)
+{
+    ChainPart parts[3];
+    const int n = partitionChain(tree_leds, 3, tree_cuts, tree_cuts_n, parts);
+    for (int idx=0; idx<tree_leds; ++idx)
+    {
+        auto loc = locatePixel(parts, n, idx);
+        ASSERT_GE(loc.part, 0);
+        EXPECT_EQ(parts[loc.part].first + loc.offset, idx);
+    }
+    EXPECT_EQ(locatePixel(parts, n, tree_leds).part, -1);
+}
+
+TEST(ChainPartition, frame_rate_scales_with_outputs)
+{
+    const Timing& tm = Timing::ws2811();
+    ChainPart parts[4];
+    const int n1 = partitionChain(tree_leds, 1, tree_cuts, tree_cuts_n, parts);
+    const auto single = modelFrameTime(parts, n1, tm, true);
+    // 447 * 24 bits * 2.5us + 50us reset
+    EXPECT_EQ(single.frame_ns, 447u * 24 * 2500 + 50000);
+
+    const int n4 = partitionChain(tree_leds, 4, tree_cuts, tree_cuts_n, parts);
+    const auto parallel = modelFrameTime(parts, n4, tm, true, 2000);
+    const auto serial   = modelFrameTime(parts, n4, tm, false, 2000);
+    EXPECT_GT(parallel.fps, 2.8f * single.fps);
+    EXPECT_LT(parallel.fps, 4.0f * single.fps);
+    // shifting the same parts one after another is no faster than one chain
+    EXPECT_LE(serial.fps, single.fps);
+    EXPECT_EQ(parallel.longest_part_ns, 116u * 24 * 2500 + 50000);
+
+    // rgbw pixels shift 32 bits
+    const Timing& sk = Timing::sk6812();
+    const auto rgbw = modelFrameTime(parts, n4, sk, true, 0, 4);
+    EXPECT_EQ(rgbw.longest_part_ns, 116u * 32 * 1200 + 80000);
+}
@@ -4,6 +4,7 @@
 #include <utils.hpp>
 #include <iostream>
 #include <tuple>
+#include <vector>
 
 using namespace Neopixel;
 
@@ -171,3 +172,99 @@ TEST(Neghbours, t3_nonuniform)
     release(pstrips);
 }
 
+
+TEST(Strips, clip_drops_and_cuts_lines_past_the_end)
+{
+    Subset su[] = {{0,10,1},{10,10,-1},{20,10,1}};
+    Strips *pstrips = makeStrips(su);
+    Strips *c = clipStrips(pstrips, 15);
+    ASSERT_EQ(c->count, 2);
+    EXPECT_EQ(c->element[0].count, 10);
+    EXPECT_EQ(c->element[1].first, 10);
+    EXPECT_EQ(c->element[1].count, 5);
+    EXPECT_EQ(c->element[1].dir, -1);
+    EXPECT_EQ(c->getTotalPixelsCount(), 15);
+    release(c);
+    c = clipStrips(pstrips, 30);
+    EXPECT_EQ(c->count, 3);
+    EXPECT_EQ(c->getTotalPixelsCount(), 30);
+    release(c);
+    release(pstrips);
+}
+
+namespace
+{
+using WideStrips = BasicStrips<WideLayout>;
+using WideSubset = BasicSubset<WideLayout>;
+// serpentine of equal lines, 334 x 300 = 100200 pixels
+WideStrips* makeSerpentine(int lines, int length)
+{
+    std::vector<WideSubset> su;
+    for (int i=0;i<lines;++i) {
+        su.push_back({ uint32_t(i * length), uint16_t(length), int8_t(i & 1 ? -1 : 1) });
+    }
+    return makeStrips(su.data(), su.size());
+}
+}
+
+TEST(Strips, compact_layout_keeps_its_footprint)
+{
+    static_assert(sizeof(Subset) == 4);
+    static_assert(sizeof(Strips) == sizeof(uint16_t));
+    static_assert(sizeof(BasicSubset<WideLayout>) == 8);
+}
+
+TEST(Strips, wide_layout_indices_past_65k)
+{
+    auto *ps = makeSerpentine(334, 300);
+    EXPECT_EQ(ps->getTotalPixelsCount(), 100200u);
+    EXPECT_EQ(ps->getLongestLine(), 300);
+    auto [indices,row_size] = ps->makeIndicesMatrix();
+    EXPECT_EQ(row_size, 512);
+    // line 233 runs down from 70199, its 200th pixel is 70000
+    EXPECT_EQ(indices[233 * row_size + 199], 70000u);
+    // the last line runs down as well, its row ends at its first pixel
+    EXPECT_EQ(indices[333 * row_size], 100199u);
+    EXPECT_EQ(indices[333 * row_size + 299], 99900u);
+    Mem::free(indices);
+
+    auto [i0,i1,v] = WideStrips::getPoint1D((250 << 8) | 128, 300, ps->element[332]);
+    EXPECT_EQ(i0, 99600u + 250);
+    EXPECT_EQ(i1, 99600u + 251);
+    EXPECT_EQ(v, 128);
+    release(ps);
+}
+
+TEST(Strips, wide_layout_neighbours_of_100k_pixels)
+{
+    auto *ps = makeSerpentine(334, 300);
+    auto *m = BasicNeighboursMatrix<WideLayout>::fromStrips(ps);
+    ASSERT_EQ(m->count, 100200u);
+    auto & ne = m->getNeighbours(70000);
+    ASSERT_EQ(ne.count, 4u);
+    EXPECT_EQ(ne.index[0], 69799u);
+    EXPECT_EQ(ne.index[1], 70001u);
+    EXPECT_EQ(ne.index[2], 70399u);
+    EXPECT_EQ(ne.index[3], 69999u);
+    int bad = 0;
+    for (uint32_t i=0;i<m->count;++i)
+    {
+        auto & n = m->getNeighbours(i);
+        bad += n.count < 2 || n.count > 6;
+        for (uint32_t k=0;k<n.count;++k) bad += n.index[k] >= m->count;
+    }
+    EXPECT_EQ(bad, 0);
+    release(m);
+    release(ps);
+}
+
+TEST(Strips, wide_layout_clip)
+{
+    auto *ps = makeSerpentine(334, 300);
+    auto *c = clipStrips(ps, 70000);
+    EXPECT_EQ(c->count, 234u);
+    EXPECT_EQ(c->getTotalPixelsCount(), 70000u);
+    EXPECT_EQ(c->element[233].count, 100);
+    release(c);
+    release(ps);
+}
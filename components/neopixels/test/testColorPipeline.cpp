@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <color_pipeline.hpp>
+#include <cmath>
+#include <vector>
+#include <cstring>
+
+using namespace Neopixel;
+
+// generated by the compiler, not at startup
+static_assert(Gamma::table[0] == 0 && Gamma::table[255] == 255);
+
+TEST(ColorPipeline, gamma_table_matches_pow)
+{
+    for (int i=0;i<256;++i)
+    {
+        const double expected = 255.0 * std::pow(i / 255.0, 2.2);
+        EXPECT_NEAR(Gamma::table[i], expected, 0.51) << i;
+        if (i) {
+            EXPECT_GE(Gamma::table[i], Gamma::table[i-1]);
+        }
+    }
+}
+
+TEST(ColorPipeline, no_correction_is_identity)
+{
+    ColorPipeline cp;
+    cp.build(NoCorrection, 255);
+    std::vector<RGB> px(256);
+    for (int i=0;i<256;++i) px[i] = { uint8_t(i), uint8_t(255-i), uint8_t(i*7) };
+    std::vector<uint8_t> wire(3*256);
+    cp.encode(px.data(), 256, wire.data());
+    EXPECT_EQ(memcmp(wire.data(), px.data(), wire.size()), 0);
+}
+
+TEST(ColorPipeline, every_color_order)
+{
+    const RGB px {1,2,3};
+    const struct { ColorOrder order; uint8_t w[3]; } cases[] = {
+        {ColorOrder::RGB, {1,2,3}}, {ColorOrder::RBG, {1,3,2}}, {ColorOrder::GRB, {2,1,3}},
+        {ColorOrder::GBR, {2,3,1}}, {ColorOrder::BRG, {3,1,2}}, {ColorOrder::BGR, {3,2,1}},
+    };
+    for (auto & c : cases)
+    {
+        ColorPipeline cp;
+        cp.build({c.order, false, {255,255,255}}, 255);
+        uint8_t wire[3];
+        cp.encode(&px, 1, wire);
+        EXPECT_EQ(wire[0], c.w[0]);
+        EXPECT_EQ(wire[1], c.w[1]);
+        EXPECT_EQ(wire[2], c.w[2]);
+    }
+}
+
+TEST(ColorPipeline, brightness_and_white_balance)
+{
+    ColorPipeline cp;
+    // white balance follows the channel, not the wire position
+    cp.build({ColorOrder::GRB, false, {255,128,0}}, 255);
+    const RGB px {200,200,200};
+    uint8_t wire[3];
+    cp.encode(&px, 1, wire);
+    EXPECT_EQ(wire[0], 100);    //g
+    EXPECT_EQ(wire[1], 200);    //r
+    EXPECT_EQ(wire[2], 0);      //b
+
+    cp.build(NoCorrection, 0);
+    cp.encode(&px, 1, wire);
+    EXPECT_EQ(wire[0] | wire[1] | wire[2], 0);
+}
+
+TEST(ColorPipeline, gamma_then_brightness)
+{
+    ColorPipeline cp;
+    cp.build({ColorOrder::RGB, true, {255,255,255}}, 128);
+    for (int v=0;v<256;++v)
+    {
+        const int expected = (Gamma::table[v] * 128 + 127) / 255;
+        EXPECT_NEAR(cp.lut[0][v], expected, 1) << v;
+    }
+    EXPECT_EQ(cp.lut[1][255], 128);
+}
+
+TEST(ColorPipeline, rgb_format_is_the_plain_encode)
+{
+    ColorPipeline cp;
+    cp.build({ColorOrder::GRB, true, {255,200,180}}, 230);
+    std::vector<RGB> px(256);
+    for (int i=0;i<256;++i) px[i] = { uint8_t(i), uint8_t(255-i), uint8_t(i*7) };
+    std::vector<uint8_t> a(3*256), b(3*256);
+    cp.encode(px.data(), 256, a.data());
+    cp.encode<PixelRGB>(px.data(), 256, b.data());
+    EXPECT_EQ(a, b);
+    static_assert(PixelRGB::Bytes == 3 && !PixelRGB::White);
+}
+
+TEST(ColorPipeline, rgbw_moves_the_common_part_to_white)
+{
+    ColorPipeline cp;
+    cp.build(NoCorrection, 255);
+    const RGB px[4] = {{200,120,80}, {0,50,90}, {255,255,255}, {7,7,9}};
+    const uint8_t expected[4][4] = {{120,40,0,80}, {0,50,90,0}, {0,0,0,255}, {0,0,2,7}};
+    uint8_t wire[16];
+    cp.encode<PixelRGBW>(px, 4, wire);
+    for (int i=0;i<4;++i)
+        for (int k=0;k<4;++k) EXPECT_EQ(wire[4*i+k], expected[i][k]) << i << " " << k;
+}
+
+TEST(ColorPipeline, rgbw_white_after_order_and_correction)
+{
+    ColorPipeline cp;
+    // white is extracted from the corrected values, so balance is kept : w = min(100,200,200)
+    cp.build({ColorOrder::GRB, false, {255,128,255}}, 255);
+    const RGB px {200,200,200};
+    uint8_t wire[4];
+    cp.encode<PixelRGBW>(&px, 1, wire);
+    EXPECT_EQ(wire[0], 0);      //g
+    EXPECT_EQ(wire[1], 100);    //r
+    EXPECT_EQ(wire[2], 100);    //b
+    EXPECT_EQ(wire[3], 100);    //w
+}
+
+TEST(ColorPipeline, rgbw_16bit_dithers_every_wire_byte)
+{
+    ColorPipeline cp;
+    ColorPipeline::Lut16 lut16;
+    cp.lut16 = &lut16;
+    cp.build(NoCorrection, 255, true);
+    // r 10.5, g 3.25, b 3.25 -> w 3.25, r 7.25
+    const RGB16 px {uint16_t(0xa80 * 257 / 256), uint16_t(0x340 * 257 / 256), uint16_t(0x340 * 257 / 256)};
+    uint8_t residual[4] = {};
+    uint32_t sum[4] = {};
+    constexpr int Frames = 256;
+    for (int n=0;n<Frames;++n)
+    {
+        uint8_t wire[4];
+        cp.encode<PixelRGBW>(&px, 1, wire, residual);
+        for (int k=0;k<4;++k) sum[k] += wire[k];
+    }
+    EXPECT_NEAR(sum[0] / double(Frames), 7.25, 0.02);
+    EXPECT_EQ(sum[1], 0);
+    EXPECT_EQ(sum[2], 0);
+    EXPECT_NEAR(sum[3] / double(Frames), 3.25, 0.02);
+}
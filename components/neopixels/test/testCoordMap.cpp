@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <coord_map.hpp>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+// uneven lines, reversed ones and a gap at 40..44
+Subset tree[] = {{0,10,1},{10,17,-1},{27,1,1},{28,12,-1},{45,20,1}};
+}
+
+TEST(CoordMap, getPoint1D_matches_the_dividing_version)
+{
+    Strips *pstrips = makeStrips(tree);
+    const auto *m = CoordMap::acquire(pstrips);
+    ASSERT_NE(m, nullptr);
+    const uint16_t nmax = pstrips->getLongestLine();
+    EXPECT_EQ(m->longest, nmax);
+    for (uint16_t line=0;line<pstrips->count;++line)
+    {
+        for (uint32_t pos=0;pos<=(uint32_t(nmax - 1) << 8 | 0xff);++pos)
+        {
+            const auto expected = Strips::getPoint1D(uint16_t(pos), nmax, pstrips->element[line]);
+            ASSERT_EQ(m->getPoint1D(uint16_t(pos), line), expected) << "line " << line << " pos " << pos;
+        }
+    }
+    for (uint16_t x=0;x<pstrips->count<<8;x+=7)
+    {
+        for (uint16_t y=0;y<(nmax - 1)<<8;y+=13)
+        {
+            const auto a = pstrips->getPoint2D(x, y, nmax);
+            const auto b = m->getPoint2D(x, y);
+            ASSERT_EQ(a.n_points, b.n_points);
+            for (int k=0;k<a.n_points;++k)
+            {
+                EXPECT_EQ(a.idx[k], b.idx[k]);
+                EXPECT_EQ(a.value[k], b.value[k]);
+            }
+        }
+    }
+    CoordMap::release(m);
+    release(pstrips);
+}
+TEST(CoordMap, wide_lines_keep_the_reciprocal_exact)
+{
+    BasicSubset<WideLayout> su[] = {{0,1000,1},{1000,999,-1},{1999,3,1},{2002,641,-1}};
+    auto *pstrips = makeStrips(su);
+    const auto *m = BasicCoordMap<WideLayout>::acquire(pstrips);
+    const uint32_t nmax = 1000;
+    for (uint32_t line=0;line<4;++line)
+    {
+        for (uint32_t pos=0;pos<(nmax - 1) << 8;pos+=3)
+        {
+            ASSERT_EQ(m->getPoint1D(pos, line), BasicStrips<WideLayout>::getPoint1D(pos, nmax, su[line])) << line << ' ' << pos;
+        }
+    }
+    BasicCoordMap<WideLayout>::release(m);
+    release(pstrips);
+}
+TEST(CoordMap, pixel_positions_and_line_rows)
+{
+    Strips *pstrips = makeStrips(tree);
+    const auto *m = CoordMap::acquire(pstrips);
+    EXPECT_EQ(m->totalPixels, 65);
+    EXPECT_EQ(m->rowSize, 32u);
+    for (uint16_t line=0;line<pstrips->count;++line)
+    {
+        const auto & s = pstrips->element[line];
+        for (int j=0;j<s.count;++j)
+        {
+            const uint16_t p = m->row(line)[j];
+            EXPECT_EQ(p, s.dir > 0 ? s.first + j : s.first + s.count - 1 - j);
+            EXPECT_EQ(m->line(p), line);
+            EXPECT_EQ(m->x(p), line << 8);
+            // the position is the pixel itself, no neighbour share
+            const auto [idx, next, frac] = m->getPoint1D(m->y(p), line);
+            EXPECT_EQ(idx, p);
+            EXPECT_EQ(frac, 0);
+        }
+    }
+    // the last pixel of every line sits at the end of the grid
+    EXPECT_EQ(m->y(9), 19 << 8);
+    EXPECT_EQ(m->y(10), 19 << 8);
+    EXPECT_EQ(m->y(27), 0);
+    for (uint16_t p=40;p<45;++p)
+    {
+        EXPECT_EQ(m->line(p), CoordMap::Unmapped);
+        EXPECT_EQ(m->y(p), CoordMap::Unmapped);
+    }
+    CoordMap::release(m);
+    release(pstrips);
+}
+TEST(CoordMap, one_map_per_layout_shared_until_the_last_release)
+{
+    const auto before = Mem::stats(MemTag::Layout);
+    Strips *a = makeStrips(tree);
+    Strips *b = clipStrips(a, 1000);    //same lines, another block
+    Subset other[] = {{0,3,1},{3,3,-1},{6,3,1}};
+    Strips *c = makeStrips(other);
+
+    const auto *ma = CoordMap::acquire(a);
+    const auto *mb = CoordMap::acquire(b);
+    const auto *mc = CoordMap::acquire(c);
+    EXPECT_EQ(ma, mb);
+    EXPECT_NE(ma, mc);
+    // the map has its own copy of the lines
+    release(a);
+    release(b);
+    EXPECT_EQ(ma->strips->count, 5);
+    EXPECT_EQ(ma->row(4)[19], 64);
+
+    // neighbours are built once and match a table built from the strips
+    const auto *n = mc->neighbours();
+    ASSERT_NE(n, nullptr);
+    EXPECT_EQ(mc->neighbours(), n);
+    auto *ref = NeighboursMatrix::fromStrips(c);
+    for (uint16_t p=0;p<9;++p)
+    {
+        const auto & e = ref->getNeighbours(p);
+        ASSERT_EQ(n->getNeighbours(p).count, e.count);
+        for (int k=0;k<e.count;++k) EXPECT_EQ(n->getNeighbours(p).index[k], e.index[k]);
+    }
+    release(ref);
+    release(c);
+
+    CoordMap::release(ma);
+    EXPECT_EQ(mb->longest, 20);     //still held by the second acquire
+    CoordMap::release(mb);
+    CoordMap::release(mc);
+    EXPECT_EQ(Mem::stats(MemTag::Layout).current, before.current);
+    EXPECT_EQ(Mem::stats(MemTag::Layout).blocks, before.blocks);
+}
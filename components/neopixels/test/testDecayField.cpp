@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <decay_field.hpp>
+#include <led_strip.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+// no span, every pixel write is a fillPixelsRGB call and is counted
+struct CountingStrip : LedStrip
+{
+    explicit CountingStrip(int n) : buffer(n, RGB{1,1,1}) {}
+    int getLength() const override { return int(buffer.size()); }
+    RGB* getBuffer() override { return buffer.data(); }
+    void setPixelsRGB(int first, int num, const RGB* rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb[i];
+        writes += num;
+    }
+    void fillPixelsRGB(int first, int num, const RGB& rgb) override
+    {
+        for (int i=0;i<num;++i) buffer[first + i] = rgb;
+        writes += num;
+    }
+    void setPixelsHSV(int, int, const HSV*) override {}
+    void refresh(bool) override {}
+    void copyFrontToBack() override {}
+    bool waitReady(uint32_t) override { return true; }
+    void release() override {}
+    std::vector<RGB> buffer;
+    int writes = 0;
+};
+}
+
+TEST(DecayField, first_tick_matches_scale8_then_decays_geometrically)
+{
+    for (int fade : {0, 1, 100, 200, 254})
+    {
+        DecayField field;
+        ASSERT_TRUE(field.init(4, uint8_t(fade), MemTag::Layout));
+        for (int c=0;c<256;c+=5)
+        {
+            field.set(1, {uint8_t(c), 255, 0});
+            field.tick();
+            RGB expected {uint8_t(c), 255, 0};
+            expected.scale8(uint8_t(fade));
+            EXPECT_EQ(field.get(1).r, expected.r) << fade << ' ' << c;
+            EXPECT_EQ(field.get(1).g, expected.g);
+            EXPECT_EQ(field.get(1).b, 0);
+        }
+        // one truncation instead of one per tick : at or above the repeated fade, within 1.5 of the exact decay
+        field.set(2, {255, 255, 255});
+        RGB repeated {255, 255, 255};
+        for (int t=1;t<300;++t)
+        {
+            field.tick();
+            repeated.scale8(uint8_t(fade));
+            const double exact = 255 * std::pow((fade + 1) / 256.0, t);
+            EXPECT_GE(field.get(2).r, repeated.r);
+            EXPECT_NEAR(field.get(2).r, exact, 1.5) << fade << " tick " << t;
+            EXPECT_EQ(field.level(2), field.get(2).r);
+        }
+    }
+}
+TEST(DecayField, unset_pixels_are_dark_and_full_fade_holds)
+{
+    DecayField field;
+    ASSERT_TRUE(field.init(100, 255, MemTag::Layout));
+    EXPECT_EQ(field.get(7).r, 0);
+    EXPECT_EQ(field.level(7), 0);
+    field.set(7, {10, 20, 30}, 90);
+    for (int t=0;t<70000;++t) field.tick();
+    EXPECT_EQ(field.get(7).r, 10);
+    EXPECT_EQ(field.get(7).b, 30);
+    EXPECT_EQ(field.level(7), 90);
+    EXPECT_EQ(field.liveCount(), 1);
+}
+TEST(DecayField, render_writes_live_pixels_only_and_drops_them_at_black)
+{
+    CountingStrip strip(450);
+    DecayField field;
+    ASSERT_TRUE(field.init(450, 127, MemTag::Layout));
+    field.render(&strip);
+    EXPECT_EQ(strip.writes, 0);
+
+    field.set(10, {200, 0, 0});
+    field.set(300, {0, 0, 255});
+    field.set(10, {255, 0, 0});     //set twice, listed once
+    EXPECT_EQ(field.liveCount(), 2);
+    field.render(&strip);
+    EXPECT_EQ(strip.writes, 2);
+    EXPECT_EQ(strip.buffer[10].r, 255);
+    EXPECT_EQ(strip.buffer[300].b, 255);
+    EXPECT_EQ(strip.buffer[11].r, 1);   //untouched
+    field.render(&strip);               //no tick, nothing to write
+    EXPECT_EQ(strip.writes, 2);
+
+    // halving, black after 8 ticks : written every frame until then, once more at black
+    int frames = 0;
+    while (field.liveCount() > 0)
+    {
+        field.tick();
+        field.render(&strip);
+        ++frames;
+        ASSERT_LT(frames, 20);
+    }
+    EXPECT_EQ(frames, 8);
+    EXPECT_EQ(strip.writes, 2 + 2 * 8);
+    EXPECT_EQ(strip.buffer[10].r, 0);
+    EXPECT_EQ(strip.buffer[300].b, 0);
+    // a dropped pixel comes back when set again
+    field.set(300, {0, 9, 0});
+    field.render(&strip);
+    EXPECT_EQ(strip.buffer[300].g, 9);
+}
+TEST(DecayField, wide_layout_and_memory_tag)
+{
+    const auto before = Mem::stats(MemTag::Random);
+    {
+        BasicDecayField<WideLayout> field;
+        ASSERT_TRUE(field.init(70000, 200, MemTag::Random));
+        EXPECT_EQ(Mem::stats(MemTag::Random).blocks, before.blocks + 1);
+        field.set(69999, {50, 50, 50});
+        field.tick();
+        EXPECT_EQ(field.get(69999).r, 50 * 201 >> 8);
+        EXPECT_EQ(field.get(65535).r, 0);
+    }
+    EXPECT_EQ(Mem::stats(MemTag::Random).current, before.current);
+}
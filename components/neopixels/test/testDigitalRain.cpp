@@ -120,6 +120,7 @@ TEST(DigitalRain, test_drawLine)
     
     auto *anim = makeAnimation(pstrips,{{"hue_min",120}},&led_strip,random);
     anim->head_length = 3;
+    EXPECT_CALL(led_strip, getLength()).WillRepeatedly(Return(40));
 
     const auto l1_indices = anim->line_indices;
     const auto l2_indices = anim->line_indices + anim->indices_row_size;
@@ -196,3 +197,61 @@ TEST(DigitalRain, test_drawLine)
     delete anim;
     release(pstrips);
 }
+
+// 300 pixel lines wrapped an int8_t position before, every draw has to stay on its own line
+TEST(DigitalRain, wide_layout_lines_longer_than_255)
+{
+    constexpr int Lines = 334, Length = 300;
+    std::vector<BasicSubset<WideLayout>> su;
+    for (int i=0;i<Lines;++i) {
+        su.push_back({ uint32_t(i * Length), uint16_t(Length), int8_t(i & 1 ? -1 : 1) });
+    }
+    auto *pstrips = makeStrips(su.data(), su.size());
+    MockLedStrip led_strip;
+    MockRandomGenerator random;
+    EXPECT_CALL(random, make_random()).WillRepeatedly(Return(0));
+    uint8_t params[18];
+    void *p = params;
+    encode<uint16_t>(p, 20);    //delay
+    encode<uint16_t>(p, 120);   //hue min
+    encode<uint16_t>(p, 120);   //hue max
+    encode<int8_t>(p, 0);       //hue inc
+    encode<uint8_t>(p, 0);      //hue mode
+    encode<int16_t>(p, 255);    //color value
+    encode<int8_t>(p, 3);       //head length
+    encode<uint16_t>(p, 10);    //tail length min, Count wide
+    encode<uint16_t>(p, 30);    //tail length max
+    BasicDigitalRainAnimation<WideLayout> anim(&led_strip, (uint8_t*)p - params, params, pstrips, &random);
+    EXPECT_EQ(anim.totalPixels, 100200u);
+    EXPECT_EQ(anim.tail_length_max, 30);
+    for (int i=0;i<Lines;++i) ASSERT_EQ(anim.rain_lines[i].position, Length - 1);
+
+    EXPECT_CALL(led_strip, refresh(true)).Times(Length + 20);
+    // the mock has no span, tails come through the per pixel fallback
+    EXPECT_CALL(led_strip, getLength()).WillRepeatedly(Return(Lines * Length));
+    int off_line = 0;
+    int lowest = Length, highest = -1;
+    auto check = [&](int first, int num) {
+        const int line = first / Length;
+        off_line += first < 0 || (first + num - 1) / Length != line;
+        if (line == Lines - 1)
+        {
+            // the last line runs down from 100199
+            lowest = std::min(lowest, first - line * Length);
+            highest = std::max(highest, first + num - 1 - line * Length);
+        }
+    };
+    for (int step=0; step<Length + 20; ++step)
+    {
+        anim.step();
+        for (auto & c : led_strip.rgb_calls) check(c.first, c.num);
+        for (auto & c : led_strip.hsv_calls) check(c.first, c.num);
+        led_strip.rgb_calls.clear();
+        led_strip.hsv_calls.clear();
+    }
+    EXPECT_EQ(off_line, 0);
+    // the drop went over the whole line
+    EXPECT_EQ(lowest, 0);
+    EXPECT_EQ(highest, Length - 1);
+    release(pstrips);
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <FireAnimation.hpp>
+#include <led_strip.hpp>
+#include <collections.hpp>
+#include <random.hpp>
+#include <utils.hpp>
+#include <vector>
+#include <cstring>
+
+using namespace Neopixel;
+using namespace ::testing;
+
+namespace
+{
+struct MockLedStrip : public LedStrip
+{
+    MOCK_METHOD( int,  getLength,    (), (const));
+    MOCK_METHOD( RGB*, getBuffer,    ());
+    MOCK_METHOD( void, setPixelsRGB, (int first, int num, const RGB*));
+    MOCK_METHOD( void, fillPixelsRGB,(int first, int num, const RGB&));
+    MOCK_METHOD( void, setPixelsHSV, (int first, int num, const HSV*));
+    MOCK_METHOD( void, refresh,      (bool wait));
+    MOCK_METHOD( void, copyFrontToBack,());
+    MOCK_METHOD( bool, waitReady,    (uint32_t timeout_ms));
+    MOCK_METHOD( void, release,      ());
+};
+// the same value on every call
+struct FixedRandom : public RandomGenerator
+{
+    uint32_t value = 0;
+    uint32_t make_random() override { return value; }
+    void make_random_n(uint32_t *values, int length) override { for (int i=0;i<length;++i) values[i] = value; }
+    void release() override {}
+};
+constexpr int NumPixels = 20;
+constexpr uint8_t Outside = 0x5a;
+// processSingleStrip and the heat cells exposed
+struct TestFire : public FireAnimation
+{
+    using FireAnimation::FireAnimation;
+    using FireAnimation::processSingleStrip;
+    using FireAnimation::heat;
+};
+std::vector<uint8_t> encodeParams(uint8_t cooling, uint8_t sparking, uint8_t direction)
+{
+    std::vector<uint8_t> params(5);
+    void *p = params.data();
+    encode<uint16_t>(p, 20);
+    encode<uint8_t>(p, cooling);
+    encode<uint8_t>(p, sparking);
+    encode<uint8_t>(p, direction);
+    return params;
+}
+struct Fire : public Test
+{
+    NiceMock<MockLedStrip> strip;
+    FixedRandom random;
+    TestFire* make(uint8_t cooling, uint8_t sparking, uint8_t direction)
+    {
+        ON_CALL(strip, getLength()).WillByDefault(Return(NumPixels));
+        auto params = encodeParams(cooling, sparking, direction);
+        auto *fire = new TestFire(&strip, int(params.size()), params.data(), nullptr, &random);
+        memset(fire->heat, Outside, NumPixels);
+        return fire;
+    }
+};
+}
+// random 0 : no cooling, a 160 spark on the first cell of the flame every step
+TEST_F(Fire, spark_at_the_bottom_and_rising_for_each_direction)
+{
+    struct Case { Subset line; uint8_t direction; int bottom; int inc; };
+    const Case cases[] = {
+        {{2, 6, 1},  1, 2,  1},
+        {{2, 6, 1},  0, 7, -1},
+        {{10, 6, -1}, 1, 15, -1},
+        {{10, 6, -1}, 0, 10,  1},
+    };
+    for (const auto& c : cases)
+    {
+        auto *fire = make(0, 255, c.direction);
+        for (int i=0;i<c.line.count;++i) fire->heat[c.line.first + i] = 0;
+
+        fire->processSingleStrip(c.line);
+        for (int i=0;i<c.line.count;++i)
+        {
+            const int idx = c.bottom + c.inc * i;
+            EXPECT_EQ(fire->heat[idx], i == 0 ? 160 : 0) << "dir " << int(c.line.dir) << " direction " << int(c.direction) << " cell " << i;
+        }
+        // the spark drifts up two cells, (0 + 2 * 160) / 3
+        fire->processSingleStrip(c.line);
+        EXPECT_EQ(fire->heat[c.bottom], 255);
+        EXPECT_EQ(fire->heat[c.bottom + 2 * c.inc], 106);
+        EXPECT_EQ(fire->heat[c.bottom + c.inc], 0);
+        delete fire;
+    }
+}
+TEST_F(Fire, heat_stays_inside_each_line)
+{
+    Subset su[] = { {1, 5, 1}, {8, 1, 1}, {13, 6, -1} };
+    for (uint8_t direction : {0, 1})
+    {
+        auto *fire = make(50, 255, direction);
+        for (const auto& s : su) memset(fire->heat + s.first, 0, s.count);
+        for (uint32_t step=0;step<200;++step)
+        {
+            random.value = step * 0x9e3779b9u;
+            for (const auto& s : su) fire->processSingleStrip(s);
+        }
+        std::vector<bool> inside(NumPixels, false);
+        for (const auto& s : su) for (int i=0;i<s.count;++i) inside[s.first + i] = true;
+        for (int i=0;i<NumPixels;++i)
+        {
+            if (!inside[i]) {
+                EXPECT_EQ(fire->heat[i], Outside) << "pixel " << i << " direction " << int(direction);
+            }
+        }
+        delete fire;
+    }
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <frame_interpolator.hpp>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using namespace Neopixel;
+
+namespace
+{
+constexpr int Leds = 16;
+
+std::vector<RGB> uniform(uint8_t v) { return std::vector<RGB>(Leds, RGB{v, v, v}); }
+
+struct Interp
+{
+    Interp() : mem(FrameInterpolator::Buffers * Leds) { fi.init(mem.data(), Leds); }
+    std::vector<RGB> mem;
+    FrameInterpolator fi;
+};
+}
+
+TEST(FrameInterpolator, blend_ends_and_middle)
+{
+    const RGB a[2] = {{0,100,255},{10,20,30}};
+    const RGB b[2] = {{255,0,255},{30,20,10}};
+    RGB out[2];
+    blendFrames(a, b, out, 2, 0);
+    EXPECT_EQ(out[0].r, 0);   EXPECT_EQ(out[0].g, 100); EXPECT_EQ(out[1].b, 30);
+    blendFrames(a, b, out, 2, 256);
+    EXPECT_EQ(out[0].r, 255); EXPECT_EQ(out[0].g, 0);   EXPECT_EQ(out[1].b, 10);
+    blendFrames(a, b, out, 2, 128);
+    EXPECT_EQ(out[0].r, 127); EXPECT_EQ(out[0].g, 50);  EXPECT_EQ(out[0].b, 255);
+    EXPECT_EQ(out[1].r, 20);  EXPECT_EQ(out[1].g, 20);  EXPECT_EQ(out[1].b, 20);
+}
+
+TEST(FrameInterpolator, first_frame_is_shown_as_is)
+{
+    Interp it;
+    it.fi.push(uniform(200).data(), 5000000);
+    EXPECT_EQ(it.fi.output(5000001)[0].r, 200);
+    EXPECT_EQ(it.fi.lastAlpha(), 256);
+}
+
+TEST(FrameInterpolator, output_moves_across_the_render_interval)
+{
+    Interp it;
+    it.fi.push(uniform(0).data(), 1000);
+    it.fi.output(1000);
+    it.fi.push(uniform(200).data(), 101000);    //100ms render delay
+    // one interval behind : the new frame is reached 100ms after it was rendered
+    EXPECT_EQ(it.fi.output(101000)[0].r, 0);
+    EXPECT_EQ(it.fi.output(126000)[5].g, 50);
+    EXPECT_EQ(it.fi.output(151000)[0].b, 100);
+    EXPECT_EQ(it.fi.output(176000)[Leds-1].r, 150);
+    EXPECT_EQ(it.fi.output(201000)[0].r, 200);
+    EXPECT_EQ(it.fi.output(900000)[0].r, 200);
+    EXPECT_EQ(it.fi.lastAlpha(), 256);
+}
+
+TEST(FrameInterpolator, blend_is_monotonic_between_renders)
+{
+    Interp it;
+    it.fi.push(uniform(10).data(), 0);
+    it.fi.output(0);
+    it.fi.push(uniform(250).data(), 40000);
+    uint8_t last = 0;
+    for (uint32_t t=40000; t<=80000; t+=1000)
+    {
+        const uint8_t v = it.fi.output(t)[0].r;
+        EXPECT_GE(v, last);
+        last = v;
+    }
+    EXPECT_EQ(last, 250);
+}
+
+TEST(FrameInterpolator, long_pause_is_a_step)
+{
+    Interp it;
+    it.fi.push(uniform(0).data(), 0);
+    it.fi.output(0);
+    it.fi.push(uniform(90).data(), 2 * FrameInterpolator::DefaultMaxIntervalUs);
+    EXPECT_EQ(it.fi.output(2 * FrameInterpolator::DefaultMaxIntervalUs)[0].r, 90);
+}
+
+TEST(FrameInterpolator, latest_push_wins_between_outputs)
+{
+    Interp it;
+    it.fi.push(uniform(0).data(), 0);
+    it.fi.output(0);
+    it.fi.push(uniform(50).data(), 10000);
+    it.fi.push(uniform(60).data(), 20000);
+    it.fi.push(uniform(70).data(), 30000);
+    EXPECT_EQ(it.fi.output(60000)[0].r, 70);
+    // the blend starts from the last frame the consumer saw
+    EXPECT_EQ(it.fi.output(30000)[0].r, 0);
+}
+
+// frames are uniform, any mixed pixel means a buffer was written while being read
+TEST(FrameInterpolator, handover_between_tasks_never_tears)
+{
+    Interp it;
+    std::atomic<bool> done { false };
+    std::atomic<uint32_t> now { 0 };
+    std::thread producer([&] {
+        for (int f=1; f<=20000; ++f)
+        {
+            const auto frame = uniform(uint8_t(f));
+            it.fi.push(frame.data(), now.fetch_add(7));
+        }
+        done = true;
+    });
+    int torn = 0, outputs = 0;
+    while (!done)
+    {
+        const RGB *px = it.fi.output(now.fetch_add(3));
+        for (int i=1;i<Leds;++i) {
+            torn += px[i].r != px[0].r || px[i].g != px[0].r || px[i].b != px[0].r;
+        }
+        ++outputs;
+    }
+    producer.join();
+    EXPECT_GT(outputs, 0);
+    EXPECT_EQ(torn, 0);
+}
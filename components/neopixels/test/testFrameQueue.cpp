@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <frame_queue.hpp>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using namespace Neopixel;
+
+namespace
+{
+constexpr int Leds = 64;
+
+// frame number spread over the channels, every pixel carries it
+RGB tag(uint32_t seq) { return { uint8_t(seq), uint8_t(seq >> 8), uint8_t(seq >> 16) }; }
+uint32_t seqOf(const RGB& c) { return c.r | (c.g << 8) | (c.b << 16); }
+
+struct Queue
+{
+    explicit Queue(int slots) : mem(slots * Leds) { q.init(mem.data(), slots, Leds); }
+    void render(uint32_t seq)
+    {
+        RGB *px = q.producerSlot();
+        for (int i=0;i<Leds;++i) px[i] = tag(seq);
+    }
+    std::vector<RGB> mem;
+    FrameQueue q;
+};
+}
+
+TEST(FrameQueue, frames_come_out_in_commit_order)
+{
+    Queue fq(4);
+    EXPECT_EQ(fq.q.depth(), 3);
+    EXPECT_EQ(fq.q.peek(), nullptr);
+    for (uint32_t f=1; f<=3; ++f)
+    {
+        fq.render(f);
+        EXPECT_TRUE(fq.q.tryCommit(f * 10));
+    }
+    EXPECT_EQ(fq.q.size(), 3);
+    for (uint32_t f=1; f<=3; ++f)
+    {
+        uint32_t t = 0;
+        const RGB *px = fq.q.peek(&t);
+        ASSERT_NE(px, nullptr);
+        EXPECT_EQ(seqOf(px[Leds-1]), f);
+        EXPECT_EQ(t, f * 10);
+        fq.q.pop();
+    }
+    EXPECT_EQ(fq.q.peek(), nullptr);
+}
+
+TEST(FrameQueue, commit_fails_when_depth_frames_wait)
+{
+    Queue fq(3);
+    fq.render(1);
+    EXPECT_TRUE(fq.q.tryCommit(0));
+    fq.render(2);
+    EXPECT_TRUE(fq.q.tryCommit(0));
+    fq.render(3);
+    EXPECT_FALSE(fq.q.tryCommit(0));
+    // the rendered frame stays in the producer slot until there is room
+    EXPECT_EQ(seqOf(fq.q.producerSlot()[0]), 3u);
+    fq.q.pop();
+    EXPECT_TRUE(fq.q.tryCommit(0));
+    EXPECT_EQ(seqOf(fq.q.peek()[0]), 2u);
+}
+
+TEST(FrameQueue, new_producer_slot_starts_from_the_committed_frame)
+{
+    Queue fq(2);
+    for (uint32_t f=1; f<=5; ++f)
+    {
+        // only one pixel changes, the rest has to be carried over
+        fq.q.producerSlot()[f] = tag(f);
+        ASSERT_TRUE(fq.q.tryCommit(0));
+        const RGB *px = fq.q.peek();
+        for (uint32_t i=1; i<=f; ++i) EXPECT_EQ(seqOf(px[i]), i);
+        fq.q.pop();
+    }
+}
+
+// every frame is uniform and numbered : a mixed frame is a torn slot, a gap is a lost frame
+TEST(FrameQueue, producer_and_consumer_threads_never_tear_or_lose_frames)
+{
+    constexpr uint32_t Frames = 200000;
+    Queue fq(4);
+    std::atomic<int> full { 0 };
+    std::thread producer([&] {
+        for (uint32_t f=1; f<=Frames; ++f)
+        {
+            fq.render(f);
+            while (!fq.q.tryCommit(f)) {
+                full.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t expected = 1;
+    int torn = 0, lost = 0, max_depth = 0;
+    while (expected <= Frames)
+    {
+        uint32_t t = 0;
+        const RGB *px = fq.q.peek(&t);
+        if (!px)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        max_depth = std::max(max_depth, fq.q.size());
+        const uint32_t seq = seqOf(px[0]);
+        for (int i=1;i<Leds;++i) torn += seqOf(px[i]) != seq;
+        torn += t != seq;
+        lost += seq != expected;
+        expected = seq + 1;
+        fq.q.pop();
+    }
+    producer.join();
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(lost, 0);
+    EXPECT_LE(max_depth, fq.q.depth());
+    EXPECT_EQ(fq.q.peek(), nullptr);
+}
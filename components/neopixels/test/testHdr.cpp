@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <hdr.hpp>
+#include <color_pipeline.hpp>
+#include <cmath>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+struct FadeQuality
+{
+    double rms_error;   //8 frame moving average of the output vs the ideal curve, in 8 bit steps
+    int longest_stall;  //frames with the same output while the ideal moved by more than one step
+};
+// one pixel fading from full scale to 1/255 over num_frames, sent without correction
+template <typename Step>
+FadeQuality measureFade(int num_frames, Step&& step)
+{
+    const double f = std::exp(std::log(1.0/255) / num_frames);
+    constexpr int W = 8;
+    std::vector<double> out;
+    double err2 = 0;
+    int stall = 0, longest = 0;
+    double stall_start_ideal = 255;
+    for (int n=0;n<num_frames;++n)
+    {
+        const uint8_t v = step();
+        out.push_back(v);
+        if (n && v == out[n-1])
+        {
+            ++stall;
+            if (stall_start_ideal - 255 * std::pow(f, n) > 1.0) longest = std::max(longest, stall);
+        }
+        else
+        {
+            stall = 0;
+            stall_start_ideal = 255 * std::pow(f, n);
+        }
+        if (n >= W)
+        {
+            double avg = 0, ideal = 0;
+            for (int k=n-W+1;k<=n;++k)
+            {
+                avg += out[k];
+                ideal += 255 * std::pow(f, k+1);
+            }
+            err2 += (avg - ideal) * (avg - ideal) / (W * W);
+        }
+    }
+    return { std::sqrt(err2 / (num_frames - W)), longest };
+}
+}
+
+TEST(Hdr, fade16_never_stalls)
+{
+    RGB16 px {0xffff, 300, 1};
+    for (int i=0;i<100;++i)
+    {
+        const RGB16 before = px;
+        fade16(&px, 1, 0xfff0);
+        if (before.g) {
+            EXPECT_LT(px.g, before.g);
+        }
+        if (before.b) {
+            EXPECT_LT(px.b, before.b);
+        }
+    }
+    EXPECT_EQ(px.b, 0);
+}
+
+TEST(Hdr, blend16_reaches_both_ends)
+{
+    RGB16 dst {0, 0xffff, 0x8000};
+    const RGB16 src {0xffff, 0, 0x8000};
+    RGB16 d = dst;
+    blend16(&d, &src, 1, 0);
+    EXPECT_EQ(d.r, 0);
+    EXPECT_EQ(d.g, 0xffff);
+    for (int i=0;i<2000;++i) blend16(&d, &src, 1, 0x0800);
+    EXPECT_GE(d.r, 0xffff - 32);
+    EXPECT_LE(d.g, 32);
+    EXPECT_EQ(d.b, 0x8000);
+    blend16(&dst, 1, {0,0,0}, 0x8000);
+    EXPECT_EQ(dst.g, 0x7fff);
+}
+
+TEST(Hdr, dither_averages_to_the_16bit_value)
+{
+    ColorPipeline cp;
+    ColorPipeline::Lut16 lut16;
+    cp.lut16 = &lut16;
+    cp.build(NoCorrection, 255, true);
+    // 1.5 and 100.25 in 8 bit steps
+    const RGB16 px {uint16_t(0x180 * 257 / 256), uint16_t(25664 * 257 / 256), 0};
+    uint8_t residual[3] = {};
+    uint32_t sum[3] = {};
+    constexpr int Frames = 256;
+    for (int n=0;n<Frames;++n)
+    {
+        uint8_t wire[3];
+        cp.encode(&px, 1, wire, residual);
+        for (int k=0;k<3;++k) sum[k] += wire[k];
+        EXPECT_TRUE(wire[0] == 1 || wire[0] == 2);
+    }
+    EXPECT_NEAR(sum[0] / double(Frames), 1.5, 0.02);
+    EXPECT_NEAR(sum[1] / double(Frames), 100.25, 0.02);
+    EXPECT_EQ(sum[2], 0);
+}
+
+TEST(Hdr, full_scale_and_gamma_tables)
+{
+    ColorPipeline cp;
+    ColorPipeline::Lut16 lut16;
+    cp.lut16 = &lut16;
+    cp.build({ColorOrder::GRB, true, {255,255,255}}, 255, true);
+    const RGB16 px {0xffff, 0, 0x8000};
+    uint8_t residual[3] = {}, wire[3];
+    cp.encode(&px, 1, wire, residual);
+    EXPECT_EQ(wire[0], 0);
+    EXPECT_EQ(wire[1], 255);
+    EXPECT_EQ(residual[1], 0);
+    // 0.5^2.2 * 255 = 55.5
+    EXPECT_NEAR(wire[2] + residual[2] / 256.0, 55.5, 0.5);
+}
+
+TEST(Hdr, slow_fade_is_smoother_than_8bit)
+{
+    constexpr int Frames = 600;    //10 s at 60 fps
+    const double f = std::exp(std::log(1.0/255) / Frames);
+
+    RGB px8 {255,255,255};
+    const uint8_t scale8 = uint8_t(std::lround(f * 256) - 1);
+    auto q8 = measureFade(Frames, [&]{ px8.scale8(scale8); return px8.r; });
+
+    ColorPipeline cp;
+    ColorPipeline::Lut16 lut16;
+    cp.lut16 = &lut16;
+    cp.build(NoCorrection, 255, true);
+    RGB16 px16 {0xffff,0xffff,0xffff};
+    uint8_t residual[3] = {};
+    const uint16_t scale16 = uint16_t(std::lround(f * 65536));
+    auto q16 = measureFade(Frames, [&]{
+        fade16(&px16, 1, scale16);
+        uint8_t wire[3];
+        cp.encode(&px16, 1, wire, residual);
+        return wire[0];
+    });
+    printf("slow fade %d frames : 8 bit rms %.2f stall %d, 16 bit rms %.2f stall %d\n",
+        Frames, q8.rms_error, q8.longest_stall, q16.rms_error, q16.longest_stall);
+    EXPECT_LT(q16.rms_error * 4, q8.rms_error);
+    EXPECT_LE(q16.longest_stall, q8.longest_stall);
+    EXPECT_LT(q16.rms_error, 0.5);
+}
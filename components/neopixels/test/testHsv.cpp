@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <hsv.hpp>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+bool same(const RGB& a, const RGB& b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+}
+
+// every hue, a grid of saturations and values, hues past 360 included
+TEST(Hsv, batch_matches_toRGB_exactly)
+{
+    std::vector<HSV> hsv;
+    for (int h=0;h<1080;++h) {
+        for (int s=0;s<256;s+=15) {
+            for (int v=0;v<256;v+=15) hsv.push_back({uint16_t(h), uint8_t(s), uint8_t(v)});
+        }
+    }
+    hsv.push_back({65535, 255, 255});
+    std::vector<RGB> rgb(hsv.size());
+    hsvToRgb(hsv.data(), rgb.data(), int(hsv.size()));
+    int mismatches = 0;
+    for (size_t i=0;i<hsv.size();++i) mismatches += !same(rgb[i], hsv[i].toRGB());
+    EXPECT_EQ(mismatches, 0);
+}
+
+TEST(Hsv, spectrum_matches_toRGB_exactly)
+{
+    HueSpectrum sp;
+    for (int sv : {0, 128, 200, 255})
+    {
+        sp.build(255, uint8_t(sv));
+        for (int h=0;h<720;++h) {
+            ASSERT_TRUE(same(sp[uint16_t(h)], (HSV{uint16_t(h), 255, uint8_t(sv)}.toRGB()))) << h;
+        }
+    }
+    const uint16_t hues[] = {0, 59, 60, 359, 360, 1000};
+    RGB out[6];
+    sp.toRgb(hues, out, 6);
+    for (int i=0;i<6;++i) EXPECT_TRUE(same(out[i], (HSV{hues[i], 255, 255}.toRGB())));
+}
+
+TEST(Hsv, spectrum_fill_walks_the_hue_circle)
+{
+    HueSpectrum sp;
+    sp.build(240, 200);
+    RGB up[10], down[10];
+    sp.fill(350, 7, up, 10);
+    sp.fill(5, -400, down, 10);
+    for (int i=0;i<10;++i)
+    {
+        EXPECT_TRUE(same(up[i], (HSV{uint16_t((350 + 7 * i) % 360), 240, 200}.toRGB()))) << i;
+        // -400 is -40 around the circle
+        EXPECT_TRUE(same(down[i], (HSV{uint16_t(((5 - 40 * i) % 360 + 360) % 360), 240, 200}.toRGB()))) << i;
+    }
+}
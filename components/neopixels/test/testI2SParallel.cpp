@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <i2s_parallel.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+using namespace NeopixelDrv;
+
+namespace
+{
+// bit i of out[j] = bit (7-j) of lanes[i]
+void transposeReference(const uint8_t lanes[8], uint8_t out[8])
+{
+    for (int j=0;j<8;++j)
+    {
+        out[j] = 0;
+        for (int i=0;i<8;++i) {
+            out[j] |= ((lanes[i] >> (7-j)) & 1) << i;
+        }
+    }
+}
+// reads lane bytes back from the samples, checks the fixed part of every bit pattern
+template <typename Word>
+std::vector<std::vector<uint8_t>> decodeLanes(const Word* samples, size_t n, int n_lanes, const size_t* lane_bytes, const I2SBitPattern& p)
+{
+    std::vector<std::vector<uint8_t>> lanes(n_lanes);
+    size_t max_bytes = 0;
+    for (int l=0;l<n_lanes;++l) max_bytes = std::max(max_bytes, lane_bytes[l]);
+    EXPECT_EQ(n, max_bytes * 8 * p.slots + p.reset_slots);
+
+    const Word *ps = samples;
+    for (size_t b=0;b<max_bytes;++b)
+    {
+        for (int l=0;l<n_lanes;++l) {
+            if (b < lane_bytes[l]) lanes[l].push_back(0);
+        }
+        for (int j=0;j<8;++j,ps+=p.slots)
+        {
+            for (int l=0;l<n_lanes;++l)
+            {
+                const bool active = b < lane_bytes[l];
+                auto bit = [&](int s){ return (ps[s] >> l) & 1; };
+                for (int s=0;s<p.t0h_slots;++s)         EXPECT_EQ(bit(s), active ? 1 : 0);
+                for (int s=p.t1h_slots;s<p.slots;++s)   EXPECT_EQ(bit(s), 0);
+                const int v = bit(p.t0h_slots);
+                for (int s=p.t0h_slots;s<p.t1h_slots;++s) EXPECT_EQ(bit(s), v);
+                if (active) lanes[l].back() |= v << (7-j);
+                else        EXPECT_EQ(v, 0);
+            }
+        }
+    }
+    for (int s=0;s<p.reset_slots;++s,++ps) EXPECT_EQ(*ps, 0);
+    return lanes;
+}
+template <typename Word>
+void roundtrip(const std::vector<size_t>& sizes, const I2SBitPattern& pattern)
+{
+    std::mt19937 gen(sizes.size());
+    const int n_lanes = sizes.size();
+    std::vector<std::vector<uint8_t>> data(n_lanes);
+    std::vector<const uint8_t*> ptrs(n_lanes);
+    size_t max_bytes = 0;
+    for (int l=0;l<n_lanes;++l)
+    {
+        data[l].resize(sizes[l]);
+        for (auto & v : data[l]) v = uint8_t(gen());
+        ptrs[l] = data[l].data();
+        max_bytes = std::max(max_bytes, sizes[l]);
+    }
+    std::vector<Word> samples(i2sParallelSamples(max_bytes, pattern));
+    const auto n = encodeI2SParallel<Word>(ptrs.data(), sizes.data(), n_lanes, pattern, samples.data());
+    ASSERT_EQ(n, samples.size());
+    auto lanes = decodeLanes(samples.data(), n, n_lanes, sizes.data(), pattern);
+    for (int l=0;l<n_lanes;++l) {
+        EXPECT_EQ(lanes[l], data[l]) << "lane " << l;
+    }
+}
+}
+
+TEST(I2SParallel, transpose_reference)
+{
+    std::mt19937 gen(1234);
+    for (int k=0;k<10000;++k)
+    {
+        uint8_t lanes[8], out[8], ref[8];
+        for (auto & v : lanes) v = uint8_t(gen());
+        transpose8x8(lanes, out);
+        transposeReference(lanes, ref);
+        for (int j=0;j<8;++j) {
+            ASSERT_EQ(out[j], ref[j]);
+        }
+    }
+}
+
+TEST(I2SParallel, transpose_single_bits)
+{
+    for (int i=0;i<8;++i)
+    {
+        for (int b=0;b<8;++b)
+        {
+            uint8_t lanes[8] = {}, out[8];
+            lanes[i] = uint8_t(1 << b);
+            transpose8x8(lanes, out);
+            for (int j=0;j<8;++j) {
+                EXPECT_EQ(out[j], j == 7-b ? (1 << i) : 0);
+            }
+        }
+    }
+}
+
+TEST(I2SParallel, encode_8_lanes)
+{
+    roundtrip<uint8_t>({30,30,30,30,30,30,30,30}, {3,1,2,4});
+}
+
+TEST(I2SParallel, encode_16_lanes_uneven)
+{
+    roundtrip<uint16_t>({84,81,84,78,84,84,84,84,81,81,81,84,84,84,66,66}, {6,1,3,120});
+}
+
+TEST(I2SParallel, encode_fewer_lanes_than_word)
+{
+    roundtrip<uint16_t>({9,3,12}, {3,1,2,0});
+}
+
+TEST(I2SParallel, bit_pattern)
+{
+    const uint8_t lane0[] = {0x80};
+    const uint8_t* lanes[] = {lane0};
+    const size_t sizes[] = {1};
+    uint8_t samples[8*3+1];
+    auto n = encodeI2SParallel<uint8_t>(lanes, sizes, 1, {3,1,2,1}, samples);
+    ASSERT_EQ(n, sizeof(samples));
+    // bit 7 set : high high low, bit 6 clear : high low low
+    EXPECT_EQ(samples[0], 1); EXPECT_EQ(samples[1], 1); EXPECT_EQ(samples[2], 0);
+    EXPECT_EQ(samples[3], 1); EXPECT_EQ(samples[4], 0); EXPECT_EQ(samples[5], 0);
+    EXPECT_EQ(samples[24], 0);
+}
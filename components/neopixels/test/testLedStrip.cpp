@@ -0,0 +1,663 @@
+#include <gtest/gtest.h>
+#include <led_strip_impl.hpp>
+#include <neopixel_drv.h>
+#include <color.hpp>
+#include <pixel_map.hpp>
+#include <mem_tracker.hpp>
+#include <vector>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+
+using namespace Neopixel;
+
+namespace
+{
+// virtual time, advanced by the mock drivers as they do work
+uint32_t now_us = 0;
+uint32_t mockClock() { return now_us; }
+
+struct MockDriver : public NeopixelDrv::Driver
+{
+    static constexpr uint32_t PrepareUs = 200;  //encoding cost
+    static constexpr uint32_t StartUs   = 1;
+    static constexpr uint32_t LedUs     = 30;   //24 bits at 800kHz
+
+    void prepare(int size, const uint8_t* data) override
+    {
+        now_us += PrepareUs;
+        prepared_size = size / 3;
+        sent.assign(data, data + size);
+    }
+    void start() override
+    {
+        start_us = now_us;
+        done_us  = now_us + prepared_size * LedUs;
+        now_us  += StartUs;
+        ++frames;
+    }
+    bool wait(uint32_t) override
+    {
+        if (int32_t(done_us - now_us) > 0) now_us = done_us;
+        return true;
+    }
+    uint32_t doneTimestamp() const override { return done_us; }
+    void unload() override { unloaded = true; }
+
+    int prepared_size = 0;
+    std::vector<uint8_t> sent;
+    uint32_t start_us = 0, done_us = 0;
+    int frames = 0;
+    bool unloaded = false;
+};
+
+template <typename Format>
+struct BasicTestStrip
+{
+    explicit BasicTestStrip(std::vector<int> sizes, const ColorCorrection& cc = NoCorrection) :
+        drivers(sizes.size()), segments(sizes.size()), stats(sizes.size())
+    {
+        int total = 0;
+        for (auto n : sizes) total += n;
+        wire.resize(Format::Bytes * total);
+        uint8_t *w = wire.data();
+        for (size_t i=0;i<sizes.size();++i)
+        {
+            segments[i].num_leds = sizes[i];
+            segments[i].driver = &drivers[i];
+            segments[i].color = cc;
+            segments[i].wire = w;
+            w += Format::Bytes * sizes[i];
+        }
+        buffer.resize(total);
+        void *raw = Mem::alloc(1, MemTag::Strip);  //released by LedStripImpl::release
+        strip = new LedStripImpl<Format>(total, sizes.size(), segments.data(), stats.data(), buffer.data(), buffer.data(), raw, mockClock);
+    }
+    void useHdr()
+    {
+        buffer16.resize(buffer.size() * 2);
+        dither.assign(wire.size(), 0);
+        lut16.resize(segments.size());
+        uint8_t *d = dither.data();
+        for (auto & s : segments)
+        {
+            s.pipeline.lut16 = &lut16[&s - segments.data()];
+            s.dither = d;
+            d += Format::Bytes * s.num_leds;
+        }
+        strip->setHdrBuffers(buffer16.data(), buffer16.data() + buffer.size());
+    }
+    ~BasicTestStrip()
+    {
+        strip->release();
+        delete strip;
+    }
+    std::vector<MockDriver> drivers;
+    std::vector<SegmentInfo> segments;
+    std::vector<SegmentStats> stats;
+    std::vector<RGB> buffer;
+    std::vector<uint8_t> wire;
+    std::vector<RGB16> buffer16;
+    std::vector<uint8_t> dither;
+    std::vector<ColorPipeline::Lut16> lut16;
+    LedStripImpl<Format> *strip;
+};
+using TestStrip = BasicTestStrip<PixelRGB>;
+}
+
+TEST(LedStrip, segments_get_their_part_of_the_buffer)
+{
+    TestStrip ts({150,100,200});
+    for (int i=0;i<450;++i) {
+        ts.buffer[i] = { uint8_t(i), uint8_t(i>>8), 7 };
+    }
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].sent[0], 0);
+    EXPECT_EQ(ts.drivers[1].sent[0], 150);
+    EXPECT_EQ(ts.drivers[2].sent[0], 250 & 0xff);
+    EXPECT_EQ(ts.drivers[2].sent[1], 250 >> 8);
+    EXPECT_EQ(ts.drivers[2].sent[2], 7);
+    EXPECT_EQ(ts.drivers[2].prepared_size, 200);
+}
+
+TEST(LedStrip, all_segments_start_before_any_finishes)
+{
+    now_us = 0;
+    TestStrip ts({150,150,150});
+    ts.strip->refresh(true);
+    uint32_t first_done = ts.drivers[0].done_us;
+    uint32_t last_start = 0;
+    for (auto & d : ts.drivers)
+    {
+        first_done = std::min(first_done, d.done_us);
+        last_start = std::max(last_start, d.start_us);
+    }
+    EXPECT_LT(last_start, first_done);
+
+    auto *st = ts.strip->getStats();
+    ASSERT_NE(st, nullptr);
+    EXPECT_EQ(st->frames, 1);
+    EXPECT_EQ(st->num_segments, 3);
+    // starts are back to back, encoding is not in between
+    EXPECT_LE(st->start_skew_us, 2*MockDriver::StartUs);
+    EXPECT_LE(st->latch_skew_us, 2*MockDriver::StartUs);
+    for (int i=0;i<3;++i)
+    {
+        EXPECT_EQ(st->segments[i].start_us, ts.drivers[i].start_us);
+        EXPECT_EQ(st->segments[i].done_us,  ts.drivers[i].done_us);
+        EXPECT_EQ(st->segments[i].tx_us, 150*MockDriver::LedUs);
+    }
+}
+
+TEST(LedStrip, frame_time_is_longest_segment)
+{
+    now_us = 0;
+    TestStrip ts({150,300});
+    ts.strip->refresh(false);
+    const uint32_t started = now_us;
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(now_us - started + MockDriver::StartUs, 300*MockDriver::LedUs);
+    auto *st = ts.strip->getStats();
+    EXPECT_EQ(st->segments[0].tx_us, 150*MockDriver::LedUs);
+    EXPECT_EQ(st->segments[1].tx_us, 300*MockDriver::LedUs);
+    EXPECT_EQ(st->latch_skew_us, 150*MockDriver::LedUs + MockDriver::StartUs);
+}
+
+TEST(LedStrip, stats_collected_once_per_frame)
+{
+    TestStrip ts({10,10});
+    ts.strip->refresh(true);
+    ts.strip->waitReady(1000);
+    ts.strip->fillPixelsRGB(0, 20, {1,1,1});  //unchanged frames are not sent
+    ts.strip->refresh(false);
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.strip->getStats()->frames, 2);
+    EXPECT_EQ(ts.drivers[0].frames, 2);
+}
+
+TEST(LedStrip, set_and_fill)
+{
+    TestStrip ts({4,4});
+    ts.strip->fillPixelsRGB(0, 8, {1,2,3});
+    RGB px[2] = {{9,9,9},{8,8,8}};
+    ts.strip->setPixelsRGB(6, 4, px);   //clipped to the strip length
+    EXPECT_EQ(ts.buffer[5].r, 1);
+    EXPECT_EQ(ts.buffer[6].r, 9);
+    EXPECT_EQ(ts.buffer[7].r, 8);
+}
+
+TEST(LedStrip, color_order_applied_on_the_wire)
+{
+    TestStrip ts({2,2}, {ColorOrder::GRB, false, {255,255,255}});
+    ts.strip->fillPixelsRGB(0, 4, {10,20,30});
+    ts.strip->refresh(true);
+    const std::vector<uint8_t> grb {20,10,30, 20,10,30};
+    EXPECT_EQ(ts.drivers[0].sent, grb);
+    EXPECT_EQ(ts.drivers[1].sent, grb);
+    EXPECT_EQ(ts.buffer[0].r, 10);
+}
+
+TEST(LedStrip, brightness_does_not_touch_the_buffer)
+{
+    TestStrip ts({3});
+    ts.strip->fillPixelsRGB(0, 3, {200,100,50});
+    ts.strip->setBrightness(128);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].sent[0], 100);
+    EXPECT_EQ(ts.drivers[0].sent[1], 50);
+    EXPECT_EQ(ts.drivers[0].sent[2], 25);
+    EXPECT_EQ(ts.buffer[0].r, 200);
+    ts.strip->setBrightness(255);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].sent[0], 200);
+}
+
+TEST(LedStrip, hdr_buffer_is_dithered_on_output)
+{
+    TestStrip ts({2,2});
+    ts.useHdr();
+    EXPECT_EQ(ts.strip->getBuffer(), nullptr);
+    // 1.75 in 8 bit steps : 1 then 2 on the wire
+    const RGB16 half { 0x1c0 * 257 / 256, 0, 0xffff };
+    for (int n=0;n<2;++n)
+    {
+        auto *px = ts.strip->getBuffer16();
+        ASSERT_NE(px, nullptr);
+        for (int i=0;i<4;++i) px[i] = half;
+        ts.strip->refresh(true);
+        for (auto & d : ts.drivers)
+        {
+            EXPECT_EQ(d.sent[0], 1 + n);
+            EXPECT_EQ(d.sent[2], 255);
+        }
+    }
+    ts.strip->fillPixelsRGB(0, 4, {255,0,0});
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[1].sent[3], 255);
+}
+
+TEST(LedStrip, power_limited_on_the_outgoing_frame)
+{
+    TestStrip ts({100,100}, {ColorOrder::GRB, false, {255,255,255}});
+    ts.strip->setPowerBudget({4000, {18500,18500,18500}, 1000, 0});
+    ts.strip->fillPixelsRGB(0, 200, {255,0,0});
+    ts.strip->refresh(true);
+    auto *st = ts.strip->getStats();
+    EXPECT_EQ(st->power_mA, 200 * 19.5);
+    EXPECT_EQ(st->power_scale, 256);
+    EXPECT_EQ(st->limited_frames, 0);
+    EXPECT_EQ(ts.drivers[1].sent[1], 255);
+
+    ts.strip->fillPixelsRGB(0, 200, {255,255,255});
+    ts.strip->refresh(true);
+    EXPECT_EQ(st->power_mA, 200 * 56.5);
+    EXPECT_LT(st->power_scale, 256);
+    EXPECT_EQ(st->limited_frames, 1);
+    // limited on the wire only, same scale everywhere
+    const uint8_t v = ts.drivers[0].sent[0];
+    EXPECT_LT(v, 255);
+    EXPECT_EQ(ts.drivers[1].sent[299], v);
+    EXPECT_LE(200 * (3 * 18.5 * v / 255 + 1), 4000);
+    EXPECT_EQ(ts.buffer[0].g, 255);
+}
+
+TEST(LedStrip, unchanged_frame_is_not_sent)
+{
+    TestStrip ts({100,100});
+    ts.strip->fillPixelsRGB(0, 200, {1,2,3});
+    ts.strip->refresh(true);
+    ts.strip->refresh(true);
+    auto *st = ts.strip->getStats();
+    EXPECT_EQ(ts.drivers[0].frames, 1);
+    EXPECT_EQ(ts.drivers[1].frames, 1);
+    EXPECT_EQ(st->skipped_bytes, 600);
+    EXPECT_EQ(st->total_skipped_bytes, 600);
+    EXPECT_EQ(st->frames, 1);
+}
+
+TEST(LedStrip, setters_send_up_to_the_last_changed_pixel)
+{
+    TestStrip ts({100,100,100});
+    ts.strip->fillPixelsRGB(0, 300, {0,0,0});
+    ts.strip->refresh(true);
+    // CmdSet touching 3 pixels in the middle segment
+    ts.strip->fillPixelsRGB(120, 3, {9,9,9});
+    ts.strip->refresh(true);
+    auto *st = ts.strip->getStats();
+    EXPECT_EQ(ts.drivers[0].frames, 1);
+    EXPECT_EQ(ts.drivers[1].frames, 2);
+    EXPECT_EQ(ts.drivers[2].frames, 1);
+    EXPECT_EQ(ts.drivers[1].prepared_size, 23);
+    EXPECT_EQ(ts.drivers[1].sent[3*22], 9);
+    EXPECT_EQ(ts.drivers[1].sent[3*19], 0);
+    EXPECT_EQ(st->segments[0].bytes, 0);
+    EXPECT_EQ(st->segments[1].bytes, 3*23);
+    EXPECT_EQ(st->skipped_bytes, 900 - 3*23);
+}
+
+// the app's budget only estimates the draw, setter frames are still cut short
+TEST(LedStrip, estimate_only_power_keeps_range_tracking)
+{
+    TestStrip ts({100,100,100});
+    const PowerBudget tree_power { 0, {18500,18500,18500}, 1000, 0 };
+    ts.strip->setPowerBudget(tree_power);
+    ts.strip->fillPixelsRGB(0, 300, {0,0,0});
+    ts.strip->refresh(true);
+    ts.strip->fillPixelsRGB(120, 3, {9,9,9});
+    ts.strip->refresh(true);
+    auto *st = ts.strip->getStats();
+    EXPECT_EQ(ts.drivers[0].frames, 1);
+    EXPECT_EQ(ts.drivers[1].frames, 2);
+    EXPECT_EQ(ts.drivers[1].prepared_size, 23);
+    EXPECT_EQ(st->skipped_bytes, 900 - 3*23);
+    // estimated on the whole frame, not the part sent
+    const uint64_t sums[3] = {27, 27, 27};
+    EXPECT_EQ(st->power_mA, estimateCurrent_mA(tree_power, sums, 300));
+    EXPECT_EQ(st->limited_frames, 0);
+}
+
+TEST(LedStrip, direct_writes_fall_back_to_the_frame_hash)
+{
+    TestStrip ts({100,100});
+    ts.strip->fillPixelsRGB(0, 200, {0,0,0});
+    ts.strip->refresh(true);
+    // same content written through the buffer pointer
+    auto *px = ts.strip->getBuffer();
+    px[150] = {0,0,0};
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[1].frames, 1);
+    px = ts.strip->getBuffer();
+    px[150] = {5,0,0};
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].frames, 1);
+    EXPECT_EQ(ts.drivers[1].frames, 2);
+    EXPECT_EQ(ts.drivers[1].prepared_size, 100);
+    EXPECT_EQ(ts.drivers[1].sent[150], 5);
+}
+
+TEST(LedStrip, transform_writes_a_tracked_span)
+{
+    TestStrip ts({100,100,100});
+    ts.strip->fillPixelsRGB(0, 300, {0,0,0});
+    ts.strip->refresh(true);
+    ts.strip->transform(110, 5, [](int i) { return RGB{uint8_t(i + 1), 0, 0}; });
+    ts.strip->refresh(true);
+    // only the middle segment is resent, up to the last written pixel
+    EXPECT_EQ(ts.drivers[0].frames, 1);
+    EXPECT_EQ(ts.drivers[1].frames, 2);
+    EXPECT_EQ(ts.drivers[2].frames, 1);
+    EXPECT_EQ(ts.drivers[1].prepared_size, 15);
+    EXPECT_EQ(ts.buffer[110].r, 1);
+    EXPECT_EQ(ts.buffer[114].r, 5);
+    // clipped like the setters
+    ts.strip->transform(298, 10, [](int) { return RGB{7,7,7}; });
+    EXPECT_EQ(ts.buffer[299].g, 7);
+}
+
+TEST(LedStrip, scatter_writes_the_indexed_pixels)
+{
+    TestStrip ts({10,10});
+    // a reversed line, written in line order
+    const uint16_t line[] = {14, 13, 12, 11};
+    ts.strip->scatter(line, 4, [](int i) { return RGB{uint8_t(10 * i), 1, 2}; });
+    EXPECT_EQ(ts.buffer[14].r, 0);
+    EXPECT_EQ(ts.buffer[11].r, 30);
+    EXPECT_EQ(ts.buffer[10].g, 0);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[1].sent[3*1], 30);
+    // indices past the end are dropped, the rest is still written
+    const uint16_t past[] = {19, 25};
+    ts.strip->scatter(past, 2, [](int) { return RGB{9,9,9}; });
+    EXPECT_EQ(ts.buffer[19].r, 9);
+}
+
+TEST(LedStrip, bulk_writes_on_hdr_strip_go_through_the_setters)
+{
+    TestStrip ts({2,2});
+    ts.useHdr();
+    ts.strip->transform(0, 4, [](int i) { return RGB{uint8_t(i == 3 ? 255 : 0), 0, 0}; });
+    const uint16_t idx[] = {0};
+    ts.strip->scatter(idx, 1, [](int) { return RGB{0,0,255}; });
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[1].sent[3], 255);
+    EXPECT_EQ(ts.drivers[0].sent[2], 255);
+}
+
+TEST(LedStrip, brightness_change_resends_everything)
+{
+    TestStrip ts({10,10});
+    ts.strip->fillPixelsRGB(0, 20, {100,100,100});
+    ts.strip->refresh(true);
+    ts.strip->setBrightness(100);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].frames, 2);
+    EXPECT_EQ(ts.drivers[1].frames, 2);
+    EXPECT_EQ(ts.strip->getStats()->skipped_bytes, 0);
+}
+
+TEST(LedStrip, rotation_is_applied_while_encoding)
+{
+    TestStrip ts({5,5});
+    for (int i=0;i<10;++i) ts.buffer[i] = { uint8_t(i), 0, 0 };
+    const RotationRange whole {0, 10, 0};
+    ts.strip->setRotationRanges(&whole, 1);
+    ts.strip->setRotation(0, -3);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].sent[0], 7);
+    EXPECT_EQ(ts.drivers[0].sent[9], 0);
+    EXPECT_EQ(ts.drivers[1].sent[0], 2);
+    EXPECT_EQ(ts.buffer[0].r, 0);
+    // scrolling alone changes the frame
+    ts.strip->setRotation(0, 1);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].frames, 2);
+    EXPECT_EQ(ts.drivers[0].sent[0], 1);
+    EXPECT_EQ(ts.drivers[1].sent[12], 0);
+}
+
+TEST(LedStrip, invalid_rotation_is_ignored)
+{
+    TestStrip ts({5,5});
+    for (int i=0;i<10;++i) ts.buffer[i] = { uint8_t(i), 0, 0 };
+    const RotationRange empty[] = { {0, 5, 1}, {5, 0, 0} };
+    ts.strip->setRotationRanges(empty, 2);
+    ts.strip->setRotation(1, 3);
+    ts.strip->setRotation(-1, 3);
+    const RotationRange past {6, 5, 0};
+    ts.strip->setRotationRanges(&past, 1);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].sent[3], 1);
+    EXPECT_EQ(ts.drivers[1].sent[0], 5);
+}
+
+// the pixels are unchanged but the wire bytes still hold the old mapping
+TEST(LedStrip, map_change_resends_the_frame)
+{
+    TestStrip ts({5,5});
+    for (int i=0;i<10;++i) ts.strip->fillPixelsRGB(i, 1, { uint8_t(i), 0, 0 });
+    const RotationRange whole {0, 10, 3};
+    ts.strip->setRotationRanges(&whole, 1);
+    ts.strip->refresh(true);
+    ts.strip->setRotationRanges(nullptr, 0);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].frames, 2);
+    EXPECT_EQ(ts.drivers[0].sent[3], 1);
+    EXPECT_EQ(ts.drivers[1].sent[3], 6);
+
+    static const uint16_t mirror[10] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+    ts.strip->setRemap(mirror, 10);
+    ts.strip->refresh(true);
+    ts.strip->setRemap(nullptr, 0);
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].frames, 4);
+    EXPECT_EQ(ts.drivers[0].sent[3], 1);
+    EXPECT_EQ(ts.drivers[1].sent[3], 6);
+}
+
+TEST(LedStrip, remap_mirrors_and_skips_dead_pixels)
+{
+    TestStrip ts({4,4});
+    // second segment wired backwards, its last physical pixel is dead
+    static const uint16_t remap[8] = { 0, 1, 2, 3, 6, 5, 4, PixelMap::Dead };
+    ts.strip->setRemap(remap, 7);
+    EXPECT_EQ(ts.strip->getLength(), 7);
+    for (int i=0;i<7;++i) ts.strip->fillPixelsRGB(i, 1, { uint8_t(10+i), 1, 1 });
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].sent[9], 13);
+    EXPECT_EQ(ts.drivers[1].sent[0], 16);
+    EXPECT_EQ(ts.drivers[1].sent[6], 14);
+    EXPECT_EQ(ts.drivers[1].sent[9], 0);
+    EXPECT_EQ(ts.drivers[1].sent[10], 0);
+    ts.strip->setRemap(nullptr, 0);
+    EXPECT_EQ(ts.strip->getLength(), 8);
+}
+
+TEST(LedStrip, interpolated_output_blends_rendered_frames)
+{
+    now_us = 0;
+    TestStrip ts({4,4});
+    std::vector<RGB> frames(FrameInterpolator::Buffers * 8);
+    ts.strip->setInterpolationBuffers(frames.data());
+
+    ts.strip->fillPixelsRGB(0, 8, {0,0,0});
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.drivers[0].frames, 0);     //refresh only queues
+    ts.strip->outputFrame();
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.drivers[0].frames, 1);
+
+    now_us = 100000;
+    ts.strip->fillPixelsRGB(0, 8, {200,100,40});
+    ts.strip->refresh(false);
+    now_us = 150000;
+    ts.strip->outputFrame();
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.drivers[1].sent[0], 100);
+    EXPECT_EQ(ts.drivers[1].sent[1], 50);
+    EXPECT_EQ(ts.drivers[1].sent[2], 20);
+
+    now_us = 250000;
+    ts.strip->outputFrame();
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.drivers[0].sent[0], 200);
+    EXPECT_EQ(ts.drivers[0].sent[11], 40);
+    // the blend has settled, nothing left to send
+    const int sent = ts.drivers[0].frames;
+    ts.strip->outputFrame();
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.drivers[0].frames, sent);
+}
+
+// rotation and brightness set after a refresh belong to the next frame, not to the one queued
+TEST(LedStrip, interpolated_frame_keeps_its_rotation_and_brightness)
+{
+    now_us = 0;
+    TestStrip ts({4,4});
+    std::vector<RGB> frames(FrameInterpolator::Buffers * 8);
+    ts.strip->setInterpolationBuffers(frames.data());
+    const RotationRange whole {0, 8, 0};
+    ts.strip->setRotationRanges(&whole, 1);
+
+    for (int i=0;i<8;++i) ts.strip->fillPixelsRGB(i, 1, { uint8_t(10 * i), 0, 0 });
+    ts.strip->setRotation(0, 1);
+    ts.strip->refresh(false);
+    // the next shift and dimming come before the output task picks the frame up
+    ts.strip->setRotation(0, 2);
+    ts.strip->setBrightness(0);
+    ts.strip->outputFrame();
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.drivers[0].sent[0], 10);
+    EXPECT_EQ(ts.drivers[1].sent[9], 0);
+    EXPECT_EQ(ts.drivers[0].sent[3], 20);
+
+    now_us = 100000;
+    ts.strip->refresh(false);
+    now_us = 300000;
+    ts.strip->outputFrame();
+    ts.strip->waitReady(1000);
+    EXPECT_EQ(ts.drivers[0].sent[0], 0);
+    EXPECT_EQ(ts.drivers[0].sent[3], 0);
+}
+
+TEST(LedStrip, rgbw_segments_send_four_bytes_per_pixel)
+{
+    BasicTestStrip<PixelRGBW> ts({2,3}, {ColorOrder::GRB, false, {255,255,255}});
+    ts.strip->fillPixelsRGB(0, 5, {40,100,30});
+    ts.strip->refresh(true);
+    ASSERT_EQ(ts.drivers[0].sent.size(), 8);
+    ASSERT_EQ(ts.drivers[1].sent.size(), 12);
+    // g r b w, the common 30 goes to white
+    const uint8_t px[4] = {70,10,0,30};
+    for (int i=0;i<12;++i) EXPECT_EQ(ts.drivers[1].sent[i], px[i % 4]);
+    EXPECT_EQ(ts.strip->getStats()->segments[1].bytes, 12);
+
+    // tracked frames are cut after the last changed pixel in 4 byte steps
+    ts.strip->copyFrontToBack();
+    ts.strip->fillPixelsRGB(3, 1, {0,0,0});
+    ts.strip->refresh(true);
+    EXPECT_EQ(ts.strip->getStats()->segments[0].bytes, 0);
+    ASSERT_EQ(ts.drivers[1].sent.size(), 8);
+    EXPECT_EQ(ts.drivers[1].sent[4], 0);
+    EXPECT_EQ(ts.drivers[1].sent[7], 0);
+    EXPECT_EQ(ts.strip->getStats()->skipped_bytes, 8 + 4);
+}
+
+TEST(LedStrip, rgbw_power_counts_the_white_channel)
+{
+    BasicTestStrip<PixelRGBW> ts({10});
+    ts.strip->setPowerBudget({0, {20000,20000,20000}, 0, 40000});
+    ts.strip->fillPixelsRGB(0, 10, {255,255,255});
+    ts.strip->refresh(true);
+    // all on the white led : 10 * 40mA
+    EXPECT_EQ(ts.strip->getStats()->power_mA, 400);
+}
+
+TEST(LedStrip, queued_refresh_renders_ahead_of_output)
+{
+    now_us = 0;
+    TestStrip ts({3,3});
+    std::vector<RGB> slots(4 * 6);
+    ts.strip->setFrameQueue(slots.data(), 4, []{});
+    for (int f=1; f<=3; ++f)
+    {
+        ts.strip->fillPixelsRGB(0, 6, {uint8_t(f), 0, 0});
+        ts.strip->refresh(false);
+    }
+    EXPECT_EQ(ts.drivers[0].frames, 0);     //refresh only queues
+    for (int f=1; f<=3; ++f)
+    {
+        EXPECT_TRUE(ts.strip->outputFrame());
+        ts.strip->waitReady(1000);
+        EXPECT_EQ(ts.drivers[0].sent[0], f);
+        EXPECT_EQ(ts.drivers[1].sent[6], f);
+        EXPECT_EQ(ts.strip->getStats()->queued, uint32_t(3 - f));
+    }
+    EXPECT_FALSE(ts.strip->outputFrame());
+    EXPECT_EQ(ts.drivers[0].frames, 3);
+    EXPECT_EQ(ts.strip->getStats()->queue_full, 0u);
+}
+
+// frames rendered ahead leave the queue with the rotation and brightness of their refresh
+TEST(LedStrip, queued_frames_keep_their_rotation_and_brightness)
+{
+    now_us = 0;
+    TestStrip ts({3,3});
+    std::vector<RGB> slots(4 * 6);
+    ts.strip->setFrameQueue(slots.data(), 4, []{});
+    const RotationRange whole {0, 6, 0};
+    ts.strip->setRotationRanges(&whole, 1);
+    for (int i=0;i<6;++i) ts.strip->fillPixelsRGB(i, 1, { uint8_t(10 * (i + 1)), 0, 0 });
+    for (int f=0; f<3; ++f)
+    {
+        ts.strip->setRotation(0, f);
+        ts.strip->setBrightness(f == 2 ? 0 : 255);
+        ts.strip->refresh(false);
+    }
+    for (int f=0; f<3; ++f)
+    {
+        ASSERT_TRUE(ts.strip->outputFrame());
+        ts.strip->waitReady(1000);
+        EXPECT_EQ(ts.drivers[0].sent[0], f == 2 ? 0 : 10 * (f + 1)) << f;
+        EXPECT_EQ(ts.drivers[1].sent[6], f == 2 ? 0 : 10 * ((5 + f) % 6 + 1)) << f;
+    }
+}
+
+// the renderer thread only touches the queue, the output thread owns the drivers
+TEST(LedStrip, queued_strip_output_thread_sends_every_frame_whole)
+{
+    static std::atomic<uint32_t> render_us { 0 };
+    now_us = 0;
+    TestStrip ts({5,7});
+    std::vector<RGB> slots(3 * 12);
+    ts.strip->setFrameQueue(slots.data(), 3, []{ std::this_thread::yield(); });
+    ts.strip->_clock = []{ return render_us.fetch_add(1); };
+    constexpr int Frames = 5000;
+    std::thread renderer([&] {
+        for (int f=1; f<=Frames; ++f)
+        {
+            ts.strip->fillPixelsRGB(0, 12, {uint8_t(f), uint8_t(f >> 8), 0});
+            ts.strip->refresh(false);
+        }
+    });
+    int expected = 1, torn = 0, lost = 0;
+    while (expected <= Frames)
+    {
+        if (!ts.strip->outputFrame())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ts.strip->waitReady(1000);
+        const auto & a = ts.drivers[0].sent;
+        const auto & b = ts.drivers[1].sent;
+        const int f = a[0] | (a[1] << 8);
+        for (size_t i=0;i<a.size();i+=3) torn += a[i] != a[0] || a[i+1] != a[1];
+        for (size_t i=0;i<b.size();i+=3) torn += b[i] != a[0] || b[i+1] != a[1];
+        lost += f != expected;
+        expected = f + 1;
+    }
+    renderer.join();
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(lost, 0);
+    EXPECT_EQ(ts.drivers[0].frames, Frames);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <mem_tracker.hpp>
+#include <collections.hpp>
+#include <cstring>
+#include <string>
+
+using namespace Neopixel;
+
+// counters are global, tests look at differences only
+TEST(MemTracker, current_and_peak_follow_allocations)
+{
+    const auto before = Mem::stats(MemTag::Fire);
+    auto *a = Mem::alloc<uint8_t>(100, MemTag::Fire);
+    auto *b = Mem::alloc<uint32_t>(50, MemTag::Fire);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+    memset(b, 0xff, 50 * sizeof(uint32_t));
+    auto s = Mem::stats(MemTag::Fire);
+    EXPECT_EQ(s.current - before.current, 300u);
+    EXPECT_EQ(s.blocks - before.blocks, 2u);
+    EXPECT_GE(s.peak, before.current + 300);
+
+    Mem::free(b);
+    Mem::free(a);
+    Mem::free(nullptr);
+    s = Mem::stats(MemTag::Fire);
+    EXPECT_EQ(s.current, before.current);
+    EXPECT_EQ(s.blocks, before.blocks);
+    // the peak remembers the high water mark until reset
+    EXPECT_GE(s.peak, before.current + 300);
+    Mem::resetPeaks();
+    EXPECT_EQ(Mem::stats(MemTag::Fire).peak, before.current);
+}
+
+TEST(MemTracker, tags_are_counted_apart)
+{
+    const auto strip = Mem::stats(MemTag::Strip);
+    const auto driver = Mem::stats(MemTag::Driver);
+    void *p = Mem::alloc(64, MemTag::Driver);
+    EXPECT_EQ(Mem::stats(MemTag::Strip).current, strip.current);
+    EXPECT_EQ(Mem::stats(MemTag::Driver).current, driver.current + 64);
+    Mem::free(p);
+    EXPECT_EQ(Mem::stats(MemTag::Driver).current, driver.current);
+}
+
+TEST(MemTracker, placement_policy)
+{
+    // isr and dma read buffers never land in external ram
+    EXPECT_EQ(Mem::placement(MemTag::Strip), MemPlace::Internal);
+    EXPECT_EQ(Mem::placement(MemTag::Driver), MemPlace::Dma);
+    EXPECT_EQ(Mem::placement(MemTag::RandomWalk), MemPlace::Any);
+    Mem::setPlacement(MemTag::Layout, MemPlace::Internal);
+    EXPECT_EQ(Mem::placement(MemTag::Layout), MemPlace::Internal);
+    Mem::setPlacement(MemTag::Layout, MemPlace::Any);
+    EXPECT_EQ(Mem::placement(MemTag::Layout), MemPlace::Any);
+}
+
+TEST(MemTracker, layout_tables_are_counted_under_the_owner)
+{
+    Subset su[] = {{0,10,1},{10,20,-1},{30,5,1}};
+    Strips *pstrips = makeStrips(su);
+    const auto rain = Mem::stats(MemTag::DigitalRain);
+    auto [indices,row_size] = pstrips->makeIndicesMatrix(MemTag::DigitalRain);
+    EXPECT_EQ(Mem::stats(MemTag::DigitalRain).current - rain.current, 3u * row_size * sizeof(Strips::Index));
+    Mem::free(indices);
+    EXPECT_EQ(Mem::stats(MemTag::DigitalRain).current, rain.current);
+
+    const auto walk = Mem::stats(MemTag::RandomWalk);
+    auto *m = NeighboursMatrix::fromStrips(pstrips, MemTag::RandomWalk);
+    const auto s = Mem::stats(MemTag::RandomWalk);
+    EXPECT_EQ(s.blocks, walk.blocks + 1);
+    EXPECT_EQ(s.current - walk.current, (2u + 35 * 7) * sizeof(Strips::Index));
+    // the scratch tables are gone, but were part of the peak
+    EXPECT_GT(s.peak - walk.current, s.current - walk.current);
+    release(m);
+    EXPECT_EQ(Mem::stats(MemTag::RandomWalk).current, walk.current);
+    release(pstrips);
+}
+
+TEST(MemTracker, report_lists_every_tag)
+{
+    void *p = Mem::alloc(1000, MemTag::Particles);
+    char buffer[512];
+    const int len = Mem::report(buffer, sizeof(buffer));
+    const std::string r(buffer);
+    EXPECT_EQ(int(r.size()), len);
+    for (int t=0;t<int(MemTag::Count);++t) {
+        EXPECT_NE(r.find(std::string(Mem::name(MemTag(t))) + " "), std::string::npos) << Mem::name(MemTag(t));
+    }
+    const auto s = Mem::stats(MemTag::Particles);
+    EXPECT_NE(r.find("particles " + std::to_string(s.current) + " " + std::to_string(s.peak)), std::string::npos);
+    Mem::free(p);
+
+    // a short buffer is cut, never overrun
+    char small[16];
+    memset(small, 'x', sizeof(small));
+    const int n = Mem::report(small, 10);
+    EXPECT_EQ(n, 9);
+    EXPECT_EQ(small[9], 0);
+    EXPECT_EQ(small[10], 'x');
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <painter.hpp>
+#include <cmath>
+#include <map>
+#include <vector>
+
+using namespace Neopixel;
+using Index = CoordMap::Index;
+
+namespace
+{
+// 8 lines of 16 pixels, every other line reversed
+Subset grid[] = {{0,16,1},{16,16,-1},{32,16,1},{48,16,-1},{64,16,1},{80,16,-1},{96,16,1},{112,16,-1}};
+// the app tree, lines of 22..28 pixels
+Subset tree[] = {{0,28,1},{29,27,-1},{57,28,1},{86,26,-1},{113,28,1},{142,28,-1},{171,28,1},{200,28,-1},
+                 {229,27,1},{257,27,-1},{285,27,1},{313,28,-1},{342,28,1},{371,28,-1},{402,22,1},{425,22,-1}};
+
+struct Fixture
+{
+    template <size_t N>
+    explicit Fixture(Subset (&su)[N]) : strips(makeStrips(su)), map(CoordMap::acquire(strips)), painter(map) {}
+    ~Fixture()
+    {
+        CoordMap::release(map);
+        release(strips);
+    }
+    Strips *strips;
+    const CoordMap *map;
+    Painter painter;
+};
+using Coverage = std::map<int,uint32_t>;
+auto collect(Coverage& c)
+{
+    return [&c](auto i, uint32_t w) { c[int(i)] += w; };
+}
+uint32_t total(const Coverage& c)
+{
+    uint32_t sum = 0;
+    for (auto [i, w] : c) sum += w;
+    return sum;
+}
+}
+
+TEST(Painter, sqrt_32b)
+{
+    for (uint32_t v=0;v<100000;++v) ASSERT_EQ(sqrt_32b(v), uint32_t(std::sqrt(double(v)))) << v;
+    for (uint32_t r : {65535u, 46340u, 40000u, 12345u})
+    {
+        EXPECT_EQ(sqrt_32b(r * r), r);
+        EXPECT_EQ(sqrt_32b(r * r - 1), r - 1);
+    }
+    EXPECT_EQ(sqrt_32b(0xffffffffu), 65535);
+}
+TEST(Painter, point_is_exact_bilinear)
+{
+    Fixture f(grid);
+    // on a pixel : the pixel alone at full scale
+    for (Index p=0;p<128;p+=7)
+    {
+        Coverage c;
+        f.painter.point(f.map->x(p), f.map->y(p), collect(c));
+        ASSERT_EQ(c.size(), 1u) << p;
+        EXPECT_EQ(c.begin()->first, p);
+        EXPECT_EQ(c.begin()->second, 256u);
+    }
+    // between pixels : the product of the two fractions, summing to 256
+    for (int x=0;x<=7*256;x+=37)
+    {
+        for (int y=0;y<=15*256;y+=53)
+        {
+            Coverage c;
+            f.painter.point(x, y, collect(c));
+            ASSERT_LE(c.size(), 4u);
+            ASSERT_EQ(total(c), 256u) << x << "," << y;
+            for (auto [i, w] : c)
+            {
+                const double wx = 1 - std::abs(f.map->x(Index(i)) - x) / 256.0;
+                const double wy = 1 - std::abs(f.map->y(Index(i)) - y) / 256.0;
+                EXPECT_NEAR(w, 256 * wx * wy, 1.01) << x << "," << y << " pixel " << i;
+            }
+        }
+    }
+    // a point half off the layout keeps the half inside
+    Coverage c;
+    f.painter.point(7 * 256 + 128, 3 * 256, collect(c));
+    EXPECT_EQ(total(c), 128u);
+    c.clear();
+    f.painter.point(-300, 3 * 256, collect(c));
+    EXPECT_TRUE(c.empty());
+}
+TEST(Painter, line_across_the_lines_keeps_its_length)
+{
+    Fixture f(tree);
+    // one splat per line, the end lines half covered by a segment ending on them
+    Coverage c;
+    f.painter.line(0, 10 * 256, 15 * 256, 10 * 256, collect(c));
+    EXPECT_EQ(total(c), 15u * 256);
+    for (int l=0;l<16;++l)
+    {
+        uint32_t sum = 0;
+        for (auto [i, w] : c) if (f.map->line(Index(i)) == l) sum += w;
+        EXPECT_EQ(sum, l == 0 || l == 15 ? 128u : 256u) << l;
+    }
+    // slanted, the coverage integrates to the extent along x whatever the direction
+    for (auto [x0, y0, x1, y1] : {std::tuple{300, 500, 3000, 2000}, {3000, 2000, 300, 500}, {260, 3000, 3500, 100}})
+    {
+        c.clear();
+        f.painter.line(x0, y0, x1, y1, collect(c));
+        EXPECT_EQ(total(c), uint32_t(std::abs(x1 - x0)));
+        for (auto [i, w] : c)
+        {
+            const double x = f.map->x(Index(i));
+            const double y = y0 + (x - x0) * (y1 - y0) / double(x1 - x0);
+            // at most a line pitch away along the line
+            const int l = int(x) >> 8;
+            const double pitch = 256.0 * (f.map->longest - 1) / (f.strips->element[l].count - 1);
+            EXPECT_LT(std::abs(f.map->y(Index(i)) - y), pitch + 1) << i;
+        }
+    }
+}
+TEST(Painter, line_along_a_line)
+{
+    Fixture f(grid);
+    // on line 2 from pixel 3 to pixel 9 : the inner pixels full, the end pixels half
+    Coverage c;
+    f.painter.line(2 * 256, 3 * 256, 2 * 256, 9 * 256, collect(c));
+    ASSERT_EQ(c.size(), 7u);
+    for (int j=3;j<=9;++j) EXPECT_EQ(c[f.map->row(2)[j]], j == 3 || j == 9 ? 128u : 256u) << j;
+
+    // halfway between two lines, split evenly
+    c.clear();
+    f.painter.line(2 * 256 + 128, 9 * 256, 2 * 256 + 128, 3 * 256, collect(c));
+    EXPECT_EQ(c.size(), 14u);
+    EXPECT_EQ(c[f.map->row(3)[5]], 128u);
+    EXPECT_EQ(c[f.map->row(2)[5]], 128u);
+    EXPECT_EQ(total(c), 6u * 256);
+
+    // steep : per row of pixels the coverage sums to one pixel
+    c.clear();
+    f.painter.line(256, 256, 3 * 256, 14 * 256, collect(c));
+    for (int j=2;j<=13;++j)
+    {
+        uint32_t sum = 0;
+        for (int l=0;l<8;++l) if (c.count(f.map->row(l)[j])) sum += c[f.map->row(l)[j]];
+        EXPECT_NEAR(sum, 256, 2) << j;
+    }
+}
+TEST(Painter, circles)
+{
+    Fixture f(grid);
+    const int cx = 3 * 256 + 100, cy = 7 * 256 + 40, r = 3 * 256;
+    Coverage disc, ring;
+    f.painter.circle(cx, cy, r, true, collect(disc));
+    f.painter.circle(cx, cy, r, false, collect(ring));
+    for (Index p=0;p<128;++p)
+    {
+        const double d = std::hypot(f.map->x(p) - cx, f.map->y(p) - cy);
+        const uint32_t inDisc = disc.count(p) ? disc[p] : 0;
+        const uint32_t onRing = ring.count(p) ? ring[p] : 0;
+        if (d <= r - 128) EXPECT_EQ(inDisc, 256u) << p;
+        else if (d >= r + 128) EXPECT_EQ(inDisc, 0u) << p;
+        else EXPECT_NEAR(inDisc, r + 128 - d, 1.5) << p;
+        EXPECT_NEAR(onRing, std::max(0.0, 256 - std::abs(d - r)), 1.5) << p;
+    }
+    // area within the disc
+    EXPECT_NEAR(total(disc) / 256.0, M_PI * 9, 2);
+}
+TEST(Painter, added_to_pixels_saturating)
+{
+    Fixture f(grid);
+    std::vector<RGB> px(128, RGB{0, 0, 200});
+    const Index p = f.map->row(4)[6];
+    f.painter.point(px.data(), f.map->x(p), f.map->y(p), {100, 0, 100});
+    f.painter.point(px.data(), f.map->x(p), f.map->y(p), {100, 0, 100});
+    EXPECT_EQ(px[p].r, 200);
+    EXPECT_EQ(px[p].b, 255);
+    EXPECT_EQ(px[p + 1].r, 0);
+
+    f.painter.line(px.data(), 0, 0, 7 * 256, 0, {0, 255, 0});
+    EXPECT_EQ(px[f.map->row(3)[0]].g, 255);
+    EXPECT_EQ(px[f.map->row(0)[0]].g, 127);
+    f.painter.circle(px.data(), 6 * 256, 12 * 256, 256, true, {0, 40, 0});
+    EXPECT_EQ(px[f.map->row(6)[12]].g, 40);
+}
+TEST(Painter, gradients)
+{
+    Fixture f(tree);
+    std::vector<RGB> px(f.map->totalPixels, RGB{1, 2, 3});
+    const RGB c0 {0, 200, 255}, c1 {255, 0, 55};
+    // across the lines : constant along every line, the ends exact
+    f.painter.linearGradient(px.data(), 256, 0, c0, 14 * 256, 0, c1);
+    for (Index p=0;p<f.map->totalPixels;++p)
+    {
+        if (f.map->x(p) == CoordMap::Unmapped)
+        {
+            EXPECT_EQ(px[p].b, 3) << p;
+            continue;
+        }
+        const double t = std::clamp((f.map->x(p) - 256) / (13.0 * 256), 0.0, 1.0);
+        EXPECT_NEAR(px[p].r, c0.r + t * (c1.r - c0.r), 1.01) << p;
+        EXPECT_NEAR(px[p].g, c0.g + t * (c1.g - c0.g), 1.01) << p;
+        EXPECT_NEAR(px[p].b, c0.b + t * (c1.b - c0.b), 1.01) << p;
+    }
+    EXPECT_EQ(px[f.map->row(0)[5]].g, c0.g);
+    EXPECT_EQ(px[f.map->row(15)[5]].g, c1.g);
+
+    const int cx = 7 * 256, cy = 13 * 256, r = 10 * 256;
+    f.painter.radialGradient(px.data(), cx, cy, r, c0, c1);
+    for (Index p=0;p<f.map->totalPixels;++p)
+    {
+        if (f.map->x(p) == CoordMap::Unmapped) continue;
+        const double t = std::min(std::hypot(f.map->x(p) - cx, f.map->y(p) - cy) / r, 1.0);
+        EXPECT_NEAR(px[p].r, c0.r + t * (c1.r - c0.r), 1.01) << p;
+        EXPECT_NEAR(px[p].g, c0.g + t * (c1.g - c0.g), 1.01) << p;
+    }
+}
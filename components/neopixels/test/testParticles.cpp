@@ -275,7 +275,7 @@ TEST(Particles, getPoint2D_neqnmax)
     EXPECT_EQ(255,ip.value[0]);
     EXPECT_EQ(1,ip.n_points);}
 
-    delete pstrips;
+    release(pstrips);
 }
 
 TEST(Particles, getPoint2D_xmax)
@@ -310,7 +310,7 @@ TEST(Particles, getPoint2D_xmax)
     EXPECT_EQ(127,ip.value[1]);
     EXPECT_EQ(2,ip.n_points);}
 
-    delete pstrips;
+    release(pstrips);
 }
 
 TEST(Particles, getPoint2D_yconst)
@@ -329,7 +329,7 @@ TEST(Particles, getPoint2D_yconst)
     EXPECT_EQ(55,ip.value[1]);
     EXPECT_EQ(2,ip.n_points);}
 
-    delete pstrips;
+    release(pstrips);
 }
 
 TEST(Particles, getPoint2D_bilinear)
@@ -356,7 +356,7 @@ TEST(Particles, getPoint2D_bilinear)
 
     EXPECT_EQ(4,ip.n_points);}
 
-    delete pstrips;
+    release(pstrips);
 }
 
 template <typename T>
@@ -539,7 +539,7 @@ TEST(Particles, create)
     EXPECT_CALL(led_strip, getLength()).Times(1).WillOnce(Return(pstrips->count));
     auto *anim = new ParticleAnimation(&led_strip,(int8_t*)pbuff-(int8_t*)buffer,buffer,pstrips,&random);
 
-    delete pstrips;
+    release(pstrips);
     delete anim;
 }
 
@@ -651,7 +651,7 @@ TEST(Particles, load_from_file)
     EXPECT_CALL(led_strip, getLength()).Times(1).WillOnce(Return(pstrips->count));
     auto *pa = new ParticleAnimation(&led_strip, datasize, pbuff, pstrips, &random);
 
-    delete pstrips;
+    release(pstrips);
     delete pa;
 }
 
@@ -669,6 +669,6 @@ TEST(Particles, load_from_buffer)
     EXPECT_CALL(led_strip, getLength()).Times(1).WillOnce(Return(pstrips->count));
     auto *pa = new ParticleAnimation(&led_strip, datasize, pbuff, pstrips, &random);
 
-    delete pstrips;
+    release(pstrips);
     delete pa;
 }
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <pixel_map.hpp>
+#include <utils.hpp>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+// physical -> buffer index through the runs
+std::vector<int> gather(const PixelMap& map, int first, int count)
+{
+    std::vector<int> out(count, -2);
+    map.forEachRun(first, count, [&](int src, int n, int offset) {
+        for (int i=0;i<n;++i) out[offset + i] = src < 0 ? -1 : src + i;
+    });
+    return out;
+}
+}
+
+TEST(PixelMap, identity_is_one_run)
+{
+    PixelMap map;
+    EXPECT_TRUE(map.identity());
+    int runs = 0;
+    map.forEachRun(10, 100, [&](int src, int n, int offset) {
+        EXPECT_EQ(src, 10);
+        EXPECT_EQ(n, 100);
+        EXPECT_EQ(offset, 0);
+        ++runs;
+    });
+    EXPECT_EQ(runs, 1);
+}
+
+TEST(PixelMap, rotation_matches_rotLeft)
+{
+    PixelMap map;
+    map.ranges[0] = {20, 30, 0};
+    map.ranges[1] = {60, 10, 0};
+    map.num_ranges = 2;
+    std::vector<int> buffer(100);
+    for (int i=0;i<100;++i) buffer[i] = i;
+    int tmp[30];
+    for (int step=0; step<35; ++step)
+    {
+        // rotLeft by one shows pixel i+1 at i
+        rotLeft(20, 30, 1, buffer.data(), tmp);
+        rotLeft(60, 10, 1, buffer.data(), tmp);
+        map.ranges[0].offset = (step + 1) % 30;
+        map.ranges[1].offset = (step + 1) % 10;
+        int runs = 0;
+        map.forEachRun(0, 100, [&](int, int, int) { ++runs; });
+        EXPECT_LE(runs, 7);     //before, 2 per range, between, 2 per range, after
+        EXPECT_EQ(gather(map, 0, 100), buffer) << step;
+    }
+}
+
+TEST(PixelMap, runs_split_at_segment_boundaries)
+{
+    PixelMap map;
+    map.ranges[0] = {0, 100, 70};
+    map.num_ranges = 1;
+    auto a = gather(map, 0, 50);
+    auto b = gather(map, 50, 50);
+    EXPECT_EQ(a[0], 70);
+    EXPECT_EQ(a[29], 99);
+    EXPECT_EQ(a[30], 0);
+    EXPECT_EQ(b[0], 20);
+    EXPECT_EQ(b[49], 69);
+}
+
+TEST(PixelMap, mirrored_and_dead_pixels)
+{
+    // 8 physical pixels : first 4 wired backwards, physical 5 is dead
+    const uint16_t remap[8] = { 3, 2, 1, 0, 4, PixelMap::Dead, 5, 6 };
+    PixelMap map;
+    map.remap = remap;
+    const std::vector<int> expected { 3, 2, 1, 0, 4, -1, 5, 6 };
+    EXPECT_EQ(gather(map, 0, 8), expected);
+    int runs = 0;
+    map.forEachRun(0, 8, [&](int, int, int) { ++runs; });
+    EXPECT_EQ(runs, 7);     //4 single mirrored pixels, 4, dead, 5..6
+}
+
+TEST(PixelMap, remap_then_rotation)
+{
+    const uint16_t remap[4] = { 3, 2, 1, 0 };
+    PixelMap map;
+    map.remap = remap;
+    map.ranges[0] = {0, 4, 1};
+    map.num_ranges = 1;
+    const std::vector<int> expected { 0, 3, 2, 1 };
+    EXPECT_EQ(gather(map, 0, 4), expected);
+}
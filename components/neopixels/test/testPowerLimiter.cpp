@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <power_limiter.hpp>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+const PowerBudget ws2811 { 5000, {18500,18500,18500}, 1000, 0 };
+}
+
+TEST(PowerLimiter, sums_per_wire_byte)
+{
+    const uint8_t wire[] = { 1,2,3, 10,20,30 };
+    uint32_t sums[3] = { 100, 0, 0 };
+    sumWireBytes(wire, 2, sums);
+    EXPECT_EQ(sums[0], 111);
+    EXPECT_EQ(sums[1], 22);
+    EXPECT_EQ(sums[2], 33);
+}
+
+TEST(PowerLimiter, rgbw_sums_white_apart)
+{
+    const uint8_t wire[] = { 1,2,3,4, 10,20,30,40 };
+    uint32_t sums[3] = {};
+    uint32_t white = 5;
+    sumWireBytes(wire, 2, sums, white);
+    EXPECT_EQ(sums[0], 11);
+    EXPECT_EQ(sums[2], 33);
+    EXPECT_EQ(white, 49);
+    // sk6812 rgbw, white led at 40mA
+    const PowerBudget sk6812 { 0, {12000,12000,12000}, 1000, 40000 };
+    const uint64_t rgb[3] = {};
+    EXPECT_EQ(estimateCurrent_mA(sk6812, rgb, 100, 100*255), 100 * 41);
+}
+
+TEST(PowerLimiter, estimate)
+{
+    // 450 pixels full white : 450 * (3 * 18.5 + 1) mA
+    const uint64_t white[3] = { 450*255, 450*255, 450*255 };
+    EXPECT_EQ(estimateCurrent_mA(ws2811, white, 450), 450 * 56.5);
+    const uint64_t black[3] = {};
+    EXPECT_EQ(estimateCurrent_mA(ws2811, black, 450), 450);
+    const uint64_t red[3] = { 450*255, 0, 0 };
+    EXPECT_EQ(estimateCurrent_mA(ws2811, red, 450), 450 * 19.5);
+}
+
+TEST(PowerLimiter, scaled_frame_fits_the_budget)
+{
+    EXPECT_EQ(powerScale(ws2811, 4999, 450), 256);
+    EXPECT_EQ(powerScale({0, {18500,18500,18500}, 1000, 0}, 100000, 450), 256);
+    for (int px : {1, 100, 255})
+    {
+        std::vector<uint8_t> wire(450*3, uint8_t(px));
+        uint32_t sums[3] = {};
+        sumWireBytes(wire.data(), 450, sums);
+        const uint64_t ch[3] = { sums[0], sums[1], sums[2] };
+        const uint32_t mA = estimateCurrent_mA(ws2811, ch, 450);
+        const uint32_t scale = powerScale(ws2811, mA, 450);
+        if (mA <= ws2811.budget_mA)
+        {
+            EXPECT_EQ(scale, 256);
+            continue;
+        }
+        scaleWireBytes(wire.data(), wire.size(), scale);
+        uint32_t after[3] = {};
+        sumWireBytes(wire.data(), 450, after);
+        const uint64_t ch2[3] = { after[0], after[1], after[2] };
+        const uint32_t limited = estimateCurrent_mA(ws2811, ch2, 450);
+        EXPECT_LE(limited, ws2811.budget_mA);
+        // uniform scale, not clipped
+        EXPECT_GT(limited, ws2811.budget_mA * 95 / 100);
+    }
+}
+
+TEST(PowerLimiter, budget_below_idle_turns_everything_off)
+{
+    EXPECT_EQ(powerScale({100, {18500,18500,18500}, 1000, 0}, 1000, 450), 0);
+}
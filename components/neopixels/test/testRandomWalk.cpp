@@ -8,6 +8,7 @@
 #include <utils.hpp>
 #include <string>
 #include <map>
+#include <vector>
 
 using namespace Neopixel;
 using namespace ::testing;
@@ -185,43 +186,92 @@ TEST(RandomWalk, calcNextPosition_nonblack)
     RandomWalkAnimation *anim = makeAnimation(su,{},led_strip,random);
 
     //position 0 : neighbours are {5,1}
-    anim->brightness[5] = 0;
-    anim->brightness[1] = 255;
+    anim->field.set(5, {}, 0);
+    anim->field.set(1, {}, 255);
     test_calcNextPosition(*anim,random,0,5,0);
     test_calcNextPosition(*anim,random,0,5,125);
     test_calcNextPosition(*anim,random,0,5,254);
 
-    anim->brightness[5] = 255;
-    anim->brightness[1] = 0;
+    anim->field.set(5, {}, 255);
+    anim->field.set(1, {}, 0);
     test_calcNextPosition(*anim,random,0,1,0);
     test_calcNextPosition(*anim,random,0,1,125);
     test_calcNextPosition(*anim,random,0,1,254);
-    anim->brightness[5] = 0;
+    anim->field.set(5, {}, 0);
 
-    anim->brightness[0] = 100;
-    anim->brightness[6] = 100;
-    anim->brightness[4] = 100;
+    anim->field.set(0, {}, 100);
+    anim->field.set(6, {}, 100);
+    anim->field.set(4, {}, 100);
     //position 5 : neighbours are {0,6,4}
     test_calcNextPosition(*anim,random,5,0,(255-100)*1-1);
     test_calcNextPosition(*anim,random,5,6,(255-100)*2-1);
     test_calcNextPosition(*anim,random,5,4,(255-100)*3-1);
-    anim->brightness[0] = 0;
-    anim->brightness[6] = 0;
-    anim->brightness[4] = 0;
+    anim->field.set(0, {}, 0);
+    anim->field.set(6, {}, 0);
+    anim->field.set(4, {}, 0);
 
     //position 4 : neighbours are  {1,5,7,3}
-    anim->brightness[1] = 20;
-    anim->brightness[5] = 50;
-    anim->brightness[7] = 100;
-    anim->brightness[3] = 200;
-    int p1 = 255 - anim->brightness[1];
-    int p5 = 255 - anim->brightness[5];
-    int p7 = 255 - anim->brightness[7];
-    int p3 = 255 - anim->brightness[3];
+    anim->field.set(1, {}, 20);
+    anim->field.set(5, {}, 50);
+    anim->field.set(7, {}, 100);
+    anim->field.set(3, {}, 200);
+    int p1 = 255 - anim->field.level(1);
+    int p5 = 255 - anim->field.level(5);
+    int p7 = 255 - anim->field.level(7);
+    int p3 = 255 - anim->field.level(3);
     test_calcNextPosition(*anim,random,4,1,p1-1);
     test_calcNextPosition(*anim,random,4,5,p1+p5-1);
     test_calcNextPosition(*anim,random,4,7,p1+p5+p7-1);
     test_calcNextPosition(*anim,random,4,3,p1+p5+p7+p3-1);
 
     delete anim;
-}
\ No newline at end of file
+}
+// 334 lines of 300, positions past 65535 have to survive the walk
+TEST(RandomWalk, wide_layout_walks_100k_pixels)
+{
+    std::vector<BasicSubset<WideLayout>> su;
+    for (int i=0;i<334;++i) {
+        su.push_back({ uint32_t(i * 300), 300, int8_t(i & 1 ? -1 : 1) });
+    }
+    auto *pstrips = makeStrips(su.data(), su.size());
+    MockLedStrip led_strip;
+    MockRandomGenerator random;
+    EXPECT_CALL(random, make_random()).Times(1).WillOnce(Return(70000));
+    auto [params,len] = encodeParams({});
+    BasicRandomWalkAnimation<WideLayout> anim(&led_strip,len,params,pstrips,&random);
+    anim.initNeighboursMatrix();
+    EXPECT_EQ(anim.totalPixels, 100200u);
+    EXPECT_EQ(anim.current_position, 70000u);
+
+    // neighbours of 70000 are {69799,70001,70399,69999}, all black
+    EXPECT_CALL(random, make_random()).Times(1).WillOnce(Return(255*2));
+    EXPECT_EQ(anim.calcNextPosition(), 70399u);
+    // top of the last line : {99600,100198}
+    anim.current_position = 100199;
+    EXPECT_CALL(random, make_random()).Times(1).WillOnce(Return(255));
+    EXPECT_EQ(anim.calcNextPosition(), 100198u);
+    release(pstrips);
+}
+TEST(RandomWalk, side_buffers_are_counted_under_its_tag)
+{
+    Subset su[] = {{0,10,1},{10,10,-1}};
+    Strips *pstrips = makeStrips(su);
+    const auto before = Mem::stats(MemTag::RandomWalk);
+    const auto layout = Mem::stats(MemTag::Layout);
+    MockLedStrip led_strip;
+    MockRandomGenerator random;
+    EXPECT_CALL(random, make_random()).Times(1).WillOnce(Return(0));
+    auto [params,len] = encodeParams({});
+    auto *anim = new RandomWalkAnimation(&led_strip,len,params,pstrips,&random);
+    // map and neighbours are taken by the constructor, step never touches the registry
+    EXPECT_NE(anim->neighbours, nullptr);
+    const auto s = Mem::stats(MemTag::RandomWalk);
+    EXPECT_EQ(s.blocks - before.blocks, 1u);
+    // decay field : cells, live list and live bits. The neighbours come with the shared coordinate map
+    EXPECT_EQ(s.current - before.current, 20u * (6 + 2) + 4);
+    EXPECT_EQ(Mem::stats(MemTag::Layout).blocks - layout.blocks, 2u);
+    delete anim;
+    EXPECT_EQ(Mem::stats(MemTag::RandomWalk).current, before.current);
+    EXPECT_EQ(Mem::stats(MemTag::Layout).current, layout.current);
+    release(pstrips);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <FireAnimation.hpp>
+#include <DigitalRainAnimation.hpp>
+#include <collections.hpp>
+#include <random.hpp>
+#include <utils.hpp>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include "recording_strip.hpp"
+
+using namespace Neopixel;
+
+namespace
+{
+uint32_t now_us = 0;
+uint32_t virtualClock() { return now_us; }
+
+// same sequence every run, so two recordings of one animation are identical
+struct LcgRandom : public RandomGenerator
+{
+    explicit LcgRandom(uint32_t seed) : state(seed) {}
+    uint32_t make_random() override
+    {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+    void make_random_n(uint32_t *values, int length) override
+    {
+        while (length-- > 0) *values++ = make_random();
+    }
+    void release() override {}
+    uint32_t state;
+};
+
+std::string tempFile(const char* name)
+{
+    return ::testing::TempDir() + name;
+}
+
+// lines all run forward, FireAnimation walks reversed lines out of their range
+struct Tree
+{
+    Tree() { Subset su[] = {{0,40,1},{40,40,1},{80,40,1},{120,30,1}}; strips = makeStrips(su); }
+    ~Tree() { release(strips); }
+    static constexpr int Leds = 150;
+    Strips* strips;
+};
+
+// runs frames steps of the animation on a recording strip, virtual time follows the animation delay
+uint64_t recordFire(const char* path, int frames, uint8_t cooling, uint32_t capacity = 4096)
+{
+    Tree tree;
+    std::unique_ptr<RecordingLedStrip> strip(RecordingLedStrip::create(path, Tree::Leds, capacity, virtualClock));
+    EXPECT_NE(strip, nullptr);
+    uint8_t params[5];
+    void *p = params;
+    encode<uint16_t>(p, 30);
+    encode<uint8_t>(p, cooling);
+    encode<uint8_t>(p, 120);
+    encode<uint8_t>(p, 1);
+    LcgRandom rnd(42);
+    FireAnimation anim(strip.get(), sizeof(params), params, tree.strips, &rnd);
+    now_us = 0;
+    for (int f=0;f<frames;++f)
+    {
+        anim.step();
+        now_us += anim.get_delay_ms() * 1000;
+    }
+    return strip->framesRecorded();
+}
+}
+
+TEST(RecordingStrip, records_every_refresh_with_timestamps)
+{
+    const auto path = tempFile("fire.npxr");
+    EXPECT_EQ(recordFire(path.c_str(), 2000, 55), 2000);
+
+    Recording rec;
+    ASSERT_TRUE(rec.open(path.c_str()));
+    EXPECT_EQ(rec.numPixels(), Tree::Leds);
+    ASSERT_EQ(rec.frames(), 2000);
+    int lit = 0;
+    for (int f=0;f<rec.frames();++f)
+    {
+        const auto fr = rec.frame(f);
+        EXPECT_EQ(fr.seq, uint32_t(f));
+        EXPECT_EQ(fr.t_us, uint32_t(f) * 30000);
+        for (int i=0;i<Tree::Leds;++i) lit += fr.pixels[i].r > 0;
+    }
+    EXPECT_GT(lit, 0);  //the fire did burn
+    std::remove(path.c_str());
+}
+
+TEST(RecordingStrip, same_run_diffs_clean_changed_parameter_does_not)
+{
+    const auto a = tempFile("fire_a.npxr"), b = tempFile("fire_b.npxr"), c = tempFile("fire_c.npxr");
+    recordFire(a.c_str(), 500, 55);
+    recordFire(b.c_str(), 500, 55);
+    recordFire(c.c_str(), 500, 90);
+    Recording ra, rb, rc;
+    ASSERT_TRUE(ra.open(a.c_str()) && rb.open(b.c_str()) && rc.open(c.c_str()));
+
+    const auto same = diffRecordings(ra, rb);
+    EXPECT_EQ(same.frames_compared, 500);
+    EXPECT_EQ(same.differing_frames, 0);
+    EXPECT_EQ(same.first_difference, -1);
+    EXPECT_FALSE(same.size_mismatch);
+
+    const auto changed = diffRecordings(ra, rc);
+    EXPECT_GT(changed.differing_frames, 0);
+    EXPECT_GE(changed.first_difference, 0);
+    EXPECT_GT(changed.differing_pixels, 0u);
+    EXPECT_GT(changed.max_delta, 0);
+    for (auto & s : {a, b, c}) std::remove(s.c_str());
+}
+
+TEST(RecordingStrip, ring_keeps_the_newest_frames)
+{
+    const auto path = tempFile("ring.npxr");
+    {
+        std::unique_ptr<RecordingLedStrip> strip(RecordingLedStrip::create(path.c_str(), 3, 10, virtualClock));
+        for (int f=0;f<25;++f)
+        {
+            now_us = f * 100;
+            strip->fillPixelsRGB(0, 3, {uint8_t(f), 0, uint8_t(255 - f)});
+            strip->refresh();
+        }
+        EXPECT_EQ(strip->framesRecorded(), 25);
+    }
+    Recording rec;
+    ASSERT_TRUE(rec.open(path.c_str()));
+    ASSERT_EQ(rec.frames(), 10);
+    for (int i=0;i<10;++i)
+    {
+        const auto fr = rec.frame(i);
+        EXPECT_EQ(fr.seq, uint32_t(15 + i));
+        EXPECT_EQ(fr.t_us, uint32_t(15 + i) * 100);
+        EXPECT_EQ(fr.pixels[2].r, 15 + i);
+        EXPECT_EQ(fr.pixels[2].b, 255 - 15 - i);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(RecordingStrip, replay_reproduces_the_recording)
+{
+    const auto src = tempFile("rain.npxr"), dst = tempFile("rain_replay.npxr");
+    {
+        Tree tree;
+        std::unique_ptr<RecordingLedStrip> strip(RecordingLedStrip::create(src.c_str(), Tree::Leds, 1000, virtualClock));
+        LcgRandom rnd(7);
+        uint8_t params[2];
+        void *p = params;
+        encode<uint16_t>(p, 80);
+        DigitalRainAnimation anim(strip.get(), sizeof(params), params, tree.strips, &rnd);
+        now_us = 0;
+        for (int f=0;f<300;++f)
+        {
+            anim.step();
+            now_us += anim.get_delay_ms() * 1000;
+        }
+    }
+    Recording rec;
+    ASSERT_TRUE(rec.open(src.c_str()));
+    uint64_t waited = 0;
+    static uint64_t *waited_p;
+    waited_p = &waited;
+    {
+        now_us = 0;
+        std::unique_ptr<RecordingLedStrip> out(RecordingLedStrip::create(dst.c_str(), Tree::Leds, 1000, virtualClock));
+        EXPECT_EQ(replay(rec, out.get(), [](uint32_t us) { *waited_p += us; now_us += us; }), 300);
+    }
+    EXPECT_EQ(waited, 299u * 80000);
+    Recording copy;
+    ASSERT_TRUE(copy.open(dst.c_str()));
+    EXPECT_EQ(diffRecordings(rec, copy).differing_frames, 0);
+    EXPECT_EQ(copy.frame(299).t_us, rec.frame(299).t_us);
+    std::remove(src.c_str());
+    std::remove(dst.c_str());
+}
+
+TEST(RecordingStrip, rejects_foreign_files)
+{
+    const auto path = tempFile("not_a_recording.npxr");
+    FILE *f = std::fopen(path.c_str(), "wb");
+    std::fputs("definitely not a ring file header", f);
+    std::fclose(f);
+    Recording rec;
+    EXPECT_FALSE(rec.open(path.c_str()));
+    EXPECT_FALSE(rec.open("/nonexistent/dir/x.npxr"));
+    EXPECT_EQ(rec.frames(), 0);
+    EXPECT_EQ(RecordingLedStrip::create("/nonexistent/dir/x.npxr", 10, 10), nullptr);
+    std::remove(path.c_str());
+}
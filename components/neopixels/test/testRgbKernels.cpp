@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <rgb_kernels.hpp>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace Neopixel;
+
+namespace
+{
+// enough pixels for every (dst, src) byte pair : byte b holds dst b & 0xff against src b >> 8
+constexpr int PairPixels = (65536 + 2) / 3;
+
+using Scalar = std::function<uint8_t(uint8_t d, uint8_t s, int channel)>;
+using Kernel = std::function<void(RGB* dst, const RGB* src, int count)>;
+
+std::vector<RGB> pairDst()
+{
+    std::vector<RGB> v(PairPixels);
+    auto *b = reinterpret_cast<uint8_t*>(v.data());
+    for (int i=0;i<3*PairPixels;++i) b[i] = uint8_t(i);
+    return v;
+}
+std::vector<RGB> pairSrc()
+{
+    std::vector<RGB> v(PairPixels);
+    auto *b = reinterpret_cast<uint8_t*>(v.data());
+    for (int i=0;i<3*PairPixels;++i) b[i] = uint8_t(i >> 8);
+    return v;
+}
+// all byte pairs, then short spans at every byte alignment to cover the word and register tails
+int mismatches(const Kernel& kernel, const Scalar& scalar)
+{
+    int bad = 0;
+    auto d = pairDst();
+    const auto s = pairSrc();
+    kernel(d.data(), s.data(), PairPixels);
+    const auto *db = reinterpret_cast<const uint8_t*>(d.data());
+    for (int i=0;i<3*PairPixels;++i) bad += db[i] != scalar(uint8_t(i), uint8_t(i >> 8), i % 3);
+
+    std::mt19937 rng(7);
+    std::vector<RGB> src(64), dst(64), ref(64);
+    for (int offset=0;offset<16;++offset)
+    {
+        for (int count=0;count+offset<=48;++count)
+        {
+            for (auto & p : src) p = { uint8_t(rng()), uint8_t(rng()), uint8_t(rng()) };
+            for (auto & p : dst) p = { uint8_t(rng()), uint8_t(rng()), uint8_t(rng()) };
+            ref = dst;
+            kernel(dst.data() + offset, src.data() + offset, count);
+            const auto *o = reinterpret_cast<const uint8_t*>(dst.data());
+            const auto *r = reinterpret_cast<const uint8_t*>(ref.data());
+            const auto *sb = reinterpret_cast<const uint8_t*>(src.data());
+            for (int i=0;i<3*64;++i)
+            {
+                const bool inside = i >= 3 * offset && i < 3 * (offset + count);
+                bad += o[i] != (inside ? scalar(r[i], sb[i], i % 3) : r[i]);
+            }
+        }
+    }
+    return bad;
+}
+}
+
+TEST(RgbKernels, fade_matches_scale8)
+{
+    for (int scale=0;scale<256;++scale)
+    {
+        const int bad = mismatches(
+            [&](RGB* d, const RGB*, int n) { fade8(d, n, uint8_t(scale)); },
+            [&](uint8_t d, uint8_t, int) { RGB p {d,d,d}; p.scale8(uint8_t(scale)); return p.r; });
+        ASSERT_EQ(bad, 0) << "scale " << scale;
+    }
+    // the byte overload used for brightness maps
+    std::vector<uint8_t> v(37);
+    for (int i=0;i<37;++i) v[i] = uint8_t(i * 7);
+    fade8(v.data(), 37, 200);
+    for (int i=0;i<37;++i) EXPECT_EQ(v[i], uint8_t(i * 7 * 201 >> 8));
+}
+
+TEST(RgbKernels, scale_per_channel)
+{
+    for (RGB f : {RGB{0,0,0}, RGB{255,255,255}, RGB{255,128,0}, RGB{17,200,99}})
+    {
+        const uint8_t fc[3] = {f.r, f.g, f.b};
+        const int bad = mismatches(
+            [&](RGB* d, const RGB*, int n) { scale8(d, n, f); },
+            [&](uint8_t d, uint8_t, int k) { return uint8_t(d * (fc[k] + 1) >> 8); });
+        EXPECT_EQ(bad, 0) << int(f.r) << ' ' << int(f.g) << ' ' << int(f.b);
+    }
+}
+
+TEST(RgbKernels, saturating_add)
+{
+    EXPECT_EQ(mismatches(add8, [](uint8_t d, uint8_t s, int) { return sat_add({d,d,d}, {s,s,s}).r; }), 0);
+}
+
+TEST(RgbKernels, mix_matches_RGB_mix)
+{
+    for (int alpha=0;alpha<256;++alpha)
+    {
+        const int bad = mismatches(
+            [&](RGB* d, const RGB* s, int n) { mix8(d, s, n, uint8_t(alpha)); },
+            [&](uint8_t d, uint8_t s, int) { return RGB{d,d,d}.mix({s,s,s}, uint8_t(alpha)).r; });
+        ASSERT_EQ(bad, 0) << "alpha " << alpha;
+    }
+}
+
+TEST(RgbKernels, mix_toward_a_color)
+{
+    const RGB color {250, 3, 128};
+    const uint8_t cc[3] = {color.r, color.g, color.b};
+    for (int alpha : {0, 1, 100, 128, 254, 255})
+    {
+        const int bad = mismatches(
+            [&](RGB* d, const RGB*, int n) { mix8(d, n, color, uint8_t(alpha)); },
+            [&](uint8_t d, uint8_t, int k) { return RGB{d,d,d}.mix({cc[k],cc[k],cc[k]}, uint8_t(alpha)).r; });
+        EXPECT_EQ(bad, 0) << "alpha " << alpha;
+    }
+}
+
+TEST(RgbKernels, max_multiply_screen)
+{
+    EXPECT_EQ(mismatches(max8, [](uint8_t d, uint8_t s, int) { return d > s ? d : s; }), 0);
+    EXPECT_EQ(mismatches(multiply8, [](uint8_t d, uint8_t s, int) { return uint8_t(d * (s + 1) >> 8); }), 0);
+    EXPECT_EQ(mismatches(screen8, [](uint8_t d, uint8_t s, int) { return uint8_t(255 - ((255 - d) * (256 - s) >> 8)); }), 0);
+    // full scale stays full scale, black is neutral for screen
+    RGB d[1] = {{255, 0, 77}}, s[1] = {{255, 0, 0}};
+    screen8(d, s, 1);
+    EXPECT_EQ(d[0].r, 255);
+    EXPECT_EQ(d[0].g, 0);
+    EXPECT_EQ(d[0].b, 77);
+}
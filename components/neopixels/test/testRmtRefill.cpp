@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <rmt_translator.hpp>
+#include <rmt_refill.hpp>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+
+using namespace NeopixelDrv;
+
+namespace
+{
+const uint32_t Bit0 = makeRmtItem(20, 1, 80, 0);
+const uint32_t Bit1 = makeRmtItem(48, 1, 52, 0);
+constexpr uint32_t ItemNs = 2500;           //ws2811 bit
+constexpr size_t MemItems = 8 * 64;         //mem_block_num = 8
+constexpr size_t Half = MemItems / 2;
+constexpr uint32_t HalfNs = Half * ItemNs;
+
+/* Host model of the RMT ping-pong refill : the hardware reads one item of the channel memory
+** every ItemNs, the threshold interrupt fires every Half items and the isr refills the half
+** just sent after the injected delay. Items read before their refill landed are stale, tracked
+** by item index since a stale item can still hold the right bit */
+struct RmtSim
+{
+    RmtSim() { translator.init(Bit0, Bit1); }
+
+    // @returns number of stale items sent
+    int run(const std::vector<uint8_t>& data, const std::vector<uint32_t>& isr_delay_ns, uint32_t t0 = 1000)
+    {
+        std::vector<uint32_t> expected(data.size() * 8);
+        size_t tsz, n;
+        translator.translate(data.data(), expected.data(), data.size(), expected.size(), &tsz, &n);
+
+        std::vector<uint32_t> mem(MemItems, 0);
+        std::vector<size_t> slot_item(MemItems);
+        for (size_t i=0;i<MemItems;++i) slot_item[i] = i;
+        monitor.frameStart(expected.size());
+        translator.translate(data.data(), mem.data(), data.size(), MemItems, &tsz, &n);
+        monitor.onTranslate(t0);
+        size_t src_pos = tsz;
+
+        int stale = 0;
+        uint64_t refill_ns = 0;
+        size_t k = 0;
+        for (size_t j=0;j<expected.size();++j)
+        {
+            const uint64_t read_ns = uint64_t(j) * ItemNs;
+            // refills that landed before the hardware reads item j
+            while (src_pos < data.size())
+            {
+                const uint64_t event_ns = uint64_t(k + 1) * HalfNs;
+                const uint32_t delay = k < isr_delay_ns.size() ? isr_delay_ns[k] : 0;
+                // the isr runs refills one after another
+                const uint64_t at = std::max(event_ns + delay, refill_ns);
+                if (at > read_ns) break;
+                uint32_t *half = mem.data() + (k % 2) * Half;
+                translator.translate(data.data() + src_pos, half, data.size() - src_pos, Half, &tsz, &n);
+                std::fill(half + n, half + Half, 0);
+                for (size_t i=0;i<Half;++i) slot_item[(k % 2) * Half + i] = (k + 2) * Half + i;
+                src_pos += tsz;
+                monitor.onTranslate(uint32_t(t0 + at));
+                refill_ns = at;
+                ++k;
+            }
+            if (slot_item[j % MemItems] != j) ++stale;
+            else EXPECT_EQ(mem[j % MemItems], expected[j]);
+        }
+        monitor.frameEnd();
+        return stale;
+    }
+
+    RmtTranslator translator;
+    RefillMonitor monitor;
+};
+
+std::vector<uint8_t> makeFrame(size_t bytes)
+{
+    std::vector<uint8_t> frame(bytes);
+    for (size_t i=0;i<bytes;++i) frame[i] = uint8_t(i * 37 + 11);
+    return frame;
+}
+}
+
+class RmtRefill : public ::testing::Test
+{
+protected:
+    void SetUp() override { sim.monitor.init(ItemNs, MemItems); }
+    RmtSim sim;
+    const std::vector<uint8_t> frame = makeFrame(447 * 3);
+    // items after the initial fill, one refill per half
+    const uint32_t refills = (frame.size() * 8 - MemItems + Half - 1) / Half;
+};
+
+TEST_F(RmtRefill, on_time_refills)
+{
+    EXPECT_EQ(sim.run(frame, {}), 0);
+    const auto & st = sim.monitor.stats;
+    EXPECT_EQ(st.frames, 1);
+    EXPECT_EQ(st.refills, refills);
+    EXPECT_EQ(st.underruns, 0);
+    EXPECT_EQ(st.glitched_frames, 0);
+    EXPECT_EQ(st.max_latency_ns, 0);
+}
+TEST_F(RmtRefill, frame_within_memory_needs_no_refill)
+{
+    EXPECT_EQ(sim.run(makeFrame(MemItems / 8), {}), 0);
+    EXPECT_EQ(sim.monitor.stats.refills, 0);
+    EXPECT_EQ(sim.monitor.stats.underruns, 0);
+}
+TEST_F(RmtRefill, delay_within_slack_is_reported_not_counted)
+{
+    std::vector<uint32_t> delays(refills, 0);
+    delays[3] = HalfNs;
+    delays[7] = HalfNs / 2;
+    EXPECT_EQ(sim.run(frame, delays), 0);
+    const auto & st = sim.monitor.stats;
+    EXPECT_EQ(st.underruns, 0);
+    EXPECT_EQ(st.max_latency_ns, HalfNs);
+    EXPECT_EQ(st.frame_latency_ns, HalfNs);
+}
+TEST_F(RmtRefill, late_refill_detected_as_underrun)
+{
+    std::vector<uint32_t> delays(refills, 0);
+    delays[5] = HalfNs + 4 * ItemNs;
+    EXPECT_EQ(sim.run(frame, delays), 4);
+    const auto & st = sim.monitor.stats;
+    EXPECT_EQ(st.underruns, 1);
+    EXPECT_EQ(st.glitched_frames, 1);
+    EXPECT_EQ(st.frame_latency_ns, HalfNs + 4 * ItemNs);
+
+    // next frame clean, the worst case is kept
+    EXPECT_EQ(sim.run(frame, {}), 0);
+    EXPECT_EQ(st.frames, 2);
+    EXPECT_EQ(st.glitched_frames, 1);
+    EXPECT_EQ(st.frame_latency_ns, 0);
+    EXPECT_EQ(st.max_latency_ns, HalfNs + 4 * ItemNs);
+}
+TEST_F(RmtRefill, frame_ending_before_a_refill_counts_it)
+{
+    // the last refill only lands after the hardware is done with the frame
+    std::vector<uint32_t> delays(refills, 0);
+    delays.back() = 4 * HalfNs;
+    EXPECT_GT(sim.run(frame, delays), 0);
+    EXPECT_EQ(sim.monitor.stats.refills, refills - 1);
+    EXPECT_EQ(sim.monitor.stats.underruns, 1);
+    EXPECT_EQ(sim.monitor.stats.glitched_frames, 1);
+    // a late call after tx end is not taken for the next frame
+    sim.monitor.onTranslate(0);
+    EXPECT_EQ(sim.monitor.stats.refills, refills - 1);
+}
+TEST_F(RmtRefill, detection_survives_clock_wrap)
+{
+    std::vector<uint32_t> delays(refills, 0);
+    delays[2] = 2 * HalfNs;
+    EXPECT_GT(sim.run(frame, delays, 0xffffffff - 3 * HalfNs), 0);
+    EXPECT_EQ(sim.monitor.stats.underruns, 1);
+    EXPECT_EQ(sim.monitor.stats.max_latency_ns, 2 * HalfNs);
+}
+TEST_F(RmtRefill, detection_matches_glitches_under_bursty_latency)
+{
+    // wifi like : mostly quick isr entry, occasional long bursts
+    std::mt19937 rnd(1234);
+    std::uniform_int_distribution<uint32_t> burst(0, 19), isr(0, 20000), stall(0, 2 * HalfNs);
+    uint32_t glitched = 0;
+    for (int f=0;f<200;++f)
+    {
+        std::vector<uint32_t> delays(refills);
+        for (auto & d : delays) {
+            d = burst(rnd) == 0 ? stall(rnd) : isr(rnd);
+        }
+        const uint32_t before = sim.monitor.stats.underruns;
+        const int stale = sim.run(frame, delays);
+        EXPECT_EQ(stale > 0, sim.monitor.stats.underruns > before) << "frame " << f;
+        glitched += stale > 0;
+    }
+    EXPECT_GT(glitched, 0);
+    EXPECT_EQ(sim.monitor.stats.glitched_frames, glitched);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <rmt_translator.hpp>
+#include <vector>
+#include <cstdint>
+
+using namespace NeopixelDrv;
+
+namespace
+{
+// 40MHz counter clock, ws2811 timing
+const uint32_t Bit0 = makeRmtItem(20, 1, 80, 0);
+const uint32_t Bit1 = makeRmtItem(48, 1, 52, 0);
+
+std::vector<uint8_t> decodeItems(const uint32_t* items, size_t n_items)
+{
+    std::vector<uint8_t> bytes;
+    for (size_t i=0; i+8 <= n_items; i+=8)
+    {
+        uint8_t v = 0;
+        for (int b=0;b<8;++b)
+        {
+            const auto item = items[i+b];
+            EXPECT_TRUE(item == Bit0 || item == Bit1);
+            v = (v << 1) | (item == Bit1 ? 1 : 0);
+        }
+        bytes.push_back(v);
+    }
+    return bytes;
+}
+}
+
+TEST(RmtTranslator, makeRmtItem)
+{
+    const auto item = makeRmtItem(20, 1, 80, 0);
+    EXPECT_EQ(item & 0x7FFF, 20);
+    EXPECT_EQ((item >> 15) & 1, 1);
+    EXPECT_EQ((item >> 16) & 0x7FFF, 80);
+    EXPECT_EQ(item >> 31, 0);
+}
+
+TEST(RmtTranslator, table)
+{
+    static RmtTranslator tr;
+    tr.init(Bit0, Bit1);
+    EXPECT_EQ(tr.table[0x00][0], Bit0);
+    EXPECT_EQ(tr.table[0xFF][7], Bit1);
+    EXPECT_EQ(tr.table[0x80][0], Bit1);
+    EXPECT_EQ(tr.table[0x80][1], Bit0);
+    EXPECT_EQ(tr.table[0x01][7], Bit1);
+    EXPECT_EQ(tr.table[0x01][6], Bit0);
+}
+
+TEST(RmtTranslator, roundtrip_all_bytes)
+{
+    static RmtTranslator tr;
+    tr.init(Bit0, Bit1);
+    uint8_t src[256];
+    for (int i=0;i<256;++i) src[i] = uint8_t(i);
+    std::vector<uint32_t> items(256*8);
+    size_t translated = 0, num = 0;
+    tr.translate(src, items.data(), sizeof(src), items.size(), &translated, &num);
+    EXPECT_EQ(translated, 256);
+    EXPECT_EQ(num, 256*8);
+    auto bytes = decodeItems(items.data(), num);
+    ASSERT_EQ(bytes.size(), 256);
+    for (int i=0;i<256;++i) {
+        EXPECT_EQ(bytes[i], src[i]);
+    }
+}
+
+TEST(RmtTranslator, partial_refill)
+{
+    // mimics the rmt driver asking for half a memory block at a time
+    static RmtTranslator tr;
+    tr.init(Bit0, Bit1);
+    uint8_t src[450*3];
+    for (size_t i=0;i<sizeof(src);++i) src[i] = uint8_t(i*7+3);
+
+    std::vector<uint32_t> items;
+    uint32_t block[32];
+    size_t offset = 0;
+    while (offset < sizeof(src))
+    {
+        size_t translated = 0, num = 0;
+        tr.translate(src + offset, block, sizeof(src) - offset, 32, &translated, &num);
+        ASSERT_GT(translated, 0);
+        ASSERT_LE(num, 32);
+        items.insert(items.end(), block, block + num);
+        offset += translated;
+    }
+    auto bytes = decodeItems(items.data(), items.size());
+    ASSERT_EQ(bytes.size(), sizeof(src));
+    for (size_t i=0;i<sizeof(src);++i) {
+        EXPECT_EQ(bytes[i], src[i]);
+    }
+}
+
+TEST(RmtTranslator, null_input)
+{
+    static RmtTranslator tr;
+    tr.init(Bit0, Bit1);
+    uint32_t items[8];
+    size_t translated = 1, num = 1;
+    tr.translate(nullptr, items, 1, 8, &translated, &num);
+    EXPECT_EQ(translated, 0);
+    EXPECT_EQ(num, 0);
+}
@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+#include <strip_arena.hpp>
+#include <cstdint>
+
+using namespace Neopixel;
+
+TEST(StripArena, new_strip_is_built_beside_the_running_one)
+{
+    StripArena arena;
+    ASSERT_TRUE(arena.init(1000));
+    EXPECT_GE(arena.regionBytes(), 1000u);
+    void *running = arena.active();
+    void *next = arena.idle(800);
+    ASSERT_NE(next, nullptr);
+    EXPECT_NE(next, running);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(next) % 8, 0u);
+    // the regions do not overlap, the old strip stays intact while the new one is laid out
+    const auto gap = reinterpret_cast<uint8_t*>(next) - reinterpret_cast<uint8_t*>(running);
+    EXPECT_GE(gap < 0 ? -gap : gap, 1000);
+    arena.swap();
+    EXPECT_EQ(arena.active(), next);
+    // ping-pong, the next reconfigure reuses the first region
+    EXPECT_EQ(arena.idle(800), running);
+    arena.release();
+}
+
+TEST(StripArena, strip_larger_than_a_region_is_refused)
+{
+    StripArena arena;
+    ASSERT_TRUE(arena.init(512));
+    EXPECT_EQ(arena.idle(arena.regionBytes() + 1), nullptr);
+    EXPECT_NE(arena.idle(arena.regionBytes()), nullptr);
+    arena.release();
+}
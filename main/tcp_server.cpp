@@ -15,6 +15,7 @@
 #include "lwip/sys.h"
 #include <lwip/netdb.h>
 #include <neopixel_app.h>
+#include <mem_tracker.hpp>
 
 #define PORT                        1234
 #define KEEPALIVE_IDLE              30
@@ -98,6 +99,14 @@ static void handle_incomming_data(int sock, esp_event_loop_handle_t loop_handle)
             ESP_LOGE(TAG, "Error occurred during receiving: errno %d", errno);
         } else if (nbytes == 0) {
             ESP_LOGW(TAG, "Connection closed");
+        } else if (rx_buffer[0] == NeopixelApp::CmdMemoryReport)
+        {
+            // answered here, the event loop has no way back to the socket
+            char report[512];
+            const int len = Neopixel::Mem::report(report, sizeof(report));
+            if (send(sock, report, len, 0) < 0) {
+                ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+            }
         } else 
         {
             ESP_ERROR_CHECK(esp_event_post_to(loop_handle, NeopixelApp::NEOPIXEL_EVENTS, 0, rx_buffer, nbytes, portMAX_DELAY));